@@ -8,163 +8,408 @@
 #include <iostream>
 #include <cstdio>
 #include "graphdb.h"
+#include "csrgraph.h"
+#include "diskgraph.h"
+#include "cliquepartition.h"
+#include "components.h"
+#include "batch.h"
+#include "incremental.h"
+#include "partitioncache.h"
+#include "lowerbound.h"
+#include "portfolio.h"
+#include "refine.h"
 #include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
 #include <map>
-#include <limits>
-#include <assert.h>
-
-void TsengAlgorithm (const graphDatabaseClass& g,
-                     std::vector<graphDatabaseClass::vertexKeyT>& cliques
-                     )
-{
-    graphDatabaseClass gPrime(g); // work on copy
-    cliques.clear();
-	int loops = 0;
-	while (gPrime.numEdges() > 0) {
-		if (noisy()) {
-			printf("TsengAlgorithm(): Loop %i\n", ++loops);
-			gPrime.checkGraph();
-			gPrime.writeGraph(stdout);
-		}
-        graphDatabaseClass::vertexKeyT si, sj, newVertexKey;
-        graphDatabaseClass::verticiesT::iterator sitr;
-        std::vector<graphDatabaseClass::vertexKeyT> commonNeighbors;
-        //
-        // Find two verticies with most common neighboers. In case of tie, take
-        // verticies with maximum sum of degrees
-        //
-        int sumOfDegrees = -1;
-        int mostCommons = -1;
-        bool foundNewVertex = false;
-        for(sitr=gPrime.verticies.begin(); sitr != gPrime.verticies.end(); ++sitr) {
-            for(auto e = sitr->second.edgeList; e != nullptr; e = e->next) {
-                gPrime.commonNeighbor(sitr->first, e->vertexID, commonNeighbors);
-                int testSumOfDegrees = sitr->second.degree + gPrime.verticies[e->vertexID].degree;
-                if((int)commonNeighbors.size() > mostCommons) {
-                    foundNewVertex = true;
-                } else if((int)commonNeighbors.size() == mostCommons) {
-					// tie breaker
-                    if(sumOfDegrees < testSumOfDegrees) {
-                        foundNewVertex = true;
-                    }
-                }
-                if(foundNewVertex) {
-                    mostCommons = (int) commonNeighbors.size();
-                    si = sitr->first;
-                    sj = e->vertexID;
-                    sumOfDegrees = testSumOfDegrees;
-                    foundNewVertex = false;
-                }
+#include <chrono>
+#include <sys/stat.h>
+
+//
+// true if a and b have the same verticies, by name in key order, and
+// the same edges in the same order with the same weights
+//
+static bool sameGraph(csrGraphClass& a, csrGraphClass& b) {
+    typedef csrGraphClass::vertexKeyT vertexKeyT;
+    auto listGraph = [](csrGraphClass& g, std::vector<std::string>& names, std::vector<std::pair<vertexKeyT, int> >& edges) {
+        g.forEachVertex([&](vertexKeyT x, int) {
+            names.push_back(g.vertexName(x));
+            g.forEachWeightedNeighbor(x, [&](vertexKeyT y, int w) {
+                edges.push_back(std::make_pair(y, w));
+            });
+        });
+    };
+    std::vector<std::string> aNames, bNames;
+    std::vector<std::pair<vertexKeyT, int> > aEdges, bEdges;
+    listGraph(a, aNames, aEdges);
+    listGraph(b, bNames, bEdges);
+    return (a.numEdges() == b.numEdges()) && (aNames == bNames) && (aEdges == bEdges);
+}
+
+//
+// converts a text graph file to the binary format of binarygraph.h and
+// maps the result back in to check it. With parseThreads the text is
+// read by readGraphParallel, and when validating also by readGraph, and
+// the two graphs are compared
+//
+static int convertGraph(const char* textName, const char* binaryName, unsigned int parseThreads) {
+    csrGraphClass g;
+    FILE* inFile = fopen(textName, "r");
+    if (inFile == nullptr) {
+        printf("Unable to open %s\n", textName);
+        return 1;
+    }
+    if (parseThreads == 0) {
+        g.readGraph(inFile);
+    } else {
+        g.readGraphParallel(textName, parseThreads);
+        if (validating()) {
+            csrGraphClass gSerial;
+            gSerial.readGraph(inFile);
+            if (!sameGraph(g, gSerial)) {
+                printf("readGraphParallel() read %s differently from readGraph()\n", textName);
             }
         }
-        if(noisy()) {
-            printf("TsengAlgorithm(): Most Commons is %s and %s with %i common neighbors\n", si.c_str(), sj.c_str(), mostCommons);
+    }
+    fclose(inFile);
+
+    FILE* outFile = fopen(binaryName, "wb");
+    if (outFile == nullptr) {
+        printf("Unable to open output file %s\n", binaryName);
+        return 1;
+    }
+    bool ok = g.writeBinaryGraph(outFile);
+    ok = (fclose(outFile) == 0) && ok;
+
+    std::shared_ptr<mappedGraphClass> m = std::make_shared<mappedGraphClass>();
+    csrGraphClass gCheck;
+    if (!ok || !m->open(binaryName) || !gCheck.readBinaryGraph(m)) {
+        printf("Conversion of %s failed\n", textName);
+        return 1;
+    }
+    if ((gCheck.numVerticies() != g.numVerticies()) || (gCheck.numEdges() != g.numEdges())) {
+        printf("Converted graph has %i verticies and %i edges, expected %i and %i\n",
+               gCheck.numVerticies(), gCheck.numEdges(), g.numVerticies(), g.numEdges());
+        return 1;
+    }
+    printf("Wrote %s: %i verticies, %i edges\n", binaryName, gCheck.numVerticies(), gCheck.numEdges());
+    return 0;
+}
+
+//
+// partitions a graph too large for memory with BhaskerAlgorithm on the
+// disk store, building the disk graph file from the text first. Half of
+// memoryBytes goes to the page cache and a quarter to the merge log
+//
+static int runOutOfCore(const char* textName, const char* diskName, size_t memoryBytes, bool weighted) {
+    if (!buildDiskGraph(textName, diskName, memoryBytes)) {
+        printf("Unable to build %s from %s\n", diskName, textName);
+        return 1;
+    }
+    diskGraphClass g;
+    if (!g.open(diskName, memoryBytes / 2, memoryBytes / 4)) {
+        return 1;
+    }
+    printf("Read %s: %i verticies, %i edges\n", diskName, g.numVerticies(), g.numEdges());
+    cliquePartitionClass cliques;
+    BhaskerAlgorithm(g, cliques, weighted);
+    printf("Bhasker Algorithm cliques (out of core) are:\n");
+    return cliques.writeCliques(stdout) ? 0 : 1;
+}
+
+//
+// partitions a graph with BhaskerAlgorithm, then for each file of
+// changes in changesNames makes the changes and repairs the partition,
+// printing each. The first partition comes from cache when it has it
+//
+static int runRepair(const char* graphName, const char* const* changesNames, int numChanges, bool weighted,
+                     unsigned int numThreads, partitionCacheClass* cache) {
+    graphDatabaseClass g;
+    g.bulkThreads = numThreads;
+    FILE* inFile = fopen(graphName, "r");
+    if (inFile == nullptr) {
+        printf("Unable to open %s\n", graphName);
+        return 1;
+    }
+    g.readGraph(inFile);
+    fclose(inFile);
+    cliqueAlgorithmT bhasker = weighted ? cliqueAlgorithmWeightedBhasker : cliqueAlgorithmBhasker;
+    cliquePartitionClass cliques;
+    cachedPartition(cache, bhasker, g, cliques, [&](cliquePartitionClass& c) {
+        runCliqueAlgorithm(bhasker, g, c, numThreads);
+    });
+    printf("Bhasker Algorithm cliques are:\n");
+    cliques.writeCliques(stdout);
+    // the clique of each vertex is kept from one file of changes to the next
+    partitionRepairClass<graphDatabaseClass> repair(g, bhasker, numThreads);
+    repair.load(cliques);
+    for (int i = 0; i < numChanges; ++i) {
+        std::vector<graphChangeT> changes;
+        inFile = fopen(changesNames[i], "r");
+        if (inFile == nullptr) {
+            printf("Unable to open %s\n", changesNames[i]);
+            return 1;
+        }
+        bool read = readGraphChanges(inFile, changes);
+        fclose(inFile);
+        if (!read) {
+            return 1;
         }
-        //
-        // Update gPrime by
-        //   1. deleting all edges linking si and sj in graph
-        //   2. merging verticies si and sj into one super node
-        //   3. linking in the supernode with the common neighbor links
-        //
-        gPrime.commonNeighbor(si, sj, commonNeighbors);
-        gPrime.disconnectVertex(si); gPrime.verticies.erase(si);
-        gPrime.disconnectVertex(sj); gPrime.verticies.erase(sj);
-        newVertexKey = si + "," + sj;
-        gPrime.insertVertex(newVertexKey);
-		// insert edges to the common neighbers
-        for(const auto &toVertex : commonNeighbors) {
-            gPrime.insertEdge(newVertexKey, toVertex, 1);
+        applyGraphChanges(g, changes);
+        repair.repair(changes);
+        repair.partition(cliques);
+        printf("Bhasker Algorithm cliques (repaired) are:\n");
+        if (!cliques.writeCliques(stdout)) {
+            return 1;
         }
     }
-    //
-    // All edges gone from gPrime, what remains are the
-    // clique super nodes
-    //
-    for(const auto &vtr : gPrime.verticies) {
-        cliques.push_back(vtr.first);
+    return 0;
+}
+
+//
+// reads a binary graph file, see binarygraph.h, into gBinary in place,
+// and into g with every edge list in the order the text it was made from
+// gave, so both stores give the cliques they give from the text
+//
+static bool readBinaryInput(const char* fileName, bool compressRows, csrGraphClass& gBinary, graphDatabaseClass& g) {
+    profileTimerClass timer("readBinaryGraph");
+    std::shared_ptr<mappedGraphClass> m = std::make_shared<mappedGraphClass>();
+    std::vector<std::string> names;
+    std::vector<graphDatabaseClass::edgeT> edges;
+    gBinary.compressRows = compressRows;
+    if (!m->open(fileName) || !gBinary.readBinaryGraph(m) || !gBinary.listEdges(names, edges)) {
+        printf("Unable to read %s\n", fileName);
+        return false;
     }
+    g.directed = m->directed();
+    g.buildFromEdges(names, edges);
+    return true;
 }
 
-inline int maxInt() { return std::numeric_limits<int>::max(); }
-
-void BhaskerAlgorithm(const graphDatabaseClass& g,
-	std::vector<graphDatabaseClass::vertexKeyT>& cliques
-	)
-{
-	graphDatabaseClass gPrime(g); // work on copy
-	cliques.clear();
-	int loops = 0;
-	while (gPrime.edgeCount > 0) {
-        graphDatabaseClass::vertexKeyT p, q, newVertexKey;
-        graphDatabaseClass::verticiesT::iterator pitr, qitr;
-        std::vector<graphDatabaseClass::vertexKeyT> commonNeighbors;
-
-		if (noisy()) {
-			printf("BhaskerAlgorithm(): Loop %i\n", ++loops);
-			gPrime.checkGraph();
-			gPrime.writeGraph(stdout);
+// level named on the command line; false if there is no such level
+static bool parseLogLevel(const char* name, logLevelT& level) {
+    static const char* const names[] = { "silent", "error", "warning", "info", "debug", "trace" };
+    for (int i = logSilent; i <= logTrace; ++i) {
+        if (strcmp(name, names[i]) == 0) {
+            level = (logLevelT) i;
+            return true;
         }
-		int pDegree = maxInt();
-		// find the vertex with the smallest non-zero degree, call it p
-		// there must be at least one since there is at least one edge in gPrime
-		for (const auto &vtr : gPrime.verticies) {
-			if ((vtr.second.degree > 0) && (vtr.second.degree < pDegree)) {
-				p = vtr.first;
-				pDegree = vtr.second.degree;
-			}
-		}
-		assert(!p.empty()); // there should have been at least one vertex of non-zero degree
-		assert(pDegree > 0);
-		// find q
-		int qDegree = maxInt();
-		int qCommonNeighbors = -1;
-		// q is
-		//  1. not the same as p
-		//  2. neighbor of p with smallest degree
-		//  3. tie breaker: has most common neighbors with p
-		//  4. tie breaker: first one we find
-    	for (auto e = gPrime.verticies[p].edgeList; e != nullptr; e = e->next) {
-			if (p.compare(e->vertexID) == 0) {
-				// we found the back pointer to p
-				continue;
-			}
-			gPrime.commonNeighbor(p, e->vertexID, commonNeighbors);
-			bool newqFound = false;
-			// if degree is smaller, e is our new q
-			if (gPrime.verticies[e->vertexID].degree < qDegree) {
-				newqFound = true;
-			} else if (gPrime.verticies[e->vertexID].degree == qDegree) {
-				// tiebreaker: if e has more common neighbors with p
-				if ((int) commonNeighbors.size() > qCommonNeighbors) {
-					newqFound = true;
-				}
-			}
-			if (newqFound) {
-                q = e->vertexID;
-				qCommonNeighbors = (int) commonNeighbors.size();
-				newqFound = false;
-			}
-		}
-		gPrime.commonNeighbor(p, q, commonNeighbors);
-        gPrime.disconnectVertex(p); gPrime.verticies.erase(p);
-        gPrime.disconnectVertex(q); gPrime.verticies.erase(q);
-		newVertexKey = p + "," + q;
-		gPrime.insertVertex(newVertexKey);
-		// insert edges to the common neighbers
-		for (const auto &toVertex : commonNeighbors) {
-			gPrime.insertEdge(newVertexKey, toVertex, 1);
-		}
-	}
-	//
-	// All edges gone from gPrime, what remains are the
-	// clique super nodes
-	//
-	for (const auto &vtr : gPrime.verticies) {
-		cliques.push_back(vtr.first);
-	}
+    }
+    return false;
+}
+
+//
+// partitions every graph of a manifest or a directory, see batch.h
+//
+static int runBatchCommand(const char* source, const char* outputDir, const batchOptionsT& options) {
+    std::vector<batchJobT> jobs;
+    struct stat st;
+    bool listed = ((stat(source, &st) == 0) && S_ISDIR(st.st_mode)) ?
+                  listBatchDirectory(source, outputDir, jobs) :
+                  readBatchManifest(source, outputDir, jobs);
+    if (!listed) {
+        return 1;
+    }
+    mkdir(outputDir, 0777); // may exist already
+    auto start = std::chrono::steady_clock::now();
+    int failures = runBatch(jobs, options);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("batch: %zu jobs, %i failed, %.3fs\n", jobs.size(), failures, seconds);
+    return (failures == 0) ? 0 : 1;
+}
+
+//
+// writes the counters and timer totals to profileName and the events
+// to traceName, either of which may be null, see profile.h
+//
+static bool writeProfile(const char* profileName, const char* traceName) {
+    bool ok = true;
+    const char* names[] = { profileName, traceName };
+    for (int i = 0; i < 2; ++i) {
+        if (names[i] == nullptr) {
+            continue;
+        }
+        FILE* f = fopen(names[i], "w");
+        if (f == nullptr) {
+            printf("Unable to open profile file %s\n", names[i]);
+            ok = false;
+            continue;
+        }
+        bool written = (i == 0) ? profileWriteJson(f) : profileWriteChromeTrace(f);
+        if (!((fclose(f) == 0) && written)) {
+            printf("Error writing profile file %s\n", names[i]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// runs algorithm on the whole graph, or one connected component at a time,
+// on numThreads threads unless cache has the cliques already
+template <typename graphT>
+static void partitionGraph(const graphT& g, cliqueAlgorithmT algorithm, bool byComponents, unsigned int numThreads,
+                           partitionCacheClass* cache, cliquePartitionClass& cliques) {
+    cachedPartition(cache, algorithm, g, cliques, [&](cliquePartitionClass& c) {
+        if (byComponents) {
+            partitionByComponents(g, algorithm, c, numThreads);
+        } else {
+            runCliqueAlgorithm(algorithm, g, c, numThreads);
+        }
+    });
+}
+
+// with restarts, refines cliques and prints the result as title (refined)
+template <typename graphT>
+static void printRefined(const graphT& g, const char* title, const refineOptionsT& options, const cliquePartitionClass& cliques) {
+    if (options.numRestarts == 0) {
+        return;
+    }
+    cliquePartitionClass refined;
+    refinePartition(g, cliques, options, refined);
+    printf("%s (refined) are:\n", title);
+    refined.writeCliques(stdout);
 }
 
 int main(int argc, const char * argv[]) {
+    bool byComponents = false;
+    bool weighted = false;
+    bool compressRows = false;
+    unsigned int parseThreads = 0;  // readGraph
+    bool lowerBound = false;
+    int portfolioVariants = -1;     // no portfolio
+    double budgetSeconds = 0;
+    refineOptionsT refine;
+    refine.numRestarts = 0;         // no refinement
+    unsigned int numThreads = 0;
+    size_t memoryBytes = diskGraphDefaultMemory;
+    const char* profileName = nullptr;
+    const char* traceName = nullptr;
+    const char* cacheDirectory = nullptr;
+    uint64_t cacheBytes = partitionCacheClass::defaultMaxBytes;
+    // CliquePartitioning [-log silent|error|warning|info|debug|trace] [-validate] [-components] [-weighted] [-compress] [-bound] [-threads n]
+    //                    [-profile counters.json] [-trace trace.json] [-memory megabytes]
+    //                    [-cache directory] [-cachesize megabytes] [-portfolio variants] [-budget seconds]
+    //                    [-refine restarts] [-seed n] [-parse threads] [graph.txt | graph.bin | ...]
+    while ((argc > 1) && (argv[1][0] == '-')) {
+        logLevelT level;
+        if ((argc > 2) && (strcmp(argv[1], "-log") == 0) && parseLogLevel(argv[2], level)) {
+            if (level > maxLogLevel) {
+                printf("Log level %s is compiled out of this build\n", argv[2]);
+            }
+            setLogLevel(level);
+            argc -= 2;
+            argv += 2;
+        } else if (strcmp(argv[1], "-validate") == 0) {
+            if (CLIQUE_VALIDATION == 0) {
+                printf("Validation is compiled out of this build\n");
+            }
+            setValidation(true);
+            --argc;
+            ++argv;
+        } else if (strcmp(argv[1], "-components") == 0) {
+            byComponents = true;
+            --argc;
+            ++argv;
+        } else if (strcmp(argv[1], "-weighted") == 0) {
+            weighted = true;
+            --argc;
+            ++argv;
+        } else if (strcmp(argv[1], "-compress") == 0) {
+            compressRows = true;
+            --argc;
+            ++argv;
+        } else if (strcmp(argv[1], "-bound") == 0) {
+            lowerBound = true;
+            --argc;
+            ++argv;
+        } else if ((argc > 2) && (strcmp(argv[1], "-threads") == 0)) {
+            numThreads = (unsigned int) atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-parse") == 0)) {
+            parseThreads = (unsigned int) atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-memory") == 0)) {
+            memoryBytes = (size_t) atoi(argv[2]) << 20;
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-portfolio") == 0)) {
+            portfolioVariants = atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-refine") == 0)) {
+            refine.numRestarts = (unsigned int) atoi(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-seed") == 0)) {
+            refine.seed = (uint64_t) atoll(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-budget") == 0)) {
+            budgetSeconds = atof(argv[2]);
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-cache") == 0)) {
+            cacheDirectory = argv[2];
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && (strcmp(argv[1], "-cachesize") == 0)) {
+            cacheBytes = (uint64_t) atoll(argv[2]) << 20;
+            argc -= 2;
+            argv += 2;
+        } else if ((argc > 2) && ((strcmp(argv[1], "-profile") == 0) || (strcmp(argv[1], "-trace") == 0))) {
+            if (CLIQUE_PROFILING == 0) {
+                printf("Profiling is compiled out of this build\n");
+            }
+            setProfiling(true);
+            if (strcmp(argv[1], "-profile") == 0) {
+                profileName = argv[2];
+            } else {
+                traceName = argv[2];
+            }
+            argc -= 2;
+            argv += 2;
+        } else {
+            break;
+        }
+    }
+    // CliquePartitioning -convert graph.txt graph.bin
+    if ((argc == 4) && (strcmp(argv[1], "-convert") == 0)) {
+        int status = convertGraph(argv[2], argv[3], parseThreads);
+        return writeProfile(profileName, traceName) ? status : 1;
+    }
+    // CliquePartitioning -batch manifest|directory outputDirectory
+    if ((argc == 4) && (strcmp(argv[1], "-batch") == 0)) {
+        batchOptionsT options;
+        options.numThreads = numThreads;
+        options.byComponents = byComponents;
+        options.weighted = weighted;
+        options.compressRows = compressRows;
+        options.parseThreads = parseThreads;
+        options.lowerBound = lowerBound;
+        if (cacheDirectory != nullptr) {
+            options.cacheDirectory = cacheDirectory;
+            options.cacheBytes = cacheBytes;
+        }
+        int status = runBatchCommand(argv[2], argv[3], options);
+        return writeProfile(profileName, traceName) ? status : 1;
+    }
+    // CliquePartitioning -outofcore graph.txt graph.disk
+    if ((argc == 4) && (strcmp(argv[1], "-outofcore") == 0)) {
+        int status = runOutOfCore(argv[2], argv[3], memoryBytes, weighted);
+        return writeProfile(profileName, traceName) ? status : 1;
+    }
+    // a cache that will not open is left closed, and everything is partitioned afresh
+    partitionCacheClass cache;
+    if (cacheDirectory != nullptr) {
+        cache.open(cacheDirectory, cacheBytes);
+    }
+    // CliquePartitioning -repair graph.txt changes.txt ...
+    if ((argc >= 4) && (strcmp(argv[1], "-repair") == 0)) {
+        int status = runRepair(argv[2], argv + 3, argc - 3, weighted, numThreads, &cache);
+        return writeProfile(profileName, traceName) ? status : 1;
+    }
     graphDatabaseClass g;
     graphDatabaseClass gPrime;
     std::string s1("v1");
@@ -172,45 +417,121 @@ int main(int argc, const char * argv[]) {
     const char * ifname = "/Users/Bill/Google Drive/Computer and Network/MacProjects/CliquePartitioning/CliquePartitioning/Fig4_Bhasker.txt";
     
     const char * ofname = "/Users/Bill/Google Drive/Computer and Network/MacProjects/CliquePartitioning/CliquePartitioning/output.txt";
-    std::vector<std::string> cliques;
+    // CliquePartitioning graph.txt|graph.bin reads the graph named, and writes no output file
+    if (argc == 2) {
+        ifname = argv[1];
+        ofname = nullptr;
+    }
+    cliquePartitionClass cliques;
     
     FILE* inFile=nullptr, *outFile=nullptr;
+    g.bulkThreads = numThreads;
     
-    inFile = fopen(ifname, "r");
-    if(inFile == nullptr) {
-        printf("Unable to open\n");
-        return 1;
+    // a binary graph file, made by -convert, is recognized by its magic
+    csrGraphClass gBinary;
+    bool binary = isBinaryGraphFile(ifname);
+    if (binary) {
+        if (!readBinaryInput(ifname, compressRows, gBinary, g)) {
+            return 1;
+        }
+    } else {
+        inFile = fopen(ifname, "r");
+        if(inFile == nullptr) {
+            printf("Unable to open\n");
+            return 1;
+        }
+        {
+            profileTimerClass timer("readGraph");
+            g.readGraph(inFile);
+        }
+        fclose(inFile);
     }
-    g.readGraph(inFile);
-    fclose(inFile);
     
-    outFile = fopen(ofname, "w");
-    if(outFile == nullptr) {
-        printf("Unable to open output file\n");
-        return 1;
+    if (ofname != nullptr) {
+        outFile = fopen(ofname, "w");
+        if(outFile == nullptr) {
+            printf("Unable to open output file\n");
+            return 1;
+        }
+        fclose(outFile);
+    }
+    if(logging(logTrace)) {
+        g.writeGraph(stdout);
     }
-    g.writeGraph(stdout);
-	fclose(outFile);
 	
-	g.checkGraph();
-
-	TsengAlgorithm(g, cliques);
-	if (noisy()) {
-		int numCliques = 0;
-		printf("Tseng Algorithm cliques are:\n");
-		for (const auto &vtr : cliques) {
-			printf("  %i. %s\n", ++numCliques, vtr.c_str());
+	if (validating()) {
+		g.checkGraph();
+	}
+
+	refine.numThreads = numThreads;
+	refine.budgetSeconds = budgetSeconds;
+	if (portfolioVariants >= 0) {
+		// Tseng, Bhasker and their seeded variants raced, see portfolio.h
+		std::vector<portfolioEntryT> entries;
+		portfolioEntries(weighted, (unsigned int) portfolioVariants, entries);
+		portfolioOptionsT options;
+		options.numThreads = numThreads;
+		options.budgetSeconds = budgetSeconds;
+		if (lowerBound) {
+			options.lowerBound = cliqueCoverLowerBound(g, numThreads);
+			printf("Lower bound is %zu cliques\n", options.lowerBound);
 		}
+		int best = portfolioPartition(g, entries, options, cliques);
+		printf("Portfolio cliques, from %s seed %llu, are:\n", cliqueAlgorithmName(entries[best].algorithm),
+		       (unsigned long long) entries[best].tieSeed);
+		cliques.writeCliques(stdout);
+		printRefined(g, "Portfolio cliques", refine, cliques);
+		return writeProfile(profileName, traceName) ? 0 : 1;
+	}
+
+	cliqueAlgorithmT tseng = weighted ? cliqueAlgorithmWeightedTseng : cliqueAlgorithmTseng;
+	cliqueAlgorithmT bhasker = weighted ? cliqueAlgorithmWeightedBhasker : cliqueAlgorithmBhasker;
+	// with -bound, Bhasker is skipped when Tseng has as few cliques as can be
+	size_t bound = 0;
+	if (lowerBound) {
+		bound = cliqueCoverLowerBound(g, numThreads);
+		printf("Lower bound is %zu cliques\n", bound);
+	}
+	partitionGraph(g, tseng, byComponents, numThreads, &cache, cliques);
+	printf("Tseng Algorithm cliques are:\n");
+	cliques.writeCliques(stdout);
+	printRefined(g, "Tseng Algorithm cliques", refine, cliques);
+	bool tsengMeetsBound = lowerBound && (cliques.numCliques() <= bound);
+	if (lowerBound) {
+		printf("Tseng Algorithm is %zu cliques over the lower bound\n", cliques.numCliques() - bound);
 	}
 
-	BhaskerAlgorithm(g, cliques);
-	if (noisy()) {
-		int numCliques = 0;
+	if (tsengMeetsBound) {
+		printf("Bhasker Algorithm skipped\n");
+	} else {
+		partitionGraph(g, bhasker, byComponents, numThreads, &cache, cliques);
 		printf("Bhasker Algorithm cliques are:\n");
-		for (const auto &vtr : cliques) {
-			printf("  %i. %s\n", ++numCliques, vtr.c_str());
+		cliques.writeCliques(stdout);
+		printRefined(g, "Bhasker Algorithm cliques", refine, cliques);
+		if (lowerBound) {
+			printf("Bhasker Algorithm is %zu cliques over the lower bound\n", cliques.numCliques() - bound);
 		}
 	}
 
-    return 0;
+	// same again on the compact store, the mapped graph itself for a binary file
+	csrGraphClass gCompact = binary ? gBinary : csrGraphClass(g);
+	if (compressRows && !binary) {
+		gCompact.compressRows = true;
+		gCompact.freeze();
+	}
+	partitionGraph(gCompact, tseng, byComponents, numThreads, &cache, cliques);
+	printf("Tseng Algorithm cliques (CSR) are:\n");
+	cliques.writeCliques(stdout);
+	printRefined(gCompact, "Tseng Algorithm cliques (CSR)", refine, cliques);
+
+	if (tsengMeetsBound) {
+		printf("Bhasker Algorithm (CSR) skipped\n");
+	} else {
+		partitionGraph(gCompact, bhasker, byComponents, numThreads, &cache, cliques);
+		printf("Bhasker Algorithm cliques (CSR) are:\n");
+		cliques.writeCliques(stdout);
+		printRefined(gCompact, "Bhasker Algorithm cliques (CSR)", refine, cliques);
+	}
+
+    return writeProfile(profileName, traceName) ? 0 : 1;
 };
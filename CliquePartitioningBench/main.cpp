@@ -0,0 +1,472 @@
+//
+//  main.cpp
+//  CliquePartitioningBench
+//
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "graphdb.h"
+#include "csrgraph.h"
+#include "cliquepartition.h"
+#include "components.h"
+#include "lowerbound.h"
+#include "graphgen.h"
+
+//
+// Benchmark for the clique partitioning heuristics. Each case is a
+// generated workload (graphgen.h) or a graph file, run on one store:
+// readGraph, the copy the algorithms make for gPrime, TsengAlgorithm
+// and BhaskerAlgorithm are timed one at a time, and each prints one
+// line of JSON to stdout:
+//
+//   {"workload":"er-1000-5000-s1","store":"csr","phase":"tseng",
+//    "verticies":1000,"edges":5000,"wallSeconds":0.0123,
+//    "peakRssBytes":4194304,"allocations":1234,"allocatedBytes":56789,
+//    "cliques":412}
+//
+// allocations and allocatedBytes count the calls to operator new made
+// during the phase. peakRssBytes is the high water mark of the process
+// at the end of the phase; each case runs in a process of its own, so
+// it covers that case only. cliques is given for the algorithms only.
+// With -profile each line also has the counters of profile.h for the
+// phase, as "counters":{"commonNeighborCalls":...}.
+//
+// Messages meant for people go to stderr.
+//
+
+//
+// every allocation goes through these, so a phase's allocations are
+// the difference of the counts before and after it. Each form of
+// operator new has its matching operator delete, sized ones included
+// where the compiler has them, and all of them go through
+// countedAllocate and countedRelease, kept out of line so the compiler
+// does not see malloc at one end and free at the other and take the
+// replacements for a mismatched pair
+//
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> allocationBytes(0);
+
+__attribute__((noinline)) static void* countedAllocate(size_t size) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size == 0 ? 1 : size);
+}
+__attribute__((noinline)) static void countedRelease(void* p) noexcept {
+    free(p);
+}
+
+void* operator new(size_t size) {
+    void* p = countedAllocate(size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+void operator delete(void* p) noexcept {
+    countedRelease(p);
+}
+void operator delete[](void* p) noexcept {
+    countedRelease(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    countedRelease(p);
+}
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* p, size_t) noexcept {
+    countedRelease(p);
+}
+void operator delete[](void* p, size_t) noexcept {
+    countedRelease(p);
+}
+#endif
+
+namespace {
+
+enum storeT { storeGraphDatabase, storeCsr, storeCsrPacked };
+
+const char* storeName(storeT store) {
+    return (store == storeCsrPacked) ? "csr-packed" : (store == storeCsr) ? "csr" : "db";
+}
+
+// sets up an empty graph as the store asks before it is read
+void prepareStore(graphDatabaseClass& g, storeT, unsigned int numThreads) {
+    g.bulkThreads = numThreads;
+}
+void prepareStore(csrGraphClass& g, storeT store, unsigned int) {
+    g.compressRows = (store == storeCsrPacked);
+}
+
+struct benchOptionsT {
+    bool runDatabase = true;
+    bool runCsr = true;
+    bool runCsrPacked = false;      // csr with compressRows
+    bool runTseng = true;
+    bool runBhasker = true;
+    bool runBound = false;          // the lowerBound phase, see lowerbound.h
+    bool isolate = true;            // one process per case
+    int repeat = 1;
+    unsigned int numThreads = 0;    // threads for the algorithms and the db store's bulk work, 0 for one per core
+    bool byComponents = false;      // run the algorithms one connected component at a time
+    bool weighted = false;          // run the weighted variants of the algorithms
+    std::string directory = "/tmp"; // where generated graphs are written
+    bool keepFiles = false;
+};
+
+struct benchCaseT {
+    std::string workload;           // name in the output
+    std::string fileName;
+    bool generated = false;
+    graphSpecT spec;
+};
+
+uint64_t peakRssBytes() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (uint64_t) usage.ru_maxrss;          // bytes
+#else
+    return (uint64_t) usage.ru_maxrss * 1024;   // kilobytes
+#endif
+}
+
+//
+// measures one phase from construction to report(). With -profile the
+// counters of profile.h start from zero with each phase
+//
+class phaseTimerClass {
+    std::chrono::steady_clock::time_point startTime;
+    uint64_t startCount;
+    uint64_t startBytes;
+
+public:
+    phaseTimerClass() :
+        startTime(std::chrono::steady_clock::now()),
+        startCount(allocationCount.load(std::memory_order_relaxed)),
+        startBytes(allocationBytes.load(std::memory_order_relaxed)) {
+        if (profiling()) {
+            profileReset();
+        }
+    };
+
+    // prints the line for the phase; cliques < 0 leaves the count out
+    void report(const benchCaseT& c, storeT store, const char* phase, int numVerticies, int numEdges, long cliques) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        uint64_t count = allocationCount.load(std::memory_order_relaxed) - startCount;
+        uint64_t bytes = allocationBytes.load(std::memory_order_relaxed) - startBytes;
+        printf("{\"workload\":\"%s\",\"store\":\"%s\",\"phase\":\"%s\",\"verticies\":%i,\"edges\":%i,"
+               "\"wallSeconds\":%.6f,\"peakRssBytes\":%llu,\"allocations\":%llu,\"allocatedBytes\":%llu",
+               c.workload.c_str(), storeName(store), phase, numVerticies, numEdges, seconds,
+               (unsigned long long) peakRssBytes(), (unsigned long long) count, (unsigned long long) bytes);
+        if (cliques >= 0) {
+            printf(",\"cliques\":%li", cliques);
+        }
+        if (profiling()) {
+            printf(",\"counters\":");
+            profileWriteCounters(stdout);
+        }
+        printf("}\n");
+        fflush(stdout);
+    }
+};
+
+template <typename graphT>
+void partitionCase(const graphT& g, cliqueAlgorithmT algorithm, const benchOptionsT& options, cliquePartitionClass& cliques) {
+    if (options.byComponents) {
+        partitionByComponents(g, algorithm, cliques, options.numThreads);
+    } else {
+        runCliqueAlgorithm(algorithm, g, cliques, options.numThreads);
+    }
+}
+
+//
+// runs the phases of one case on one store
+//
+template <typename graphT>
+bool runCase(const benchCaseT& c, storeT store, const benchOptionsT& options) {
+    cliquePartitionClass cliques;
+    graphT g;
+    prepareStore(g, store, options.numThreads);
+    {
+        FILE* inFile = fopen(c.fileName.c_str(), "r");
+        if (inFile == nullptr) {
+            fprintf(stderr, "Unable to open %s\n", c.fileName.c_str());
+            return false;
+        }
+        phaseTimerClass timer;
+        g.readGraph(inFile);
+        timer.report(c, store, "readGraph", g.numVerticies(), g.numEdges(), -1);
+        fclose(inFile);
+    }
+    {
+        phaseTimerClass timer;
+        graphT gPrime(g);
+        timer.report(c, store, "copy", gPrime.numVerticies(), gPrime.numEdges(), -1);
+    }
+    if (options.runBound) {
+        // the bound goes where the other phases put their cliques
+        phaseTimerClass timer;
+        size_t bound = cliqueCoverLowerBound(g, options.numThreads);
+        timer.report(c, store, "lowerBound", g.numVerticies(), g.numEdges(), (long) bound);
+    }
+    if (options.runTseng) {
+        phaseTimerClass timer;
+        partitionCase(g, options.weighted ? cliqueAlgorithmWeightedTseng : cliqueAlgorithmTseng, options, cliques);
+        timer.report(c, store, "tseng", g.numVerticies(), g.numEdges(), (long) cliques.numCliques());
+    }
+    if (options.runBhasker) {
+        phaseTimerClass timer;
+        partitionCase(g, options.weighted ? cliqueAlgorithmWeightedBhasker : cliqueAlgorithmBhasker, options, cliques);
+        timer.report(c, store, "bhasker", g.numVerticies(), g.numEdges(), (long) cliques.numCliques());
+    }
+    return true;
+}
+
+bool runStore(const benchCaseT& c, storeT store, const benchOptionsT& options) {
+    if ((store == storeCsr) || (store == storeCsrPacked)) {
+        return runCase<csrGraphClass>(c, store, options);
+    }
+    return runCase<graphDatabaseClass>(c, store, options);
+}
+
+//
+// runs the store in a child process, so the peak RSS and the heap it
+// starts with are its own
+//
+bool runIsolated(const benchCaseT& c, storeT store, const benchOptionsT& options) {
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Unable to start a process for %s; running it here\n", c.workload.c_str());
+        return runStore(c, store, options);
+    }
+    if (pid == 0) {
+        bool ok = runStore(c, store, options);
+        fflush(stdout);
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Case %s on %s failed\n", c.workload.c_str(), storeName(store));
+        return false;
+    }
+    return true;
+}
+
+bool runBenchCase(benchCaseT& c, const benchOptionsT& options) {
+    if (c.generated) {
+        generatedGraphT graph;
+        if (!generateGraph(c.spec, graph)) {
+            return false;
+        }
+        c.fileName = options.directory + "/" + c.workload + ".txt";
+        FILE* outFile = fopen(c.fileName.c_str(), "w");
+        if (outFile == nullptr) {
+            fprintf(stderr, "Unable to open output file %s\n", c.fileName.c_str());
+            return false;
+        }
+        bool ok = writeGeneratedGraph(outFile, graph);
+        ok = (fclose(outFile) == 0) && ok;
+        if (!ok) {
+            fprintf(stderr, "Unable to write %s\n", c.fileName.c_str());
+            return false;
+        }
+        fprintf(stderr, "%s: %u verticies, %llu edges\n", c.workload.c_str(), graph.numVerticies,
+                (unsigned long long) graph.edges.size());
+    }
+    bool ok = true;
+    std::vector<storeT> stores;
+    if (options.runDatabase) {
+        stores.push_back(storeGraphDatabase);
+    }
+    if (options.runCsr) {
+        stores.push_back(storeCsr);
+    }
+    if (options.runCsrPacked) {
+        stores.push_back(storeCsrPacked);
+    }
+    for (int r = 0; r < options.repeat; ++r) {
+        for (storeT store : stores) {
+            ok = (options.isolate ? runIsolated(c, store, options) : runStore(c, store, options)) && ok;
+        }
+    }
+    if (c.generated && !options.keepFiles) {
+        unlink(c.fileName.c_str());
+    }
+    return ok;
+}
+
+benchCaseT generatedCase(graphFamilyT family, uint32_t numVerticies, uint64_t numEdges, uint64_t seed) {
+    benchCaseT c;
+    c.generated = true;
+    c.spec.family = family;
+    c.spec.numVerticies = numVerticies;
+    c.spec.numEdges = numEdges;
+    c.spec.seed = seed;
+    char name[128];
+    snprintf(name, sizeof(name), "%s-%u-%llu-s%llu", graphFamilyName(family), numVerticies,
+             (unsigned long long) numEdges, (unsigned long long) seed);
+    c.workload = name;
+    return c;
+}
+
+//
+// the standard sets of cases. The interval graphs are dense, so they
+// get fewer verticies for the same number of edges
+//
+bool suiteCases(const char* suite, uint64_t seed, std::vector<benchCaseT>& cases) {
+    struct sizeT { uint32_t numVerticies; uint32_t intervalVerticies; uint64_t numEdges; };
+    std::vector<sizeT> sizes;
+    if (strcmp(suite, "small") == 0) {
+        sizes.push_back({ 1000, 200, 5000 });
+        sizes.push_back({ 10000, 700, 50000 });
+    } else if (strcmp(suite, "medium") == 0) {
+        sizes.push_back({ 100000, 2000, 500000 });
+        sizes.push_back({ 200000, 4500, 2000000 });
+    } else if (strcmp(suite, "large") == 0) {
+        sizes.push_back({ 2000000, 9000, 10000000 });
+        sizes.push_back({ 5000000, 14000, 40000000 });
+    } else {
+        return false;
+    }
+    const graphFamilyT families[] = { familyErdosRenyi, familyPowerLaw, familyGeometric, familyInterval };
+    for (const auto &s : sizes) {
+        for (graphFamilyT f : families) {
+            cases.push_back(generatedCase(f, (f == familyInterval) ? s.intervalVerticies : s.numVerticies, s.numEdges, seed));
+        }
+    }
+    return true;
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: CliquePartitioningBench [options] case...\n"
+            "cases:\n"
+            "  -suite small|medium|large       the standard workloads, thousands to tens of millions of edges\n"
+            "  -gen er|powerlaw|geometric|interval verticies edges\n"
+            "  -file graph.txt                 a graph in the format of readGraph\n"
+            "generator options, for the cases after them:\n"
+            "  -seed n                         seed of the generators (1)\n"
+            "  -weights n                      generated weights are 1..n (1)\n"
+            "  -exponent x                     power law exponent (2.5)\n"
+            "options for all the cases:\n"
+            "  -store db|csr|packed|both|all   packed is csr with compressed rows; both is db and csr (both)\n"
+            "  -algo tseng|bhasker|both|none   (both)\n"
+            "  -bound                          add a phase finding a lower bound on the cliques\n"
+            "  -repeat n                       run each case n times (1)\n"
+            "  -threads n                      threads for the algorithms and bulk copies, 0 for one per core (0)\n"
+            "  -components                     run the algorithms one connected component at a time\n"
+            "  -weighted                       run the weighted variants, scoring by edge weight\n"
+            "  -profile                        add the counters of profile.h to each line\n"
+            "  -dir path                       where generated graphs are written (/tmp)\n"
+            "  -keep                           keep the generated graphs\n"
+            "  -inprocess                      run the cases in this process\n");
+}
+
+} // namespace
+
+int main(int argc, const char * argv[]) {
+    benchOptionsT options;
+    uint64_t seed = 1;
+    int maxWeight = 1;
+    double exponent = 2.5;
+    std::vector<benchCaseT> cases;
+    bool ok = true;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        int left = argc - i - 1;
+        if (arg == "-suite" && left >= 1) {
+            std::vector<benchCaseT> suite;
+            if (!suiteCases(argv[++i], seed, suite)) {
+                fprintf(stderr, "Unknown suite %s\n", argv[i]);
+                return 1;
+            }
+            for (auto &c : suite) {
+                c.spec.maxWeight = maxWeight;
+                c.spec.exponent = exponent;
+                cases.push_back(c);
+            }
+        } else if (arg == "-gen" && left >= 3) {
+            graphFamilyT family;
+            if (!parseGraphFamily(argv[i + 1], family)) {
+                fprintf(stderr, "Unknown graph family %s\n", argv[i + 1]);
+                return 1;
+            }
+            benchCaseT c = generatedCase(family, (uint32_t) strtoul(argv[i + 2], nullptr, 0), strtoull(argv[i + 3], nullptr, 0), seed);
+            c.spec.maxWeight = maxWeight;
+            c.spec.exponent = exponent;
+            cases.push_back(c);
+            i += 3;
+        } else if (arg == "-file" && left >= 1) {
+            benchCaseT c;
+            c.fileName = argv[++i];
+            c.workload = c.fileName.substr(c.fileName.find_last_of('/') + 1);
+            cases.push_back(c);
+        } else if (arg == "-seed" && left >= 1) {
+            seed = strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "-weights" && left >= 1) {
+            maxWeight = atoi(argv[++i]);
+        } else if (arg == "-exponent" && left >= 1) {
+            exponent = atof(argv[++i]);
+        } else if (arg == "-store" && left >= 1) {
+            std::string s(argv[++i]);
+            options.runDatabase = (s == "db") || (s == "both") || (s == "all");
+            options.runCsr = (s == "csr") || (s == "both") || (s == "all");
+            options.runCsrPacked = (s == "packed") || (s == "all");
+        } else if (arg == "-algo" && left >= 1) {
+            std::string s(argv[++i]);
+            options.runTseng = (s == "tseng") || (s == "both");
+            options.runBhasker = (s == "bhasker") || (s == "both");
+        } else if (arg == "-repeat" && left >= 1) {
+            options.repeat = atoi(argv[++i]);
+        } else if (arg == "-threads" && left >= 1) {
+            options.numThreads = (unsigned int) atoi(argv[++i]);
+        } else if (arg == "-dir" && left >= 1) {
+            options.directory = argv[++i];
+        } else if (arg == "-keep") {
+            options.keepFiles = true;
+        } else if (arg == "-bound") {
+            options.runBound = true;
+        } else if (arg == "-components") {
+            options.byComponents = true;
+        } else if (arg == "-weighted") {
+            options.weighted = true;
+        } else if (arg == "-profile") {
+            setProfiling(true);
+        } else if (arg == "-inprocess") {
+            options.isolate = false;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (cases.empty()) {
+        usage();
+        return 1;
+    }
+    for (auto &c : cases) {
+        ok = runBenchCase(c, options) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,251 @@
+//
+//  batch.cpp
+//  CliquePartitioning
+//
+
+#include "batch.h"
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include "csrgraph.h"
+#include "cliquepartition.h"
+#include "components.h"
+#include "partitioncache.h"
+#include "lowerbound.h"
+#include "threadpool.h"
+
+namespace {
+
+//
+// what a worker keeps from one job to the next
+//
+struct batchWorkspaceT {
+    csrGraphClass g;
+    cliquePartitionClass cliques;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the output for inputName when none is given: outputDir/<file name>.cliques
+std::string defaultOutputName(const std::string& inputName, const char* outputDir) {
+    size_t slash = inputName.rfind('/');
+    std::string fileName = (slash == std::string::npos) ? inputName : inputName.substr(slash + 1);
+    return std::string(outputDir) + "/" + fileName + ".cliques";
+}
+
+bool readJobGraph(const batchJobT& job, const batchOptionsT& options, csrGraphClass& g) {
+    if (isBinaryGraphFile(job.inputName.c_str())) {
+        std::shared_ptr<mappedGraphClass> m = std::make_shared<mappedGraphClass>();
+        return m->open(job.inputName.c_str()) && g.readBinaryGraph(m);
+    }
+    FILE* inFile = fopen(job.inputName.c_str(), "r");
+    if (inFile == nullptr) {
+        printf("runBatch(): unable to open %s\n", job.inputName.c_str());
+        return false;
+    }
+    // a file the reader complains about fails the job, not partitioned as far as it was read
+    if (options.parseThreads > 0) {
+        fclose(inFile); // readGraphParallel maps the file itself
+        return g.readGraphParallel(job.inputName.c_str(), options.parseThreads);
+    }
+    bool read = g.readGraph(inFile);
+    fclose(inFile);
+    return read;
+}
+
+// runs one algorithm on the workspace graph and appends its cliques to outFile
+bool runJobAlgorithm(cliqueAlgorithmT algorithm, const char* title, const batchJobT& job, const batchOptionsT& options,
+                     partitionCacheClass* cache, batchWorkspaceT& w, FILE* outFile,
+                     double& seconds, size_t& numCliques) {
+    auto start = std::chrono::steady_clock::now();
+    cachedPartition(cache, algorithm, w.g, w.cliques, [&](cliquePartitionClass& cliques) {
+        if (options.byComponents) {
+            partitionByComponents(w.g, algorithm, cliques, 1);
+        } else {
+            runCliqueAlgorithm(algorithm, w.g, cliques, 1);
+        }
+    });
+    seconds = secondsSince(start);
+    numCliques = w.cliques.numCliques();
+    if (validating() && options.lowerBound && (numCliques < job.lowerBound)) {
+        printf("runBatch(): %s has %zu cliques, fewer than its lower bound of %zu\n", job.inputName.c_str(), numCliques, job.lowerBound);
+    }
+    fprintf(outFile, "%s Algorithm cliques are:\n", title);
+    return w.cliques.writeCliques(outFile);
+}
+
+bool runJob(batchJobT& job, const batchOptionsT& options, partitionCacheClass* cache, batchWorkspaceT& w) {
+    auto start = std::chrono::steady_clock::now();
+    if (!readJobGraph(job, options, w.g)) {
+        return false;
+    }
+    job.readSeconds = secondsSince(start);
+    job.numVerticies = w.g.numVerticies();
+    job.numEdges = w.g.numEdges();
+    if (options.lowerBound) {
+        start = std::chrono::steady_clock::now();
+        job.lowerBound = cliqueCoverLowerBound(w.g, 1);
+        job.boundSeconds = secondsSince(start);
+    }
+
+    FILE* outFile = fopen(job.outputName.c_str(), "w");
+    if (outFile == nullptr) {
+        printf("runBatch(): unable to open output file %s\n", job.outputName.c_str());
+        return false;
+    }
+    bool ok = true;
+    if (options.runTseng) {
+        cliqueAlgorithmT tseng = options.weighted ? cliqueAlgorithmWeightedTseng : cliqueAlgorithmTseng;
+        ok = runJobAlgorithm(tseng, "Tseng", job, options, cache, w, outFile, job.tsengSeconds, job.tsengCliques) && ok;
+    }
+    job.bhaskerSkipped = options.runBhasker && options.runTseng && options.lowerBound && ok &&
+                         (job.tsengCliques <= job.lowerBound);
+    if (options.runBhasker && !job.bhaskerSkipped) {
+        cliqueAlgorithmT bhasker = options.weighted ? cliqueAlgorithmWeightedBhasker : cliqueAlgorithmBhasker;
+        ok = runJobAlgorithm(bhasker, "Bhasker", job, options, cache, w, outFile, job.bhaskerSeconds, job.bhaskerCliques) && ok;
+    }
+    ok = (fclose(outFile) == 0) && ok;
+    if (!ok) {
+        printf("runBatch(): error writing %s\n", job.outputName.c_str());
+    }
+    return ok;
+}
+
+} // namespace
+
+bool readBatchManifest(const char* manifestName, const char* outputDir, std::vector<batchJobT>& jobs) {
+    FILE* f = fopen(manifestName, "r");
+    if (f == nullptr) {
+        printf("readBatchManifest(): unable to open %s\n", manifestName);
+        return false;
+    }
+    std::string manifestDir(manifestName);
+    size_t slash = manifestDir.rfind('/');
+    manifestDir = (slash == std::string::npos) ? std::string() : manifestDir.substr(0, slash + 1);
+    bool returnVal = true;
+    int lineNum = 0;
+    char line[4096];
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        ++lineNum;
+        if ((strchr(line, '\n') == nullptr) && !feof(f)) {
+            printf("readBatchManifest(): line %i of %s is too long\n", lineNum, manifestName);
+            returnVal = false;
+            break;
+        }
+        char inputName[sizeof(line)];
+        char outputName[sizeof(line)];
+        int fields = sscanf(line, "%s %s", inputName, outputName);
+        if ((fields <= 0) || (inputName[0] == '#')) {
+            continue;
+        }
+        batchJobT job;
+        job.inputName = (inputName[0] == '/') ? inputName : manifestDir + inputName;
+        if (fields == 2) {
+            job.outputName = (outputName[0] == '/') ? outputName : manifestDir + outputName;
+        } else {
+            job.outputName = defaultOutputName(job.inputName, outputDir);
+        }
+        jobs.push_back(job);
+    }
+    fclose(f);
+    return returnVal;
+}
+
+bool listBatchDirectory(const char* dirName, const char* outputDir, std::vector<batchJobT>& jobs) {
+    DIR* dir = opendir(dirName);
+    if (dir == nullptr) {
+        printf("listBatchDirectory(): unable to open %s\n", dirName);
+        return false;
+    }
+    std::vector<std::string> fileNames;
+    for (struct dirent* e = readdir(dir); e != nullptr; e = readdir(dir)) {
+        if (e->d_name[0] == '.') {
+            continue;
+        }
+        std::string fileName = std::string(dirName) + "/" + e->d_name;
+        struct stat st;
+        if ((stat(fileName.c_str(), &st) == 0) && S_ISREG(st.st_mode)) {
+            fileNames.push_back(fileName);
+        }
+    }
+    closedir(dir);
+    std::sort(fileNames.begin(), fileNames.end());
+    for (const auto &fileName : fileNames) {
+        batchJobT job;
+        job.inputName = fileName;
+        job.outputName = defaultOutputName(fileName, outputDir);
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+int runBatch(std::vector<batchJobT>& jobs, const batchOptionsT& options) {
+    // largest first
+    std::vector<size_t> order(jobs.size());
+    std::vector<long long> fileBytes(jobs.size(), 0);
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        struct stat st;
+        if (stat(jobs[j].inputName.c_str(), &st) == 0) {
+            fileBytes[j] = (long long) st.st_size;
+        }
+        order[j] = j;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return fileBytes[a] > fileBytes[b];
+    });
+
+    // a cache that will not open is left closed, and the jobs run without it
+    partitionCacheClass cache;
+    if (!options.cacheDirectory.empty()) {
+        cache.open(options.cacheDirectory.c_str(), options.cacheBytes);
+    }
+
+    threadPoolClass pool(options.numThreads);
+    // a workspace for each thread, handed to a job while it runs
+    std::vector<std::unique_ptr<batchWorkspaceT> > workspaces;
+    for (unsigned int t = 0; t < pool.size(); ++t) {
+        workspaces.push_back(std::unique_ptr<batchWorkspaceT>(new batchWorkspaceT));
+    }
+    std::mutex lock; // guards workspaces and stdout
+    int failures = 0;
+    pool.parallelFor(order.size(), [&](size_t k) {
+        batchJobT& job = jobs[order[k]];
+        std::unique_ptr<batchWorkspaceT> w;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            w.swap(workspaces.back());
+            workspaces.pop_back();
+        }
+        w->g.compressRows = options.compressRows;
+        job.ok = runJob(job, options, &cache, *w);
+        std::lock_guard<std::mutex> guard(lock);
+        workspaces.push_back(std::move(w));
+        if (!job.ok) {
+            ++failures;
+            printf("batch: %s failed\n", job.inputName.c_str());
+        } else {
+            printf("batch: %s %i verticies %i edges read %.4fs", job.inputName.c_str(), job.numVerticies, job.numEdges, job.readSeconds);
+            if (options.lowerBound) {
+                printf(" bound %.4fs %zu cliques", job.boundSeconds, job.lowerBound);
+            }
+            if (options.runTseng) {
+                printf(" tseng %.4fs %zu cliques", job.tsengSeconds, job.tsengCliques);
+            }
+            if (job.bhaskerSkipped) {
+                printf(" bhasker skipped");
+            } else if (options.runBhasker) {
+                printf(" bhasker %.4fs %zu cliques", job.bhaskerSeconds, job.bhaskerCliques);
+            }
+            printf("\n");
+        }
+        fflush(stdout);
+    });
+    return failures;
+}
@@ -0,0 +1,86 @@
+//
+//  batch.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__batch__
+#define __CliquePartitioning__batch__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//
+// Clique partitioning of many graphs, one job per graph file. The jobs
+// run on a pool of worker threads, one job to a thread at a time, the
+// largest files first so a big file left for last does not hold up the
+// end of the batch. Each job reads its graph into csrGraphClass, text
+// or the binary format of binarygraph.h, runs the algorithms and
+// writes their cliques to its output file as they are listed, in the
+// format CliquePartitioning prints them.
+//
+// A worker keeps its graph and clique partition from one job to the
+// next. The graph recycles the arrays of the last one, see
+// csrGraphClass::initializeGraph, so a steady stream of jobs stops
+// allocating them once the largest graph has been seen.
+//
+// With parseThreads, a text file is mapped and parsed on that many
+// threads of its own, see csrGraphClass::readGraphParallel, which pays
+// when a few large files are left for the last workers.
+//
+// With a cache directory, the cliques of a graph partitioned before by
+// the same algorithm come from partitionCacheClass, shared by all the
+// workers, instead of being found again.
+//
+// With lowerBound, each job also finds a lower bound on its cliques,
+// see lowerbound.h. When the first algorithm meets it the second can
+// do no better and is skipped; its cliques are left out of the output.
+//
+// As each job ends, a line with its size and the time of each phase
+// goes to stdout. A job whose file cannot be read, or that the reader
+// finds malformed, fails and is counted as failed.
+//
+struct batchJobT {
+    std::string inputName;
+    std::string outputName;
+    // filled in by runBatch
+    bool ok = false;
+    int numVerticies = 0;
+    int numEdges = 0;
+    double readSeconds = 0;
+    double tsengSeconds = 0;
+    double bhaskerSeconds = 0;
+    size_t tsengCliques = 0;
+    size_t bhaskerCliques = 0;
+    size_t lowerBound = 0;       // with batchOptionsT::lowerBound
+    double boundSeconds = 0;
+    bool bhaskerSkipped = false; // Tseng met the bound
+};
+
+struct batchOptionsT {
+    unsigned int numThreads = 0; // 0 for one per core
+    bool runTseng = true;
+    bool runBhasker = true;
+    bool byComponents = false;   // see partitionByComponents
+    bool weighted = false;       // the weighted variants of the algorithms
+    bool compressRows = false;   // see csrGraphClass::compressRows
+    unsigned int parseThreads = 0; // text read by readGraphParallel on this many threads; 0 for readGraph
+    std::string cacheDirectory;  // of partitionCacheClass; empty for none
+    uint64_t cacheBytes = (uint64_t) 1 << 30;
+    bool lowerBound = false;     // see cliqueCoverLowerBound
+};
+
+//
+// jobs from a manifest, one graph file per line, optionally followed by
+// the name of its output file. Blank lines and lines starting with #
+// are skipped. Relative names are taken from the directory of the
+// manifest. A job without an output name writes to outputDir
+//
+bool readBatchManifest(const char* manifestName, const char* outputDir, std::vector<batchJobT>& jobs);
+// a job for each file in dirName, in name order, writing to outputDir
+bool listBatchDirectory(const char* dirName, const char* outputDir, std::vector<batchJobT>& jobs);
+// runs the jobs; returns the number that failed
+int runBatch(std::vector<batchJobT>& jobs, const batchOptionsT& options);
+
+#endif /* defined(__CliquePartitioning__batch__) */
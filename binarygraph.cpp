@@ -0,0 +1,144 @@
+//
+//  binarygraph.cpp
+//  CliquePartitioning
+//
+
+#include "binarygraph.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool isBinaryGraphFile(const char* fileName) {
+    char magic[sizeof(binaryGraphMagic)];
+    FILE* f = fopen(fileName, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    bool binary = (fread(magic, 1, sizeof(magic), f) == sizeof(magic)) &&
+                  (memcmp(magic, binaryGraphMagic, sizeof(magic)) == 0);
+    fclose(f);
+    return binary;
+}
+
+mappedFileClass::~mappedFileClass() {
+    close();
+}
+
+void mappedFileClass::close() {
+    if (base != nullptr) {
+        munmap(base, mappedBytes);
+    }
+    base = nullptr;
+    mappedBytes = 0;
+}
+
+bool mappedFileClass::open(const char* fileName) {
+    close();
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0) {
+        printf("mappedFileClass::open(): unable to open %s\n", fileName);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        printf("mappedFileClass::open(): unable to stat %s\n", fileName);
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd); // nothing to map
+        return true;
+    }
+    void* p = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file
+    if (p == MAP_FAILED) {
+        printf("mappedFileClass::open(): unable to map %s\n", fileName);
+        return false;
+    }
+    base = p;
+    mappedBytes = (size_t) st.st_size;
+    return true;
+}
+
+void mappedGraphClass::close() {
+    file.close();
+    header = nullptr;
+}
+
+// true if count items of itemBytes each starting at offset lie inside the file
+static bool sectionFits(uint64_t offset, uint64_t count, uint64_t itemBytes, uint64_t fileBytes) {
+    if ((offset % 8) != 0 || offset > fileBytes) {
+        return false;
+    }
+    return count <= (fileBytes - offset) / itemBytes;
+}
+
+//
+// Maps the file and checks what can be checked without touching every
+// edge: the header, the section bounds, and the name and row offsets
+//
+bool mappedGraphClass::open(const char* fileName) {
+    close();
+    if (!file.open(fileName)) {
+        return false;
+    }
+    if (file.size() < sizeof(binaryGraphHeader)) {
+        printf("mappedGraphClass::open(): %s is too short for a graph header\n", fileName);
+        close();
+        return false;
+    }
+    const binaryGraphHeader* h = (const binaryGraphHeader*) file.data();
+    uint64_t fileBytes = file.size();
+
+    if (memcmp(h->magic, binaryGraphMagic, sizeof(binaryGraphMagic)) != 0) {
+        printf("mappedGraphClass::open(): %s is not a binary graph file\n", fileName);
+        close();
+        return false;
+    }
+    if (h->byteOrder != binaryGraphByteOrder) {
+        printf("mappedGraphClass::open(): %s was written with the other byte order\n", fileName);
+        close();
+        return false;
+    }
+    if (h->version != binaryGraphVersion) {
+        printf("mappedGraphClass::open(): %s is version %u, expected %u\n", fileName, h->version, binaryGraphVersion);
+        close();
+        return false;
+    }
+    uint64_t n = h->numVerticies;
+    if ((h->fileBytes != fileBytes) ||
+        (n >= 0xffffffffu) ||
+        !sectionFits(h->nameOffsetsAt, n + 1, sizeof(uint64_t), fileBytes) ||
+        !sectionFits(h->stringsAt, h->stringBytes, 1, fileBytes) ||
+        !sectionFits(h->rowOffsetsAt, n + 1, sizeof(uint64_t), fileBytes) ||
+        !sectionFits(h->targetsAt, h->numSlots, sizeof(uint32_t), fileBytes) ||
+        !sectionFits(h->sortedTargetsAt, h->numSlots, sizeof(uint32_t), fileBytes) ||
+        !sectionFits(h->weightsAt, h->numSlots, sizeof(int32_t), fileBytes)) {
+        printf("mappedGraphClass::open(): %s is truncated or has bad section offsets\n", fileName);
+        close();
+        return false;
+    }
+    const char* b = file.data();
+    nameOffsets = (const uint64_t*) (b + h->nameOffsetsAt);
+    strings = b + h->stringsAt;
+    rowOffsets = (const uint64_t*) (b + h->rowOffsetsAt);
+    targets = (const uint32_t*) (b + h->targetsAt);
+    sortedTargets = (const uint32_t*) (b + h->sortedTargetsAt);
+    weights = (const int32_t*) (b + h->weightsAt);
+
+    bool ok = (nameOffsets[n] == h->stringBytes) && (rowOffsets[0] == 0) && (rowOffsets[n] == h->numSlots);
+    ok = ok && ((h->stringBytes == 0) || (strings[h->stringBytes - 1] == '\0'));
+    for (uint64_t x = 0; ok && (x < n); ++x) {
+        ok = (nameOffsets[x] < nameOffsets[x + 1]) && (rowOffsets[x] <= rowOffsets[x + 1]);
+    }
+    if (!ok) {
+        printf("mappedGraphClass::open(): %s has bad name or row offsets\n", fileName);
+        close();
+        return false;
+    }
+    header = h;
+    return true;
+}
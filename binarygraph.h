@@ -0,0 +1,120 @@
+//
+//  binarygraph.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__binarygraph__
+#define __CliquePartitioning__binarygraph__
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Binary graph file, written by csrGraphClass::writeBinaryGraph and
+// opened in place with mappedGraphClass. The file is the CSR arrays as
+// they sit in memory, so loading it needs no parsing and no per-edge
+// allocation.
+//
+// Layout, every section starting on an 8 byte boundary:
+//   binaryGraphHeader
+//   uint64_t nameOffsets[numVerticies+1]   offsets into the string table
+//   char     strings[stringBytes]          NUL terminated vertex names
+//   uint64_t rowOffsets[numVerticies+1]    CSR row starts
+//   uint32_t targets[numSlots]             each row in insertion order
+//   uint32_t sortedTargets[numSlots]       each row sorted by ID
+//   int32_t  weights[numSlots]             weights, in the order of targets
+//
+// Vertex IDs are 0..numVerticies-1 in key order. numSlots counts both
+// directions of each edge, like edgeCount. Numbers are stored in the
+// byte order of the machine that wrote the file; byteOrder tells.
+//
+struct binaryGraphHeader {
+    char magic[8];              // "CLQGRAPH"
+    uint32_t version;           // binaryGraphVersion
+    uint32_t byteOrder;         // binaryGraphByteOrder as written
+    uint32_t flags;             // binaryGraphDirected
+    uint32_t reserved;
+    uint64_t numVerticies;
+    uint64_t numSlots;
+    uint64_t stringBytes;
+    // file offsets of the sections
+    uint64_t nameOffsetsAt;
+    uint64_t stringsAt;
+    uint64_t rowOffsetsAt;
+    uint64_t targetsAt;
+    uint64_t sortedTargetsAt;
+    uint64_t weightsAt;
+    uint64_t fileBytes;
+};
+
+const char binaryGraphMagic[8] = { 'C', 'L', 'Q', 'G', 'R', 'A', 'P', 'H' };
+const uint32_t binaryGraphVersion = 1;
+const uint32_t binaryGraphByteOrder = 0x01020304;
+const uint32_t binaryGraphDirected = (1 << 0);
+
+// rounds a file offset up to the next section boundary
+inline uint64_t binaryGraphAlign(uint64_t offset) { return (offset + 7) & ~(uint64_t) 7; }
+
+// true if the file named starts with binaryGraphMagic; false too if it cannot be opened
+bool isBinaryGraphFile(const char* fileName);
+
+//
+// read only mapping of a whole file
+//
+class mappedFileClass {
+    void* base = nullptr;
+    size_t mappedBytes = 0;
+
+public:
+    mappedFileClass() {};
+    ~mappedFileClass();
+    mappedFileClass(const mappedFileClass&) = delete;
+    mappedFileClass& operator= (const mappedFileClass&) = delete;
+
+    // prints the reason and returns false if the file cannot be mapped
+    bool open(const char* fileName);
+    void close();
+    const char* data() const { return (const char*) base; }
+    size_t size() const { return mappedBytes; }
+};
+
+//
+// read only view of a binary graph file mapped into memory
+//
+class mappedGraphClass {
+    mappedFileClass file;
+    const binaryGraphHeader* header = nullptr;
+    const uint64_t* nameOffsets = nullptr;
+    const char* strings = nullptr;
+    const uint64_t* rowOffsets = nullptr;
+    const uint32_t* targets = nullptr;
+    const uint32_t* sortedTargets = nullptr;
+    const int32_t* weights = nullptr;
+
+public:
+    mappedGraphClass() {};
+    mappedGraphClass(const mappedGraphClass&) = delete;
+    mappedGraphClass& operator= (const mappedGraphClass&) = delete;
+
+    // maps the file and checks the header and the section bounds
+    bool open(const char* fileName);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    uint64_t numVerticies() const { return header->numVerticies; }
+    uint64_t numSlots() const { return header->numSlots; }
+    bool directed() const { return (header->flags & binaryGraphDirected) != 0; }
+
+    const char* vertexName(uint32_t x) const { return strings + nameOffsets[x]; }
+    uint32_t degree(uint32_t x) const { return (uint32_t) (rowOffsets[x + 1] - rowOffsets[x]); }
+    const uint32_t* neighbors(uint32_t x) const { return targets + rowOffsets[x]; }
+    const uint32_t* sortedNeighbors(uint32_t x) const { return sortedTargets + rowOffsets[x]; }
+    const int32_t* edgeWeights(uint32_t x) const { return weights + rowOffsets[x]; }
+    // the whole sections, which csrGraphClass::readBinaryGraph reads in place
+    const uint64_t* allRowOffsets() const { return rowOffsets; }
+    const uint32_t* allTargets() const { return targets; }
+    const uint32_t* allSortedTargets() const { return sortedTargets; }
+    const int32_t* allWeights() const { return weights; }
+};
+
+#endif /* defined(__CliquePartitioning__binarygraph__) */
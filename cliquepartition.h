@@ -0,0 +1,391 @@
+//
+//  cliquepartition.h
+//  CliquePartitioning
+//
+//  Created by Bill Salefski on 25-Mar-15.
+//  Copyright (c) 2015 Bill Salefski. All rights reserved.
+//
+//  Tseng and Bhasker clique partitioning heuristics. They are templates
+//  over the graph store so the same code runs on graphDatabaseClass and
+//  on csrGraphClass. A graph store provides
+//    vertexKeyT, numEdges(), degree(x), vertexName(x), keyLess(x, y),
+//    forEachVertex(f), forEachNeighbor(x, f), forEachWeightedNeighbor(x, f),
+//    commonNeighbor(si, sj, v), commonNeighborCount(si, sj),
+//    mergeVerticies(si, sj), enableDegreeBuckets(), minDegreeVertex(x, d),
+//    checkGraph() and writeGraph(FILE*)
+//  degree, forEachNeighbor, forEachWeightedNeighbor, commonNeighborCount
+//  and keyLess are called from several threads at once by the parallel
+//  scans, and must only read.
+//
+//  mergeVerticies gives each edge of the super node the sum of the
+//  weights of the edges to si and sj it replaces. The weighted variants
+//  score common neighbors by these weights, see commonWeightClass; the
+//  plain ones count them and never look at a weight.
+//
+//  The algorithms give the cliques as a cliquePartitionClass, spans of
+//  input vertex IDs, see partition.h. The names of the super nodes are
+//  not needed for that, only their key order.
+//
+
+#ifndef __CliquePartitioning__cliquepartition__
+#define __CliquePartitioning__cliquepartition__
+
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include <limits>
+#include <memory>
+#include <functional>
+#include <assert.h>
+#include "graphdb.h"
+#include "tsengscore.h"
+#include "partition.h"
+
+inline int maxInt() { return std::numeric_limits<int>::max(); }
+
+// TsengAlgorithm scores on more than one thread from this many edges up
+const int tsengMinParallelEdges = 1 << 15;
+
+//
+// What a driver can ask of a run besides the graph, see portfolio.h.
+// A tieSeed other than 0 makes a variant of the algorithm: the ties
+// left to key order go by a seeded hash of the vertex keys instead, and
+// Bhasker's plain variant takes q of least degree, as the weighted one
+// does. The cliques differ but are still a partition into cliques; as
+// the keys of the stores differ, so do the cliques of a seed on each.
+// cancelled, if set, is polled before each merge; once it returns true
+// the run stops, clears its cliques and returns false
+//
+struct cliqueRunControlT {
+    uint64_t tieSeed = 0;
+    std::function<bool()> cancelled;
+};
+
+inline bool runCancelled(const cliqueRunControlT* control) {
+    return (control != nullptr) && control->cancelled && control->cancelled();
+}
+
+//
+// Find two verticies with most common neighboers by scanning every
+// edge. In case of tie, take verticies with maximum sum of degrees.
+// If weighted, common neighbors are weighted as in commonWeightClass.
+// TsengAlgorithm keeps these scores incrementally in tsengScoreClass;
+// the scan is kept to check it
+//
+// Given a pool, the verticies are cut into chunks in key order and each
+// chunk is scanned for its own best pair. The chunk bests are then
+// taken in chunk order with the same test as the scan, so a later chunk
+// wins only with strictly more commons or a strictly larger degree sum,
+// and the pair is the one a scan on one thread finds.
+//
+template <typename graphT>
+void tsengBestPair(graphT& gPrime,
+                   typename graphT::vertexKeyT& si,
+                   typename graphT::vertexKeyT& sj,
+                   int64_t& mostCommons,
+                   threadPoolClass* pool = nullptr,
+                   bool weighted = false
+                   )
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    struct bestPairT {
+        vertexKeyT si = vertexKeyT();
+        vertexKeyT sj = vertexKeyT();
+        int64_t mostCommons = std::numeric_limits<int64_t>::min();
+        int sumOfDegrees = -1;
+        bool found = false;
+        // true if x,y is taken over the best so far
+        bool better(int64_t commons, int testSumOfDegrees) const {
+            if (!found) {
+                return true;
+            }
+            if(commons > mostCommons) {
+                return true;
+            } else if(commons == mostCommons) {
+                // tie breaker
+                if(sumOfDegrees < testSumOfDegrees) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+    std::vector<vertexKeyT> order;
+    std::vector<uint64_t> edgeOffset;
+    verticiesWithEdgeOffsets(gPrime, order, edgeOffset);
+    profileCount(counterEdgesScanned, edgeOffset.back());
+    std::vector<size_t> chunkStart;
+    splitByWeight(edgeOffset, (pool == nullptr) ? 1 : pool->size() * scanChunksPerThread, chunkStart);
+
+    std::vector<bestPairT> chunkBest(chunkStart.size() - 1);
+    std::function<void(size_t)> scanChunk = [&](size_t c) {
+        bestPairT& best = chunkBest[c];
+        commonWeightClass<graphT> commonWeight(gPrime);
+        for (size_t i = chunkStart[c]; i < chunkStart[c + 1]; ++i) {
+            const vertexKeyT& x = order[i];
+            int xDegree = (int) (edgeOffset[i + 1] - edgeOffset[i]);
+            if (weighted) {
+                commonWeight.setVertex(x);
+            }
+            gPrime.forEachNeighbor(x, [&](const vertexKeyT& y) {
+                int64_t commons = weighted ? commonWeight.weight(y) : gPrime.commonNeighborCount(x, y);
+                int testSumOfDegrees = xDegree + gPrime.degree(y);
+                if(best.better(commons, testSumOfDegrees)) {
+                    best.found = true;
+                    best.mostCommons = commons;
+                    best.si = x;
+                    best.sj = y;
+                    best.sumOfDegrees = testSumOfDegrees;
+                }
+            });
+        }
+    };
+    if (pool == nullptr) {
+        scanChunk(0);
+    } else {
+        pool->parallelFor(chunkBest.size(), scanChunk);
+    }
+
+    bestPairT best;
+    for (const auto &b : chunkBest) {
+        if (b.found && best.better(b.mostCommons, b.sumOfDegrees)) {
+            best = b;
+        }
+    }
+    si = best.si;
+    sj = best.sj;
+    mostCommons = best.mostCommons;
+}
+
+//
+// numThreads is the number of threads scoring the edges, 0 for one per
+// core. The cliques do not depend on it. If weighted, the pair merged
+// is the one with the most weighted common neighbors. Returns false if
+// control cancelled the run
+//
+template <typename graphT>
+bool TsengAlgorithm (const graphT& g,
+                     cliquePartitionClass& cliques,
+                     unsigned int numThreads = 0,
+                     bool weighted = false,
+                     const cliqueRunControlT* control = nullptr
+                     )
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    graphT gPrime;
+    {
+        profileTimerClass timer("TsengAlgorithm copy");
+        gPrime = g; // work on copy
+    }
+    cliqueMembersClass<graphT> members(g, cliques);
+    std::unique_ptr<threadPoolClass> pool;
+    if ((numThreads != 1) && (gPrime.numEdges() >= tsengMinParallelEdges)) {
+        pool.reset(new threadPoolClass(numThreads));
+    }
+    uint64_t tieSeed = (control == nullptr) ? 0 : control->tieSeed;
+    tsengScoreClass<graphT> scores(gPrime, pool.get(), weighted, tieSeed);
+	int loops = 0;
+	while (gPrime.numEdges() > 0) {
+		if (runCancelled(control)) {
+			cliques.clear();
+			return false;
+		}
+		++loops;
+		profileTimerClass timer("TsengAlgorithm loop", loops);
+		if (logging(logDebug)) {
+			printf("TsengAlgorithm(): Loop %i\n", loops);
+		}
+		if (validating()) {
+			gPrime.checkGraph();
+		}
+		if (logging(logTrace)) {
+			gPrime.writeGraph(stdout);
+		}
+        vertexKeyT si = vertexKeyT(), sj = vertexKeyT();
+        int64_t mostCommons = -1;
+        scores.bestPair(si, sj, mostCommons);
+        if(logging(logDebug)) {
+            printf("TsengAlgorithm(): Most Commons is %s and %s with %lli common neighbors\n", gPrime.vertexName(si).c_str(), gPrime.vertexName(sj).c_str(), (long long) mostCommons);
+        }
+        if(validating() && (tieSeed == 0)) {
+            vertexKeyT checkSi = vertexKeyT(), checkSj = vertexKeyT();
+            int64_t checkMostCommons = -1;
+            tsengBestPair(gPrime, checkSi, checkSj, checkMostCommons, pool.get(), weighted);
+            if (!(checkSi == si) || !(checkSj == sj)) {
+                printf("TsengAlgorithm(): scan found %s and %s with %lli common neighbors\n", gPrime.vertexName(checkSi).c_str(), gPrime.vertexName(checkSj).c_str(), (long long) checkMostCommons);
+            }
+        }
+        //
+        // Update gPrime by merging si and sj into one super node
+        //
+        vertexKeyT n = scores.mergeVerticies(si, sj);
+        members.merge(si, sj, n);
+    }
+    //
+    // All edges gone from gPrime, what remains are the
+    // clique super nodes
+    //
+    members.finish(gPrime, cliques);
+    profileTimerClass timer("TsengAlgorithm teardown");
+    gPrime = graphT();
+    return true;
+}
+
+//
+// If weighted, q is the neighbor of p of smallest degree, ties going to
+// the most weighted common neighbors with p. Returns false if control
+// cancelled the run
+//
+template <typename graphT>
+bool BhaskerAlgorithm(const graphT& g,
+	cliquePartitionClass& cliques,
+	bool weighted = false,
+	const cliqueRunControlT* control = nullptr
+	)
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+	graphT gPrime;
+	{
+		profileTimerClass timer("BhaskerAlgorithm copy");
+		gPrime = g; // work on copy
+	}
+	cliqueMembersClass<graphT> members(g, cliques);
+	gPrime.enableDegreeBuckets();
+	commonWeightClass<graphT> commonWeight(gPrime);
+	uint64_t tieSeed = (control == nullptr) ? 0 : control->tieSeed;
+	int loops = 0;
+	while (gPrime.numEdges() > 0) {
+        vertexKeyT p = vertexKeyT(), q = vertexKeyT();
+		if (runCancelled(control)) {
+			cliques.clear();
+			return false;
+		}
+
+		++loops;
+		profileTimerClass timer("BhaskerAlgorithm loop", loops);
+		if (logging(logDebug)) {
+			printf("BhaskerAlgorithm(): Loop %i\n", loops);
+		}
+		if (validating()) {
+			gPrime.checkGraph();
+		}
+		if (logging(logTrace)) {
+			gPrime.writeGraph(stdout);
+        }
+		int pDegree = maxInt();
+		// find the vertex with the smallest non-zero degree, call it p
+		// there must be at least one since there is at least one edge in gPrime
+		bool pFound = gPrime.minDegreeVertex(p, pDegree);
+		assert(pFound); // there should have been at least one vertex of non-zero degree
+		assert(pDegree > 0);
+		if (validating()) {
+			// check the degree buckets against a scan of the verticies
+			vertexKeyT checkP = vertexKeyT();
+			int checkPDegree = maxInt();
+			gPrime.forEachVertex([&](const vertexKeyT& x, int xDegree) {
+				if ((xDegree > 0) && (xDegree < checkPDegree)) {
+					checkP = x;
+					checkPDegree = xDegree;
+				}
+			});
+			if (!(checkP == p)) {
+				printf("BhaskerAlgorithm(): degree buckets found %s but scan found %s\n", gPrime.vertexName(p).c_str(), gPrime.vertexName(checkP).c_str());
+			}
+		}
+		// find q
+		int qDegree = maxInt();
+		int64_t qCommonNeighbors = std::numeric_limits<int64_t>::min();
+		uint64_t qTie = 0;
+		if (weighted) {
+			commonWeight.setVertex(p);
+		}
+		profileCount(counterEdgesScanned, pDegree);
+		// q is
+		//  1. not the same as p
+		//  2. neighbor of p with smallest degree
+		//  3. tie breaker: has most common neighbors with p
+		//  4. tie breaker: first one we find, or with a tieSeed the
+		//     least tieHash
+		gPrime.forEachNeighbor(p, [&](const vertexKeyT& y) {
+			if (p == y) {
+				// we found the back pointer to p
+				return;
+			}
+			int64_t commons = weighted ? commonWeight.weight(y) : gPrime.commonNeighborCount(p, y);
+			uint64_t tie = (tieSeed == 0) ? 0 : tieHash(tieSeed, y);
+			bool newqFound = false;
+			// if degree is smaller, y is our new q
+			if (gPrime.degree(y) < qDegree) {
+				newqFound = true;
+			} else if (gPrime.degree(y) == qDegree) {
+				// tiebreaker: if y has more common neighbors with p
+				if (commons > qCommonNeighbors) {
+					newqFound = true;
+				} else if ((commons == qCommonNeighbors) && (tie < qTie)) {
+					newqFound = true;
+				}
+			}
+			if (newqFound) {
+                q = y;
+				qCommonNeighbors = commons;
+				qTie = tie;
+				newqFound = false;
+				if (weighted || (tieSeed != 0)) {
+					// the plain unseeded variant leaves qDegree alone, so
+					// takes the last neighbor of p; its cliques are kept as
+					// they were
+					qDegree = gPrime.degree(y);
+				}
+			}
+		});
+		vertexKeyT n = gPrime.mergeVerticies(p, q);
+		members.merge(p, q, n);
+	}
+	//
+	// All edges gone from gPrime, what remains are the
+	// clique super nodes
+	//
+	members.finish(gPrime, cliques);
+	profileTimerClass timer("BhaskerAlgorithm teardown");
+	gPrime = graphT();
+	return true;
+}
+
+//
+// the heuristics by name, for drivers that choose one at run time
+//
+enum cliqueAlgorithmT {
+    cliqueAlgorithmTseng,
+    cliqueAlgorithmBhasker,
+    cliqueAlgorithmWeightedTseng,
+    cliqueAlgorithmWeightedBhasker
+};
+
+inline const char* cliqueAlgorithmName(cliqueAlgorithmT algorithm) {
+    static const char* const names[] = { "Tseng", "Bhasker", "weighted Tseng", "weighted Bhasker" };
+    return names[algorithm];
+}
+
+// returns false if control cancelled the run
+template <typename graphT>
+bool runCliqueAlgorithm(cliqueAlgorithmT algorithm,
+                        const graphT& g,
+                        cliquePartitionClass& cliques,
+                        unsigned int numThreads = 0,
+                        const cliqueRunControlT* control = nullptr
+                        )
+{
+    switch (algorithm) {
+        case cliqueAlgorithmTseng:
+            return TsengAlgorithm(g, cliques, numThreads, false, control);
+        case cliqueAlgorithmBhasker:
+            return BhaskerAlgorithm(g, cliques, false, control);
+        case cliqueAlgorithmWeightedTseng:
+            return TsengAlgorithm(g, cliques, numThreads, true, control);
+        case cliqueAlgorithmWeightedBhasker:
+            return BhaskerAlgorithm(g, cliques, true, control);
+    }
+    return false;
+}
+
+#endif /* defined(__CliquePartitioning__cliquepartition__) */
@@ -0,0 +1,151 @@
+//
+//  components.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__components__
+#define __CliquePartitioning__components__
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <unordered_map>
+#include <algorithm>
+#include "cliquepartition.h"
+#include "threadpool.h"
+#include "partition.h"
+
+//
+// Clique partitioning one connected component at a time.
+//
+// A merge joins two adjacent verticies, so no clique crosses a
+// component, and neither heuristic lets one component's state decide a
+// choice in another:
+//   - Tseng's best pair in a component depends only on the common
+//     neighbors and degrees there, and ties go by key order, which
+//     ranks the pairs of a component the same with or without the rest
+//   - Bhasker's p is the first vertex in key order of least degree; the
+//     component it is in would pick the same p on its own
+// So each component, run alone, makes the same merges in the same order
+// as it does inside the whole graph, and the cliques of all of them,
+// sorted by key, are the cliques of the whole graph in the order the
+// algorithms list them.
+//
+// The components are copied out with inducedSubgraph, which keeps the
+// edge order the tie breaks depend on, and run on a thread pool, the
+// largest first. A graph with only one component with edges is run
+// whole, with its threads given to the algorithm instead.
+//
+
+//
+// the connected components of g, each listed from its first vertex in
+// key order in breadth first order; the components in order of their
+// first vertex
+//
+template <typename graphT>
+void connectedComponents(const graphT& g,
+                         std::vector<std::vector<typename graphT::vertexKeyT> >& components
+                         )
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    components.clear();
+    std::unordered_set<vertexKeyT> seen;
+    g.forEachVertex([&](const vertexKeyT& x, int) {
+        if (!seen.insert(x).second) {
+            return;
+        }
+        components.push_back(std::vector<vertexKeyT>(1, x));
+        std::vector<vertexKeyT>& c = components.back();
+        for (size_t i = 0; i < c.size(); ++i) {
+            vertexKeyT y = c[i]; // c grows under the loop
+            g.forEachNeighbor(y, [&](const vertexKeyT& z) {
+                if (seen.insert(z).second) {
+                    c.push_back(z);
+                }
+            });
+        }
+    });
+}
+
+//
+// runs algorithm on each connected component of g on numThreads
+// threads, 0 for one per core, and gives the cliques in key order, the
+// same as running algorithm on g
+//
+// The member IDs of a component are its verticies numbered in key
+// order, so member m of a component is the m-th smallest ID of the
+// component in g.
+//
+template <typename graphT>
+void partitionByComponents(const graphT& g,
+                           cliqueAlgorithmT algorithm,
+                           cliquePartitionClass& cliques,
+                           unsigned int numThreads = 0
+                           )
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    typedef cliquePartitionClass::memberT memberT;
+    std::vector<std::vector<vertexKeyT> > components;
+    connectedComponents(g, components);
+
+    // a vertex alone is a clique as it is; the others are sorted by edges, most first
+    std::vector<size_t> order;
+    std::vector<uint64_t> edges(components.size(), 0);
+    for (size_t c = 0; c < components.size(); ++c) {
+        if (components[c].size() == 1) {
+            continue;
+        }
+        for (const auto &x : components[c]) {
+            edges[c] += g.degree(x);
+        }
+        order.push_back(c);
+    }
+    if (order.size() <= 1) {
+        runCliqueAlgorithm(algorithm, g, cliques, numThreads);
+        return;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return edges[a] > edges[b];
+    });
+
+    std::vector<cliquePartitionClass> componentCliques(order.size());
+    {
+        threadPoolClass pool(numThreads);
+        pool.parallelFor(order.size(), [&](size_t k) {
+            graphT sub;
+            g.inducedSubgraph(components[order[k]], sub);
+            runCliqueAlgorithm(algorithm, sub, componentCliques[k], 1);
+        });
+    }
+
+    cliques.clear();
+    std::unordered_map<vertexKeyT, memberT> memberOf;
+    g.forEachVertex([&](const vertexKeyT& x, int) {
+        memberOf[x] = cliques.addName(g.vertexName(x));
+    });
+    std::vector<memberT> componentMembers;
+    for (const auto &c : components) {
+        if (c.size() == 1) {
+            cliques.addMember(memberOf[c[0]]);
+            cliques.endClique();
+        }
+    }
+    for (size_t k = 0; k < order.size(); ++k) {
+        componentMembers.clear();
+        for (const auto &x : components[order[k]]) {
+            componentMembers.push_back(memberOf[x]);
+        }
+        std::sort(componentMembers.begin(), componentMembers.end());
+        const cliquePartitionClass& cc = componentCliques[k];
+        for (size_t c = 0; c < cc.numCliques(); ++c) {
+            for (const memberT* m = cc.cliqueBegin(c); m != cc.cliqueEnd(c); ++m) {
+                cliques.addMember(componentMembers[*m]);
+            }
+            cliques.endClique();
+        }
+    }
+    cliques.sortCliques();
+}
+
+#endif /* defined(__CliquePartitioning__components__) */
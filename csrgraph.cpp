@@ -0,0 +1,1256 @@
+//
+//  csrgraph.cpp
+//  CliquePartitioning
+//
+
+#include "csrgraph.h"
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <unordered_set>
+
+const csrGraphClass::vertexKeyT csrGraphClass::noVertex;
+const uint32_t csrGraphClass::hubMinDegree;
+
+//
+// interns the verticies in key order and copies each edge list in order
+//
+csrGraphClass::csrGraphClass(const graphDatabaseClass& g) {
+    initializeGraph((int) g.verticies.size(), g.directed);
+    for (const auto &vtr : g.verticies) {
+        insertVertex(vtr.first);
+    }
+    uint64_t slot = 0;
+    for (const auto &vtr : g.verticies) {
+        rowRecord& r = rows[ownNameToId[vtr.first]];
+        r.start = slot;
+        r.capacity = r.degree = (uint32_t) vtr.second.degree;
+        slot += r.capacity;
+    }
+    ownTargets.resize(slot);
+    ownWeights.resize(slot);
+    ownSortedTargets.resize(slot);
+    for (const auto &vtr : g.verticies) {
+        const rowRecord& r = rows[ownNameToId[vtr.first]];
+        uint64_t s = r.start;
+        for (auto e = vtr.second.edgeList; e != graphDatabaseClass::noEdge; e = g.edge(e).next) {
+            ownTargets[s] = ownNameToId[g.edgeVertex(g.edge(e))];
+            ownWeights[s] = g.edge(e).weight;
+            ++s;
+        }
+    }
+    for (vertexKeyT x = 0; x < rows.size(); ++x) {
+        sortRow(x);
+        updateHub(x);
+    }
+    edgeCount = g.edgeCount;
+    freeze();
+}
+
+//
+// Each edge sits in the rows of both its ends, so it must come after the
+// edges before it in either row; those are the only orders that decide
+// the rows, and the order the edges were inserted in meets them all.
+// Any order that meets them builds the same rows, and one is found by
+// taking each edge once the edges before it in both its rows are taken.
+// The k-th entry for y in the row of x is paired with the k-th entry for
+// x in the row of y, and the entries of a self loop, both in its own
+// row, are paired in twos
+//
+bool csrGraphClass::listEdges(std::vector<std::string>& names, std::vector<graphDatabaseClass::edgeT>& edges) const {
+    names.clear();
+    edges.clear();
+    if (!superNodes.empty()) {
+        printf("listEdges(): the graph has super nodes\n");
+        return false;
+    }
+    std::vector<vertexKeyT> keys;
+    std::vector<uint32_t> index(rows.size(), noVertex); // of each vertex in names
+    forEachVertex([&](vertexKeyT x, int) {
+        index[x] = (uint32_t) names.size();
+        names.push_back(memberName(x));
+        keys.push_back(x);
+    });
+    // every entry of every row, by the ends of its edge, smaller index
+    // first, and then by which end's row it is in and where
+    struct entryT {
+        uint32_t lo;
+        uint32_t hi;
+        uint32_t side;  // 0 in the row of lo, 1 in the row of hi
+        int weight;
+        uint64_t slot;  // rows laid end to end in the order of names
+    };
+    std::vector<uint64_t> rowStart(keys.size() + 1, 0);
+    std::vector<entryT> entries;
+    for (uint32_t a = 0; a < keys.size(); ++a) {
+        const rowRecord& r = rows[keys[a]];
+        const vertexKeyT* t = rowTargets(r);
+        const int* w = rowWeights(r);
+        rowStart[a + 1] = rowStart[a] + r.degree;
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            uint32_t b = index[t[i]];
+            entries.push_back(entryT{ std::min(a, b), std::max(a, b), (a <= b) ? 0u : 1u, w[i], rowStart[a] + i });
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const entryT& x, const entryT& y) {
+        return (x.lo != y.lo) ? (x.lo < y.lo) : (x.hi != y.hi) ? (x.hi < y.hi) :
+               (x.side != y.side) ? (x.side < y.side) : (x.slot < y.slot);
+    });
+
+    // the edge of each slot, and the two slots of each edge
+    std::vector<uint32_t> edgeOf(rowStart.back());
+    std::vector<uint64_t> slotsOf;
+    std::vector<graphDatabaseClass::edgeT> found;
+    for (size_t i = 0; i < entries.size(); ) {
+        size_t j = i;
+        while ((j < entries.size()) && (entries[j].lo == entries[i].lo) && (entries[j].hi == entries[i].hi)) {
+            ++j;
+        }
+        size_t k = i;
+        while ((k < j) && (entries[k].side == 0)) {
+            ++k;
+        }
+        bool loop = (entries[i].lo == entries[i].hi);
+        if (loop ? ((j - i) % 2 != 0) : (k - i != j - k)) {
+            printf("listEdges(): the rows of %s and %s do not agree\n", names[entries[i].lo].c_str(), names[entries[i].hi].c_str());
+            names.clear();
+            return false;
+        }
+        size_t numPairs = loop ? (j - i) / 2 : k - i;
+        for (size_t p = 0; p < numPairs; ++p) {
+            const entryT& first = loop ? entries[i + 2 * p] : entries[i + p];
+            const entryT& second = loop ? entries[i + 2 * p + 1] : entries[k + p];
+            edgeOf[first.slot] = edgeOf[second.slot] = (uint32_t) found.size();
+            slotsOf.push_back(first.slot);
+            slotsOf.push_back(second.slot);
+            graphDatabaseClass::edgeT e;
+            e.from = first.lo;
+            e.to = first.hi;
+            e.weight = first.weight;
+            found.push_back(e);
+        }
+        i = j;
+    }
+    std::vector<entryT>().swap(entries);
+
+    // the edges each edge waits for: the one before it in each of its rows
+    std::vector<uint8_t> waiting(found.size(), 0);
+    std::vector<uint64_t> rowEnd(rowStart.back()); // of the row of each slot
+    for (uint32_t a = 0; a < keys.size(); ++a) {
+        for (uint64_t s = rowStart[a]; s < rowStart[a + 1]; ++s) {
+            rowEnd[s] = rowStart[a + 1];
+            if ((s > rowStart[a]) && (edgeOf[s - 1] != edgeOf[s])) {
+                ++waiting[edgeOf[s]];
+            }
+        }
+    }
+    std::vector<uint32_t> ready;
+    for (uint32_t e = 0; e < found.size(); ++e) {
+        if (waiting[e] == 0) {
+            ready.push_back(e);
+        }
+    }
+    edges.reserve(found.size());
+    for (size_t next = 0; next < ready.size(); ++next) {
+        uint32_t e = ready[next];
+        edges.push_back(found[e]);
+        for (int end = 0; end < 2; ++end) {
+            uint64_t s = slotsOf[2 * e + end] + 1;
+            if ((s < rowEnd[s - 1]) && (edgeOf[s] != e) && (--waiting[edgeOf[s]] == 0)) {
+                ready.push_back(edgeOf[s]);
+            }
+        }
+    }
+    if (edges.size() != found.size()) {
+        printf("listEdges(): no order of the edges gives every row\n");
+        names.clear();
+        edges.clear();
+        return false;
+    }
+    return true;
+}
+
+//
+// the copy of superNodes and degreeBuckets still orders by other until
+// rebindKeyOrder points them here
+//
+csrGraphClass::csrGraphClass(const csrGraphClass& other) :
+    edgeCount(other.edgeCount),
+    directed(other.directed),
+    intersectKernel(other.intersectKernel),
+    compressRows(other.compressRows),
+    base(other.base),
+    ownNames(other.ownNames),
+    ownNameToId(other.ownNameToId),
+    liveVerticies(other.liveVerticies),
+    rows(other.rows),
+    ownTargets(other.ownTargets),
+    ownWeights(other.ownWeights),
+    ownSortedTargets(other.ownSortedTargets),
+    deadSlots(other.deadSlots),
+    ownHubBits(other.ownHubBits),
+    members(other.members),
+    superNodes(other.superNodes),
+    trackDegrees(other.trackDegrees),
+    degreeBuckets(other.degreeBuckets) {
+    rebindKeyOrder();
+}
+
+//
+// points the ordered sets at this graph. They are in key order already,
+// so they are rebuilt in linear time
+//
+void csrGraphClass::rebindKeyOrder() {
+    superNodes = std::set<vertexKeyT, keyLessT>(superNodes.begin(), superNodes.end(), keyLessT{this});
+    degreeBuckets.setLess(keyLessT{this});
+}
+
+std::shared_ptr<const csrGraphClass::sharedBaseT> csrGraphClass::emptyBase() {
+    static const std::shared_ptr<const sharedBaseT> empty = std::make_shared<sharedBaseT>();
+    return empty;
+}
+
+//
+// A base that no copy shares any more is emptied and kept, and the next
+// freeze fills it instead of a new one. Emptying keeps the capacity of
+// its arrays, so a graph that is loaded again and again, as by the
+// workers of batch.h, reuses them
+//
+void csrGraphClass::initializeGraph(int numVerticies, bool isDirected) {
+    directed = isDirected;
+    edgeCount = 0;
+    if ((base.use_count() == 1) && (base != emptyBase())) {
+        spareBase = std::const_pointer_cast<sharedBaseT>(base);
+        spareBase->names.clear();
+        spareBase->nameToId.clear();
+        spareBase->targets.clear();
+        spareBase->weights.clear();
+        spareBase->sortedTargets.clear();
+        spareBase->hubBits.clear();
+        spareBase->packedSorted.clear();
+        spareBase->packedSortedAt.clear();
+        spareBase->mapping.reset();
+        spareBase->pointAtArrays();
+    }
+    base = emptyBase();
+    ownNames.clear();
+    ownNameToId.clear();
+    liveVerticies = 0;
+    rows.clear();
+    ownTargets.clear();
+    ownWeights.clear();
+    ownSortedTargets.clear();
+    ownHubBits.clear();
+    deadSlots = 0;
+    members.clear();
+    superNodes.clear();
+    degreeBuckets.clear();
+    ownNames.reserve(numVerticies);
+    rows.reserve(numVerticies);
+}
+
+csrGraphClass::vertexKeyT csrGraphClass::findVertex(const std::string& x) const {
+    auto vtr = ownNameToId.find(x);
+    if (vtr != ownNameToId.end()) {
+        return vtr->second;
+    }
+    vtr = base->nameToId.find(x);
+    return ((vtr == base->nameToId.end()) || !rows[vtr->second].live) ? noVertex : vtr->second;
+}
+
+//
+// adds vertex x, which must not be in the graph, with no edges
+//
+csrGraphClass::vertexKeyT csrGraphClass::appendVertex(const std::string& x) {
+    vertexKeyT id = (vertexKeyT) rows.size();
+    ownNames.push_back(x);
+    rows.push_back(rowRecord());
+    rows.back().live = true;
+    ownNameToId[x] = id;
+    ++liveVerticies;
+    return id;
+}
+
+csrGraphClass::vertexKeyT csrGraphClass::insertVertex(const std::string& x) {
+    if (logging(logTrace)) {
+        printf("adding vertex %s\n", x.c_str());
+    }
+    vertexKeyT id = findVertex(x);
+    if (id != noVertex) {
+        printf("readGraph(): duplicate vertex name %s; not inserted again\n", x.c_str());
+        return id;
+    }
+    return appendVertex(x);
+}
+
+//
+// adds the super node of si and sj, which have been removed, with no
+// edges. Its members are those of si followed by those of sj
+//
+csrGraphClass::vertexKeyT csrGraphClass::appendSuperNode(vertexKeyT si, vertexKeyT sj) {
+    vertexKeyT id = (vertexKeyT) rows.size();
+    ownNames.push_back(std::string());
+    rows.push_back(rowRecord());
+    rows.back().live = true;
+    memberRecord none = { noVertex, noVertex, noVertex };
+    members.resize(rows.size(), none);
+    members[id].first = firstMember(si);
+    members[id].last = lastMember(sj);
+    members[lastMember(si)].next = firstMember(sj);
+    superNodes.insert(id);
+    ++liveVerticies;
+    return id;
+}
+
+//
+// The member names of a vertex, for joinedNameLess
+//
+struct csrGraphClass::memberNameListT {
+    const csrGraphClass* g;
+    vertexKeyT m;
+    const std::string* next() {
+        if (m == noVertex) {
+            return nullptr;
+        }
+        const std::string* name = &g->memberName(m);
+        m = g->nextMember(m);
+        return name;
+    }
+};
+
+bool csrGraphClass::joinedKeyLess(vertexKeyT x, vertexKeyT y) const {
+    // the first names decide unless one begins the other
+    const std::string& nx = memberName(firstMember(x));
+    const std::string& ny = memberName(firstMember(y));
+    int c = memcmp(nx.data(), ny.data(), std::min(nx.size(), ny.size()));
+    if (c != 0) {
+        return c < 0;
+    }
+    return joinedNameLess(memberNameListT{this, firstMember(x)}, memberNameListT{this, firstMember(y)});
+}
+
+std::string csrGraphClass::vertexName(vertexKeyT x) const {
+    if (!isSuperNode(x)) {
+        return memberName(x);
+    }
+    std::string name = memberName(firstMember(x));
+    for (vertexKeyT m = nextMember(firstMember(x)); m != noVertex; m = nextMember(m)) {
+        name += ",";
+        name += memberName(m);
+    }
+    return name;
+}
+
+//
+// drops x from the dictionary; its ID is never reused. The name stays,
+// as x may be a member of a super node
+//
+void csrGraphClass::removeVertex(vertexKeyT x) {
+    degreeChanged(x, rows[x].degree, 0);
+    if (isSuperNode(x)) {
+        superNodes.erase(x);
+    } else if (x >= base->names.size()) {
+        ownNameToId.erase(ownNames[x - base->names.size()]);
+    }
+    if (!rows[x].shared) {
+        deadSlots += rows[x].capacity;
+    }
+    rows[x] = rowRecord();
+    ownHubBits.erase(x);
+    --liveVerticies;
+}
+
+bool csrGraphClass::deleteVertex(vertexKeyT x) {
+    if (logging(logTrace)) {
+        printf("deleting vertex %s\n", vertexName(x).c_str());
+    }
+    if (rows[x].degree != 0) {
+        printf("Deleting a vertex with non-empty edgelist\n");
+    }
+    removeVertex(x);
+    if ((x >= base->names.size()) && !isSuperNode(x)) {
+        std::string().swap(ownNames[x - base->names.size()]);
+    }
+    return true;
+}
+
+//
+// gives row x room for at least capacity edges in the own arrays. The
+// row grows in place when it is the last one in the arrays, otherwise
+// it moves to the end. A shared row is copied out of the base
+//
+void csrGraphClass::reserveRow(vertexKeyT x, uint32_t capacity) {
+    rowRecord& r = rows[x];
+    if (!r.shared && (capacity <= r.capacity)) {
+        return;
+    }
+    profileCount(counterEdgeAllocations);
+    capacity = std::max(capacity, r.degree);
+    if (!r.shared && (r.start + r.capacity == ownTargets.size())) {
+        ownTargets.resize(r.start + capacity);
+        ownWeights.resize(r.start + capacity);
+        ownSortedTargets.resize(r.start + capacity);
+    } else {
+        uint64_t newStart = ownTargets.size();
+        ownTargets.resize(newStart + capacity);
+        ownWeights.resize(newStart + capacity);
+        ownSortedTargets.resize(newStart + capacity);
+        // the own arrays may have moved, so take the row pointers after resizing
+        std::copy(rowTargets(r), rowTargets(r) + r.degree, ownTargets.begin() + newStart);
+        std::copy(rowWeights(r), rowWeights(r) + r.degree, ownWeights.begin() + newStart);
+        std::vector<vertexKeyT> scratch;
+        const vertexKeyT* sorted = sortedRow(x, scratch);
+        std::copy(sorted, sorted + r.degree, ownSortedTargets.begin() + newStart);
+        if (r.shared) {
+            if (r.hub) {
+                ownHubBits[x] = base->hubBits.find(x)->second;
+            }
+            r.shared = false;
+        } else {
+            deadSlots += r.capacity;
+        }
+        r.start = newStart;
+    }
+    r.capacity = capacity;
+    if ((deadSlots > 1024) && (2 * deadSlots > ownTargets.size())) {
+        compact();
+    }
+}
+
+//
+// packs the own rows back together in ID order, dropping the dead slots
+//
+void csrGraphClass::compact() {
+    uint64_t slot = 0;
+    for (const auto &r : rows) {
+        if (!r.shared) {
+            slot += r.capacity;
+        }
+    }
+    std::vector<vertexKeyT> newTargets;
+    newTargets.reserve(slot);
+    std::vector<int> newWeights;
+    newWeights.reserve(slot);
+    std::vector<vertexKeyT> newSortedTargets;
+    newSortedTargets.reserve(slot);
+    for (auto &r : rows) {
+        if (r.shared) {
+            continue;
+        }
+        uint64_t newStart = newTargets.size();
+        newTargets.insert(newTargets.end(), ownTargets.begin() + r.start, ownTargets.begin() + r.start + r.degree);
+        newWeights.insert(newWeights.end(), ownWeights.begin() + r.start, ownWeights.begin() + r.start + r.degree);
+        newSortedTargets.insert(newSortedTargets.end(), ownSortedTargets.begin() + r.start, ownSortedTargets.begin() + r.start + r.degree);
+        // keep the slack of each row
+        newTargets.resize(newStart + r.capacity);
+        newWeights.resize(newStart + r.capacity);
+        newSortedTargets.resize(newStart + r.capacity);
+        r.start = newStart;
+    }
+    ownTargets.swap(newTargets);
+    ownWeights.swap(newWeights);
+    ownSortedTargets.swap(newSortedTargets);
+    deadSlots = 0;
+}
+
+void csrGraphClass::insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w) {
+    profileCount(counterEdgeInserts);
+    if (rows[x].shared || (rows[x].degree == rows[x].capacity)) {
+        reserveRow(x, std::max(4u, 2 * rows[x].degree));
+    }
+    rowRecord& r = rows[x];
+    ownTargets[r.start + r.degree] = y;
+    ownWeights[r.start + r.degree] = w;
+    auto sorted = ownSortedTargets.begin() + r.start;
+    auto pos = std::upper_bound(sorted, sorted + r.degree, y);
+    std::copy_backward(pos, sorted + r.degree, sorted + r.degree + 1);
+    *pos = y;
+    ++r.degree;
+    ++edgeCount;
+    if (r.hub) {
+        std::vector<uint64_t>& bits = ownHubBits[x];
+        if ((y >> 6) >= bits.size()) {
+            bits.resize((y >> 6) + 1, 0);
+        }
+        bits[y >> 6] |= (uint64_t) 1 << (y & 63);
+    }
+    degreeChanged(x, r.degree - 1, r.degree);
+    updateHub(x);
+}
+
+void csrGraphClass::insertEdge(vertexKeyT x, vertexKeyT y, int w) {
+    insertEdgeUtility(x, y, w);
+    insertEdgeUtility(y, x, w);
+    if (logging(logTrace)) {
+        printf("adding edge %s to %s\n", vertexName(x).c_str(), vertexName(y).c_str());
+    }
+}
+
+//
+// removes x->y, keeping the rest of the row in order
+//
+bool csrGraphClass::deleteEdgeUtility(vertexKeyT x, vertexKeyT y) {
+    profileCount(counterEdgeDeletes);
+    const vertexKeyT* first = rowTargets(rows[x]);
+    const vertexKeyT* last = first + rows[x].degree;
+    uint32_t i = (uint32_t) (std::find(first, last, y) - first);
+    if (i == rows[x].degree) {
+        if (logging(logWarning)) {
+            printf("deleteEdgeUtility(): Not able to find an edge to delete from %s to %s\n", vertexName(x).c_str(), vertexName(y).c_str());
+        }
+        return false;
+    }
+    if (rows[x].shared) {
+        reserveRow(x, rows[x].degree);
+    }
+    rowRecord& r = rows[x];
+    auto e = ownTargets.begin() + r.start + i;
+    std::copy(e + 1, ownTargets.begin() + r.start + r.degree, e);
+    auto w = ownWeights.begin() + r.start + i;
+    std::copy(w + 1, ownWeights.begin() + r.start + r.degree, w);
+    auto sorted = ownSortedTargets.begin() + r.start;
+    auto pos = std::lower_bound(sorted, sorted + r.degree, y);
+    std::copy(pos + 1, sorted + r.degree, pos);
+    --r.degree;
+    --edgeCount;
+    if (r.hub) {
+        ownHubBits[x][y >> 6] &= ~((uint64_t) 1 << (y & 63));
+    }
+    degreeChanged(x, r.degree + 1, r.degree);
+    updateHub(x);
+    return true;
+}
+
+bool csrGraphClass::deleteEdge(vertexKeyT x, vertexKeyT y) {
+    bool returnVal1 = deleteEdgeUtility(x, y);
+    bool returnVal2 = deleteEdgeUtility(y, x);
+    return (returnVal1 && returnVal2);
+}
+
+// for edge x->y, return true if there is a x->y in the graph
+bool csrGraphClass::edgeExists(vertexKeyT x, vertexKeyT y) {
+    const rowRecord& r = rows[x];
+    if (r.hub) {
+        const std::vector<uint64_t>& bits = rowBits(x);
+        return bitsetTest(bits.data(), 64 * bits.size(), y);
+    }
+    std::vector<vertexKeyT> scratch;
+    const vertexKeyT* first = sortedRow(x, scratch);
+    return std::binary_search(first, first + r.degree, y);
+}
+
+//
+// a vertex becomes a hub when its degree reaches hubDegree() and stops
+// being one when it falls below half that, so a degree hovering around
+// the threshold does not rebuild the bitset each time
+//
+uint32_t csrGraphClass::hubDegree() const {
+    return std::max(hubMinDegree, (uint32_t) (rows.size() / 32));
+}
+
+void csrGraphClass::updateHub(vertexKeyT x) {
+    rowRecord& r = rows[x];
+    if (r.shared) {
+        return; // the base decided, and the row has not changed since
+    }
+    if (!r.hub && (r.degree >= hubDegree())) {
+        std::vector<uint64_t>& bits = ownHubBits[x];
+        bits.assign((rows.size() + 63) / 64, 0);
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            vertexKeyT y = ownSortedTargets[r.start + i];
+            bits[y >> 6] |= (uint64_t) 1 << (y & 63);
+        }
+        r.hub = true;
+    } else if (r.hub && (r.degree < hubDegree() / 2)) {
+        ownHubBits.erase(x);
+        r.hub = false;
+    }
+}
+
+const csrGraphClass::vertexKeyT* csrGraphClass::sortedRow(vertexKeyT x, std::vector<vertexKeyT>& scratch) const {
+    const rowRecord& r = rows[x];
+    if (!r.shared || base->packedSortedAt.empty()) {
+        return rowSortedTargets(r);
+    }
+    scratch.resize(r.degree);
+    streamVByteDecodeSorted(base->packedSorted.data() + base->packedSortedAt[x], r.degree, scratch.data());
+    return scratch.data();
+}
+
+void csrGraphClass::sortRow(vertexKeyT x) {
+    const rowRecord& r = rows[x];
+    std::copy(ownTargets.begin() + r.start, ownTargets.begin() + r.start + r.degree, ownSortedTargets.begin() + r.start);
+    std::sort(ownSortedTargets.begin() + r.start, ownSortedTargets.begin() + r.start + r.degree);
+}
+
+//
+// deletes all the edges to and from from vertex x. The row of x is
+// emptied, not copied, even when it is shared
+//
+void csrGraphClass::disconnectVertex(vertexKeyT x) {
+    rowRecord& r = rows[x];
+    for (uint32_t i = 0; i < r.degree; ++i) {
+        vertexKeyT y = rowTargets(r)[i];
+        if (y != x) {
+            deleteEdgeUtility(y, x); // delete the back edge
+        }
+    }
+    edgeCount -= r.degree;
+    degreeChanged(x, r.degree, 0);
+    r.degree = 0;
+    if (r.hub) {
+        ownHubBits.erase(x);
+        r.hub = false;
+    }
+}
+
+void csrGraphClass::enableDegreeBuckets() {
+    degreeBuckets.clear();
+    forEachVertex([&](vertexKeyT x, int xDegree) {
+        degreeBuckets.update(x, 0, xDegree);
+    });
+    trackDegrees = true;
+}
+
+bool csrGraphClass::minDegreeVertex(vertexKeyT& x, int& xDegree) {
+    return degreeBuckets.first(x, xDegree);
+}
+
+//
+// neighbors of si that are also neighbors of sj, in the edge order of si.
+// mergeVerticies inserts the super node edges in this order, so the list
+// is made by marking instead of with the sorted kernels
+//
+void csrGraphClass::markNeighbors(vertexKeyT x) {
+    if (mark.size() < rows.size()) {
+        mark.resize(rows.size(), 0);
+        markWeight.resize(rows.size(), 0);
+    }
+    if (++markEpoch == 0) {
+        std::fill(mark.begin(), mark.end(), 0);
+        markEpoch = 1;
+    }
+    const rowRecord& r = rows[x];
+    const vertexKeyT* t = rowTargets(r);
+    const int* w = rowWeights(r);
+    for (uint32_t i = 0; i < r.degree; ++i) {
+        mark[t[i]] = markEpoch;
+        markWeight[t[i]] = w[i];
+    }
+}
+
+void csrGraphClass::commonNeighbor(vertexKeyT si, vertexKeyT sj, std::vector<vertexKeyT>& returnVal) {
+    returnVal.clear();
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) rows[si].degree + rows[sj].degree);
+    markNeighbors(sj);
+    const rowRecord& ri = rows[si];
+    const vertexKeyT* ti = rowTargets(ri);
+    for (uint32_t i = 0; i < ri.degree; ++i) {
+        if (mark[ti[i]] == markEpoch) {
+            returnVal.push_back(ti[i]);
+        }
+    }
+}
+
+int csrGraphClass::commonNeighborCount(vertexKeyT si, vertexKeyT sj) const {
+    // rows of the base decoded here, one pair for each scanning thread
+    static thread_local std::vector<vertexKeyT> scratchA;
+    static thread_local std::vector<vertexKeyT> scratchB;
+    vertexKeyT a = si;
+    vertexKeyT b = sj;
+    if (rows[a].degree > rows[b].degree) {
+        std::swap(a, b);
+    }
+    const rowRecord* ra = &rows[a];
+    const rowRecord* rb = &rows[b];
+    const uint32_t* sa = sortedRow(a, scratchA);
+    profileCount(counterCommonNeighborCalls);
+    intersectKernelT kernel = intersectKernel;
+    if ((kernel == intersectKernelAuto) || (kernel == intersectKernelBitset)) {
+        if (rb->hub) {
+            profileCount(counterIntersectionWork, ra->degree);
+            // probe the short list into the bitset of the long one
+            const std::vector<uint64_t>& bits = rowBits(b);
+            return (int) intersectCountBitset(sa, ra->degree, bits.data(), 64 * bits.size());
+        }
+        kernel = intersectChooseKernel(ra->degree, rb->degree);
+    }
+    const uint32_t* sb = sortedRow(b, scratchB);
+    profileCount(counterIntersectionWork, (uint64_t) ra->degree + rb->degree);
+    switch (kernel) {
+        case intersectKernelGalloping:
+            return (int) intersectCountGalloping(sa, ra->degree, sb, rb->degree);
+        case intersectKernelSimd:
+            return (int) intersectCountSimd(sa, ra->degree, sb, rb->degree);
+        default:
+            return (int) intersectCountMerge(sa, ra->degree, sb, rb->degree);
+    }
+}
+
+//
+// Merge si and sj into a super node by
+//   1. deleting all edges linking si and sj in graph
+//   2. merging verticies si and sj into one super node
+//   3. linking in the supernode with the common neighbor links
+//
+csrGraphClass::vertexKeyT csrGraphClass::mergeVerticies(vertexKeyT si, vertexKeyT sj) {
+    // the common neighbors in the order of si, with w(si,c) + w(sj,c)
+    std::vector<vertexKeyT> commonNeighbors;
+    std::vector<int> commonWeights;
+    profileCount(counterMerges);
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) rows[si].degree + rows[sj].degree);
+    markNeighbors(sj);
+    const rowRecord& ri = rows[si];
+    const vertexKeyT* ti = rowTargets(ri);
+    const int* wi = rowWeights(ri);
+    for (uint32_t i = 0; i < ri.degree; ++i) {
+        if (mark[ti[i]] == markEpoch) {
+            commonNeighbors.push_back(ti[i]);
+            commonWeights.push_back(wi[i] + markWeight[ti[i]]);
+        }
+    }
+    disconnectVertex(si); removeVertex(si);
+    disconnectVertex(sj); removeVertex(sj);
+    vertexKeyT newVertex = appendSuperNode(si, sj);
+    reserveRow(newVertex, (uint32_t) commonNeighbors.size());
+    // insert edges to the common neighbers. Each neighbor just lost
+    // its edges to si and sj, so its row has room for the new one
+    for (size_t c = 0; c < commonNeighbors.size(); ++c) {
+        insertEdge(newVertex, commonNeighbors[c], commonWeights[c]);
+    }
+    return newVertex;
+}
+
+//
+// Copies the rows of members into sub, renumbered, keeping the order of
+// each row and leaving out edges to verticies not in members. The
+// sorted rows are sorted again, since the new IDs need not be in the
+// order of the old ones. A super node becomes a vertex with its name.
+//
+void csrGraphClass::inducedSubgraph(const std::vector<vertexKeyT>& members, csrGraphClass& sub) const {
+    sub.initializeGraph((int) members.size(), directed);
+    std::unordered_map<vertexKeyT, vertexKeyT> subId;
+    for (vertexKeyT x : members) {
+        subId[x] = sub.appendVertex(vertexName(x));
+    }
+    for (vertexKeyT x : members) {
+        const rowRecord& r = rows[x];
+        rowRecord& s = sub.rows[subId[x]];
+        s.vertexBits = r.vertexBits;
+        s.start = sub.ownTargets.size();
+        const vertexKeyT* t = rowTargets(r);
+        const int* w = rowWeights(r);
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            auto ytr = subId.find(t[i]);
+            if (ytr == subId.end()) {
+                continue;
+            }
+            sub.ownTargets.push_back(ytr->second);
+            sub.ownWeights.push_back(w[i]);
+            ++s.degree;
+        }
+        s.capacity = s.degree;
+    }
+    sub.ownSortedTargets.assign(sub.ownTargets.size(), 0);
+    for (vertexKeyT x = 0; x < sub.rows.size(); ++x) {
+        sub.sortRow(x);
+        sub.updateHub(x);
+    }
+    sub.edgeCount = (int) sub.ownTargets.size();
+    sub.freeze();
+}
+
+//
+// Bulk construction: sizes every row exactly and fills the rows in
+// the order of edges, giving the same rows as calling insertEdge on
+// each edge in turn
+//
+void csrGraphClass::buildFromEdges(const std::vector<edgeT>& edges) {
+    for (auto &r : rows) {
+        r.start = 0;
+        r.degree = 0;
+        r.capacity = 0;
+        r.hub = false;
+        r.shared = false;
+    }
+    for (const auto &e : edges) {
+        ++rows[e.from].capacity;
+        ++rows[e.to].capacity;
+    }
+    uint64_t slot = 0;
+    for (auto &r : rows) {
+        r.start = slot;
+        slot += r.capacity;
+    }
+    ownTargets.assign(slot, 0);
+    ownWeights.assign(slot, 0);
+    ownSortedTargets.assign(slot, 0);
+    ownHubBits.clear();
+    deadSlots = 0;
+    for (const auto &e : edges) {
+        rowRecord& rf = rows[e.from];
+        ownTargets[rf.start + rf.degree] = e.to;
+        ownWeights[rf.start + rf.degree] = e.weight;
+        ++rf.degree;
+        rowRecord& rt = rows[e.to];
+        ownTargets[rt.start + rt.degree] = e.from;
+        ownWeights[rt.start + rt.degree] = e.weight;
+        ++rt.degree;
+    }
+    for (vertexKeyT x = 0; x < rows.size(); ++x) {
+        sortRow(x);
+        updateHub(x);
+    }
+    edgeCount = (int) slot;
+    freeze();
+    if (trackDegrees) {
+        enableDegreeBuckets();
+    }
+}
+
+//
+// Packs the live rows in ID order with no slack into a new base and
+// merges the dictionaries into it. When nothing is shared yet and the
+// own arrays are packed already, as after buildFromEdges, they are
+// moved into the base instead of copied
+//
+void csrGraphClass::freeze() {
+    std::shared_ptr<sharedBaseT> newBase;
+    newBase.swap(spareBase);
+    if (!newBase) {
+        newBase = std::make_shared<sharedBaseT>();
+    }
+    bool packed = base->names.empty() && (deadSlots == 0);
+    uint64_t slot = 0;
+    for (const auto &r : rows) {
+        packed = packed && !r.shared && (r.capacity == r.degree) && ((r.degree == 0) || (r.start == slot));
+        slot += r.degree;
+    }
+    packed = packed && (slot == ownTargets.size());
+
+    // the dictionary, then the names
+    if (base->names.empty()) {
+        newBase->nameToId.swap(ownNameToId);
+        newBase->names.swap(ownNames);
+    } else {
+        // the super nodes stay out of the dictionary
+        forEachVertex([&](vertexKeyT x, int) {
+            if (!isSuperNode(x)) {
+                newBase->nameToId.insert(newBase->nameToId.end(), std::make_pair(memberName(x), x));
+            }
+        });
+        newBase->names.reserve(rows.size());
+        newBase->names.insert(newBase->names.end(), base->names.begin(), base->names.end());
+        newBase->names.insert(newBase->names.end(), ownNames.begin(), ownNames.end());
+    }
+
+    if (packed) {
+        newBase->targets.swap(ownTargets);
+        newBase->weights.swap(ownWeights);
+        newBase->sortedTargets.swap(ownSortedTargets);
+        newBase->hubBits.swap(ownHubBits);
+        for (auto &r : rows) {
+            r.shared = true;
+        }
+    } else {
+        newBase->targets.reserve(slot);
+        newBase->weights.reserve(slot);
+        newBase->sortedTargets.reserve(slot);
+        std::vector<vertexKeyT> scratch;
+        for (vertexKeyT x = 0; x < rows.size(); ++x) {
+            rowRecord& r = rows[x];
+            uint64_t newStart = newBase->targets.size();
+            newBase->targets.insert(newBase->targets.end(), rowTargets(r), rowTargets(r) + r.degree);
+            newBase->weights.insert(newBase->weights.end(), rowWeights(r), rowWeights(r) + r.degree);
+            const vertexKeyT* sorted = sortedRow(x, scratch);
+            newBase->sortedTargets.insert(newBase->sortedTargets.end(), sorted, sorted + r.degree);
+            if (r.hub) {
+                newBase->hubBits[x] = rowBits(x);
+            }
+            r.start = newStart;
+            r.capacity = r.degree;
+            r.shared = true;
+        }
+        std::vector<vertexKeyT>().swap(ownTargets);
+        std::vector<int>().swap(ownWeights);
+        std::vector<vertexKeyT>().swap(ownSortedTargets);
+        ownHubBits.clear();
+    }
+    ownNames.clear();
+    ownNameToId.clear();
+    deadSlots = 0;
+    newBase->pointAtArrays();
+    if (compressRows) {
+        // the sorted rows, coded, replace sortedTargets
+        packSortedRows(*newBase);
+        std::vector<vertexKeyT>().swap(newBase->sortedTargets);
+        newBase->sortedTargetsAt = nullptr;
+    }
+    base = newBase;
+}
+
+void csrGraphClass::packSortedRows(sharedBaseT& b) const {
+    b.packedSortedAt.resize(rows.size());
+    b.packedSorted.reserve(b.numSlots + streamVBytePadding);
+    for (vertexKeyT x = 0; x < rows.size(); ++x) {
+        const rowRecord& r = rows[x];
+        b.packedSortedAt[x] = b.packedSorted.size();
+        streamVByteEncodeSorted(b.sortedTargetsAt + r.start, r.degree, b.packedSorted);
+    }
+    b.packedSorted.resize(b.packedSorted.size() + streamVBytePadding, 0);
+}
+
+// file format
+// 1: numVertices numEedges isDirected
+// 2-#verticies: vertexName
+// #verticies: fromVertex toVertex weight
+//
+// same format and diagnostics as graphDatabaseClass::readGraph. The
+// edges are collected first and then built into rows in one pass
+//
+bool csrGraphClass::readGraph(FILE* f) {
+    int numVerticies=0;
+    int numEdges=0;
+    int isDirected=0;
+    int lineNum=0;
+    int w=0; // weight of edge
+    bool returnVal = true;
+    std::vector<edgeT> edges;
+    std::unordered_set<uint64_t> edgesSeen; // both ends, the smaller ID first
+
+    ++lineNum;
+    if(3!=fscanf(f, "%i %i %i", &numVerticies, &numEdges, &isDirected)) {
+        printf("Error reading graph file on line %i\n", lineNum);
+        initializeGraph(0, false);
+        return false;
+    }
+    initializeGraph(numVerticies, (isDirected==1));
+    edges.reserve(numEdges);
+    // read in the vertex names
+    for(int i=0; i<numVerticies; ++i) {
+        char vertexToInsertCstr[maxVertexNameLength];
+        fscanf(f, "%s", vertexToInsertCstr);
+        ++lineNum;
+        if(findVertex(vertexToInsertCstr) != noVertex) {
+            printf("readGraph(): duplicate vertex name %s; not inserted again\n", vertexToInsertCstr);
+            continue;
+        }
+        appendVertex(vertexToInsertCstr);
+    }
+
+    // Read in the edges.
+    // blanks at the end of the file, such as its last newline, end the edges
+    while((fscanf(f, " ") == 0) && !feof(f)) {
+        char fromVertexNameCstr[maxVertexNameLength];
+        char toVertexNameCstr[maxVertexNameLength];
+        if(3==fscanf(f, "%s %s %i", fromVertexNameCstr, toVertexNameCstr, &w)) {
+            ++lineNum;
+            // edges may name verticies that were not listed
+            vertexKeyT from = findVertex(fromVertexNameCstr);
+            if (from == noVertex) {
+                from = insertVertex(fromVertexNameCstr);
+            }
+            vertexKeyT to = findVertex(toVertexNameCstr);
+            if (to == noVertex) {
+                to = insertVertex(toVertexNameCstr);
+            }
+            // every edge is stored both ways, so x->y exists if either was
+            // read; the algorithms need each edge once, so this is always checked
+            uint64_t key = ((uint64_t) std::min(from, to) << 32) | std::max(from, to);
+            if(!edgesSeen.insert(key).second) {
+                if(logging(logWarning)) {
+                    printf("readGraph(): duplicate edge from %s to %s; not inserted again\n", fromVertexNameCstr, toVertexNameCstr);
+                }
+                continue;
+            }
+            if(logging(logTrace)) {
+                printf("adding edge %s to %s\n", fromVertexNameCstr, toVertexNameCstr);
+            }
+            edgeT e;
+            e.from = from;
+            e.to = to;
+            e.weight = w;
+            edges.push_back(e);
+        } else {
+            printf("Error reading graph file on line %i\n", lineNum);
+            returnVal = false;
+            break;
+        }
+    }
+    buildFromEdges(edges);
+    return returnVal;
+}
+
+bool csrGraphClass::writeGraph(FILE* f) {
+    fprintf(f, "%d %d %i\n", liveVerticies, edgeCount, (directed?1:0));
+    // print the vertex names
+    forEachVertex([&](vertexKeyT x, int) {
+        fprintf(f, "%s\n", vertexName(x).c_str());
+    });
+    forEachVertex([&](vertexKeyT x, int) {
+        const rowRecord& r = rows[x];
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            fprintf(f, "%s ", vertexName(x).c_str());
+            fprintf(f, "%s ", vertexName(rowTargets(r)[i]).c_str());
+            fprintf(f, "%i\n", rowWeights(r)[i]);
+        }
+    });
+    return true;
+}
+
+// writes count items and pads to the next section boundary
+static bool writeSection(FILE* f, const void* data, size_t itemBytes, uint64_t count, uint64_t& offset) {
+    static const char zeros[8] = { 0 };
+    if ((count != 0) && (fwrite(data, itemBytes, (size_t) count, f) != count)) {
+        return false;
+    }
+    offset += itemBytes * count;
+    uint64_t padding = binaryGraphAlign(offset) - offset;
+    if ((padding != 0) && (fwrite(zeros, 1, (size_t) padding, f) != padding)) {
+        return false;
+    }
+    offset += padding;
+    return true;
+}
+
+//
+// The live verticies are numbered 0..n-1 in key order and the rows are
+// written packed, without slack or dead slots
+//
+bool csrGraphClass::writeBinaryGraph(FILE* f) {
+    uint64_t n = liveVerticies;
+    std::vector<vertexKeyT> newId(rows.size(), noVertex);
+    std::vector<uint64_t> nameOffsets;
+    std::vector<uint64_t> rowOffsets;
+    nameOffsets.reserve(n + 1);
+    rowOffsets.reserve(n + 1);
+    uint64_t stringBytes = 0;
+    uint64_t numSlots = 0;
+    forEachVertex([&](vertexKeyT x, int xDegree) {
+        newId[x] = (vertexKeyT) nameOffsets.size();
+        nameOffsets.push_back(stringBytes);
+        rowOffsets.push_back(numSlots);
+        stringBytes += vertexName(x).size() + 1;
+        numSlots += xDegree;
+    });
+    nameOffsets.push_back(stringBytes);
+    rowOffsets.push_back(numSlots);
+
+    std::vector<char> strings;
+    std::vector<vertexKeyT> newTargets;
+    std::vector<vertexKeyT> newSortedTargets;
+    std::vector<int32_t> newWeights;
+    strings.reserve(stringBytes);
+    newTargets.reserve(numSlots);
+    newWeights.reserve(numSlots);
+    forEachVertex([&](vertexKeyT x, int) {
+        const std::string& name = vertexName(x);
+        strings.insert(strings.end(), name.c_str(), name.c_str() + name.size() + 1);
+        const rowRecord& r = rows[x];
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            newTargets.push_back(newId[rowTargets(r)[i]]);
+            newWeights.push_back(rowWeights(r)[i]);
+        }
+    });
+    // renumbering changes the sorted order of a row
+    newSortedTargets = newTargets;
+    for (uint64_t x = 0; x < n; ++x) {
+        std::sort(newSortedTargets.begin() + rowOffsets[x], newSortedTargets.begin() + rowOffsets[x + 1]);
+    }
+
+    binaryGraphHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, binaryGraphMagic, sizeof(h.magic));
+    h.version = binaryGraphVersion;
+    h.byteOrder = binaryGraphByteOrder;
+    h.flags = directed ? binaryGraphDirected : 0;
+    h.numVerticies = n;
+    h.numSlots = numSlots;
+    h.stringBytes = stringBytes;
+    h.nameOffsetsAt = binaryGraphAlign(sizeof(h));
+    h.stringsAt = h.nameOffsetsAt + (n + 1) * sizeof(uint64_t);
+    h.rowOffsetsAt = binaryGraphAlign(h.stringsAt + stringBytes);
+    h.targetsAt = h.rowOffsetsAt + (n + 1) * sizeof(uint64_t);
+    h.sortedTargetsAt = binaryGraphAlign(h.targetsAt + numSlots * sizeof(vertexKeyT));
+    h.weightsAt = binaryGraphAlign(h.sortedTargetsAt + numSlots * sizeof(vertexKeyT));
+    h.fileBytes = binaryGraphAlign(h.weightsAt + numSlots * sizeof(int32_t));
+
+    uint64_t offset = 0;
+    bool ok = writeSection(f, &h, sizeof(h), 1, offset) &&
+              writeSection(f, nameOffsets.data(), sizeof(uint64_t), n + 1, offset) &&
+              writeSection(f, strings.data(), 1, stringBytes, offset) &&
+              writeSection(f, rowOffsets.data(), sizeof(uint64_t), n + 1, offset) &&
+              writeSection(f, newTargets.data(), sizeof(vertexKeyT), numSlots, offset) &&
+              writeSection(f, newSortedTargets.data(), sizeof(vertexKeyT), numSlots, offset) &&
+              writeSection(f, newWeights.data(), sizeof(int32_t), numSlots, offset);
+    if (!ok || (offset != h.fileBytes)) {
+        printf("writeBinaryGraph(): error writing graph file\n");
+        return false;
+    }
+    return true;
+}
+
+//
+// The mapped sections become the arrays of a new base as they are, and
+// every row is shared, so nothing is copied but the names, into the
+// dictionary, and the bitsets of the hubs, which the file does not
+// keep. Every target in the file is checked to be a vertex of the
+// graph before any row is used, so a damaged file is refused instead of
+// read out of bounds; that reads each page of the two target sections
+// once, O(E), but copies none of them. The base holds the mapping open
+// until the last graph sharing it lets it go
+//
+bool csrGraphClass::readBinaryGraph(const std::shared_ptr<const mappedGraphClass>& m) {
+    if (!m || !m->isOpen()) {
+        printf("readBinaryGraph(): graph file is not open\n");
+        return false;
+    }
+    uint64_t n = m->numVerticies();
+    uint64_t numSlots = m->numSlots();
+    if (numSlots > (uint64_t) std::numeric_limits<int>::max()) {
+        printf("readBinaryGraph(): %llu edges is too many\n", (unsigned long long) numSlots);
+        return false;
+    }
+    const vertexKeyT* t = m->allTargets();
+    const vertexKeyT* st = m->allSortedTargets();
+    if ((numSlots != 0) && ((*std::max_element(t, t + numSlots) >= n) || (*std::max_element(st, st + numSlots) >= n))) {
+        printf("readBinaryGraph(): edge to a vertex not in the graph\n");
+        return false;
+    }
+    initializeGraph((int) n, m->directed());
+    std::shared_ptr<sharedBaseT> newBase;
+    newBase.swap(spareBase);
+    if (!newBase) {
+        newBase = std::make_shared<sharedBaseT>();
+    }
+    const uint64_t* rowOffsets = m->allRowOffsets();
+    rows.resize(n);
+    newBase->names.reserve(n);
+    for (vertexKeyT x = 0; x < n; ++x) {
+        newBase->names.push_back(m->vertexName(x));
+        // names are in key order, so each one goes at the end
+        newBase->nameToId.insert(newBase->nameToId.end(), std::make_pair(newBase->names.back(), x));
+        rowRecord& r = rows[x];
+        r.start = rowOffsets[x];
+        r.capacity = r.degree = (uint32_t) (rowOffsets[x + 1] - rowOffsets[x]);
+        r.live = true;
+        r.shared = true;
+    }
+    if (newBase->nameToId.size() != n) {
+        printf("readBinaryGraph(): graph file has duplicate vertex names\n");
+        newBase->names.clear();
+        newBase->nameToId.clear();
+        spareBase = newBase;
+        initializeGraph(0, directed);
+        return false;
+    }
+    newBase->mapping = m;
+    newBase->targetsAt = t;
+    newBase->weightsAt = (const int*) m->allWeights();
+    newBase->sortedTargetsAt = st;
+    newBase->numSlots = numSlots;
+    for (vertexKeyT x = 0; x < n; ++x) {
+        rowRecord& r = rows[x];
+        if (r.degree >= hubDegree()) {
+            std::vector<uint64_t>& bits = newBase->hubBits[x];
+            bits.assign((n + 63) / 64, 0);
+            for (uint32_t i = 0; i < r.degree; ++i) {
+                vertexKeyT y = st[r.start + i];
+                bits[y >> 6] |= (uint64_t) 1 << (y & 63);
+            }
+            r.hub = true;
+        }
+    }
+    if (compressRows) {
+        packSortedRows(*newBase);
+    }
+    liveVerticies = (int) n;
+    edgeCount = (int) numSlots;
+    base = newBase;
+    if (trackDegrees) {
+        enableDegreeBuckets();
+    }
+    return true;
+}
+
+//
+// checks everything for consistency
+//
+void csrGraphClass::checkGraph() {
+    int checkEdgeCount = 0; // count edges in graph
+    int checkVerticies = 0; // count live verticies
+    uint64_t checkSlots = 0; // count own slots owned by rows
+    for (vertexKeyT x = 0; x < rows.size(); ++x) {
+        const rowRecord& r = rows[x];
+        if (!r.shared) {
+            checkSlots += r.capacity;
+        }
+        if (!r.live) {
+            if (r.degree != 0) {
+                printf("checkGraph(): deleted vertex %u still has %u edges\n", x, r.degree);
+            }
+            continue;
+        }
+        ++checkVerticies;
+        const std::string& name = vertexName(x);
+        if (isSuperNode(x) ? (superNodes.count(x) == 0) : (findVertex(name) != x)) {
+            printf("checkGraph(): vertex %s is not in the dictionary\n", name.c_str());
+        }
+        uint64_t arraySize = r.shared ? base->numSlots : ownTargets.size();
+        if ((r.degree > r.capacity) || (r.start + r.capacity > arraySize)) {
+            printf("checkGraph(): row of vertex %s is out of bounds\n", name.c_str());
+            continue;
+        }
+        const vertexKeyT* t = rowTargets(r);
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            vertexKeyT y = t[i];
+            ++checkEdgeCount;
+            // check to see if the other vertex is in the graph
+            if ((y >= rows.size()) || !rows[y].live) {
+                printf("checkGraph(): edge from %s to vertex %u not in graph\n", name.c_str(), y);
+                continue;
+            }
+            // If undirected graph, give error if no back pointer
+            if ((!directed) && (!edgeExists(y, x))) {
+                printf("checkGraph(): undirected graph edge %s to %s does not have back pointer\n", name.c_str(), vertexName(y).c_str());
+            }
+            // check that y is not duplicated in this row
+            for (uint32_t j = 0; j < i; ++j) {
+                if (t[j] == y) {
+                    printf("checkGraph(): Duplicate edge %s to %s\n", name.c_str(), vertexName(y).c_str());
+                }
+            }
+        }
+        // check the sorted row and the hub bitset against the row
+        std::vector<vertexKeyT> row(t, t + r.degree);
+        std::sort(row.begin(), row.end());
+        std::vector<vertexKeyT> scratch;
+        if (!std::equal(row.begin(), row.end(), sortedRow(x, scratch))) {
+            printf("checkGraph(): sorted edges of vertex %s do not match its edges\n", name.c_str());
+        }
+        if (r.hub) {
+            uint32_t checkBitCount = 0;
+            for (auto word : rowBits(x)) {
+                checkBitCount += (uint32_t) __builtin_popcountll(word);
+            }
+            if (checkBitCount != r.degree) {
+                printf("checkGraph(): hub bitset of vertex %s has %u bits for %u edges\n", name.c_str(), checkBitCount, r.degree);
+            }
+        }
+    }
+    if (checkVerticies != liveVerticies) {
+        printf("checkGraph(): vertex count is wrong: should be %i but is %i\n", checkVerticies, liveVerticies);
+    }
+    if (ownNames.size() + base->names.size() != rows.size()) {
+        printf("checkGraph(): %lu names for %lu verticies\n", ownNames.size() + base->names.size(), rows.size());
+    }
+    if (checkSlots + deadSlots != ownTargets.size()) {
+        printf("checkGraph(): slot count is wrong: should be %lu but is %llu\n", ownTargets.size(), (unsigned long long) (checkSlots + deadSlots));
+    }
+    if (checkEdgeCount != edgeCount) {
+        printf("checkGraph(): edge count on graph is wrong: should be %i but is %i\n", checkEdgeCount, edgeCount);
+    }
+}
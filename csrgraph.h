@@ -0,0 +1,391 @@
+//
+//  csrgraph.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__csrgraph__
+#define __CliquePartitioning__csrgraph__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include "graphdb.h"
+#include "intersect.h"
+#include "streamvbyte.h"
+#include "degreebuckets.h"
+#include "binarygraph.h"
+#include "partition.h"
+
+//
+// Compact graph store. Vertex names are interned once into dense
+// integer IDs and the adjacency is kept in compressed sparse row (CSR)
+// arrays. Each row holds its edges in insertion order, the same order
+// as the edge lists of graphDatabaseClass, so both stores give the
+// clique algorithms identical results.
+//
+// Rows are allocated with some slack. A row that outgrows its slack is
+// moved to the end of the arrays, and the holes left behind are
+// reclaimed by compact() once they make up half of the arrays.
+//
+// Each row is mirrored in sortedTargets in ID order for the intersection
+// kernels in intersect.h and for binary search in edgeExists. Hubs,
+// verticies whose degree reaches hubDegree(), also keep their neighbors
+// as a bitset over vertex IDs.
+//
+// With compressRows, the sorted rows of the base are kept delta coded
+// with Stream VByte instead, see streamvbyte.h, and decoded for each
+// intersection. On dense graphs a neighbor takes a byte or two instead
+// of four, so the intersections read a fraction of the memory.
+//
+// Copies share. The arrays and the dictionary built by readGraph and the
+// other loaders are frozen into a base that copies point to instead of
+// copying. A graph never writes to its base: the first change to a row
+// copies that row into the graph's own arrays, and verticies added later
+// go into its own dictionary. So a working copy like gPrime costs one
+// copy of the row table, and grows only by the rows it changes.
+//
+// A super node has no name of its own. It keeps the list of the input
+// verticies merged into it, linked by ID, and its name, the names of
+// its members joined with commas, is only made when vertexName asks for
+// it. Key order is the order of those names all the same: keyLess
+// compares the member names as if they were joined. So a merge costs
+// the same however large the super nodes have grown.
+//
+class csrGraphClass {
+public:
+    //
+    // vertex key is the dense vertex ID
+    //
+    typedef uint32_t vertexKeyT;
+    static const vertexKeyT noVertex = 0xffffffffu;
+    static const int maxVertexNameLength = 256;
+
+    //
+    // one edge, used for bulk construction
+    //
+    struct edgeT {
+        vertexKeyT from;
+        vertexKeyT to;
+        int weight;
+    };
+
+    //
+    // one row of the CSR arrays
+    //
+    struct rowRecord {
+        uint64_t start;         // first slot in targets/weights
+        uint32_t degree;        // # slots in use, convenience
+        uint32_t capacity;      // # slots reserved for this row
+        unsigned int vertexBits;
+        bool live;              // false once the vertex is deleted
+        bool hub;               // neighbors also kept as a bitset
+        bool shared;            // slots are in the base arrays, not the own ones
+        rowRecord() : start(0), degree(0), capacity(0), vertexBits(0), live(false), hub(false), shared(false) {
+            // empty
+        }
+    };
+
+    int edgeCount = 0; // number of edges in the graph
+    bool directed = false;
+    // kernel for commonNeighborCount; intersectKernelAuto picks one by degree
+    intersectKernelT intersectKernel = intersectKernelAuto;
+    // freeze compresses the sorted rows of the base; set before loading
+    bool compressRows = false;
+    // smallest degree at which a vertex keeps a neighbor bitset
+    static const uint32_t hubMinDegree = 256;
+
+private:
+    //
+    // The shared part: name <-> ID dictionary, CSR arrays and hub bitsets
+    // of the verticies that existed when the base was frozen. nameToId
+    // also gives the verticies in key order, which the algorithms use for
+    // tie breaking. Entries of deleted verticies stay, with rows[x].live false
+    //
+    struct sharedBaseT {
+        std::vector<std::string> names;
+        std::map<std::string, vertexKeyT> nameToId;
+        std::vector<vertexKeyT> targets;
+        std::vector<int> weights;
+        std::vector<vertexKeyT> sortedTargets;
+        std::unordered_map<vertexKeyT, std::vector<uint64_t> > hubBits;
+        // with compressRows, the sorted rows in place of sortedTargets,
+        // row x at packedSortedAt[x], followed by streamVBytePadding bytes
+        std::vector<uint8_t> packedSorted;
+        std::vector<uint64_t> packedSortedAt;
+        // where the rows are read from: the arrays above, or the sections
+        // of mapping when the base was read by readBinaryGraph
+        std::shared_ptr<const mappedGraphClass> mapping;
+        const vertexKeyT* targetsAt = nullptr;
+        const int* weightsAt = nullptr;
+        const vertexKeyT* sortedTargetsAt = nullptr;
+        uint64_t numSlots = 0;
+        void pointAtArrays() {
+            targetsAt = targets.data();
+            weightsAt = weights.data();
+            sortedTargetsAt = sortedTargets.data();
+            numSlots = targets.size();
+        }
+    };
+    static std::shared_ptr<const sharedBaseT> emptyBase();
+    std::shared_ptr<const sharedBaseT> base = emptyBase();
+    // the last base, emptied, for the next freeze to fill; see initializeGraph
+    std::shared_ptr<sharedBaseT> spareBase;
+    //
+    // The own part. ownNames holds the names of IDs from base->names.size()
+    // on; ownNameToId the live ones among them
+    //
+    std::vector<std::string> ownNames;
+    std::map<std::string, vertexKeyT> ownNameToId;
+    int liveVerticies = 0;
+    //
+    // CSR arrays. Row x owns slots [start, start+capacity) of its arrays,
+    // the base ones when rows[x].shared and the own ones otherwise
+    //
+    std::vector<rowRecord> rows;
+    std::vector<vertexKeyT> ownTargets;
+    std::vector<int> ownWeights;
+    std::vector<vertexKeyT> ownSortedTargets; // the rows again, sorted by ID
+    uint64_t deadSlots = 0; // own slots owned by no row
+    std::unordered_map<vertexKeyT, std::vector<uint64_t> > ownHubBits;
+
+    const vertexKeyT* rowTargets(const rowRecord& r) const {
+        return (r.shared ? base->targetsAt : ownTargets.data()) + r.start;
+    }
+    const int* rowWeights(const rowRecord& r) const {
+        return (r.shared ? base->weightsAt : ownWeights.data()) + r.start;
+    }
+    const vertexKeyT* rowSortedTargets(const rowRecord& r) const {
+        return (r.shared ? base->sortedTargetsAt : ownSortedTargets.data()) + r.start;
+    }
+    // the sorted row of x, decoded into scratch if it is compressed
+    const vertexKeyT* sortedRow(vertexKeyT x, std::vector<vertexKeyT>& scratch) const;
+    const std::vector<uint64_t>& rowBits(vertexKeyT x) const {
+        return rows[x].shared ? base->hubBits.find(x)->second : ownHubBits.find(x)->second;
+    }
+    //
+    // Members of the super nodes. members[x].first and last are the ends
+    // of the list of super node x, and members[m].next the member after
+    // input vertex m. An input vertex is the one member of its own list.
+    // Empty until the first merge; IDs past its end are input verticies
+    //
+    struct memberRecord {
+        vertexKeyT first;
+        vertexKeyT last;
+        vertexKeyT next;
+    };
+    std::vector<memberRecord> members;
+    bool isSuperNode(vertexKeyT x) const { return (x < members.size()) && (members[x].first != noVertex); }
+    vertexKeyT firstMember(vertexKeyT x) const { return isSuperNode(x) ? members[x].first : x; }
+    vertexKeyT lastMember(vertexKeyT x) const { return isSuperNode(x) ? members[x].last : x; }
+    vertexKeyT nextMember(vertexKeyT m) const { return (m < members.size()) ? members[m].next : noVertex; }
+    // name of input vertex m, kept after m is merged
+    const std::string& memberName(vertexKeyT m) const {
+        return (m < base->names.size()) ? base->names[m] : ownNames[m - base->names.size()];
+    }
+    struct memberNameListT;
+    bool joinedKeyLess(vertexKeyT x, vertexKeyT y) const;
+    //
+    // orders IDs by key for the ordered sets below. It points back at the
+    // graph, so copies and swaps point it at the new owner, see rebindKeyOrder
+    //
+    struct keyLessT {
+        const csrGraphClass* g;
+        bool operator()(vertexKeyT x, vertexKeyT y) const { return g->keyLess(x, y); }
+    };
+    // the live super nodes in key order
+    std::set<vertexKeyT, keyLessT> superNodes{keyLessT{this}};
+    void rebindKeyOrder();
+    //
+    // scratch for commonNeighbor: mark[v] == markEpoch if v is a neighbor
+    // of sj, and markWeight[v] is then the weight of the edge sj->v
+    //
+    std::vector<uint32_t> mark;
+    std::vector<int> markWeight;
+    uint32_t markEpoch = 0;
+    void markNeighbors(vertexKeyT x);
+    //
+    // verticies by degree, kept up to date once enableDegreeBuckets() is
+    // called
+    //
+    bool trackDegrees = false;
+    degreeBucketClass<vertexKeyT, keyLessT> degreeBuckets{keyLessT{this}};
+    void degreeChanged(vertexKeyT x, int oldDegree, int newDegree) {
+        if (trackDegrees) {
+            degreeBuckets.update(x, oldDegree, newDegree);
+        }
+    }
+
+    void insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w);
+    bool deleteEdgeUtility(vertexKeyT x, vertexKeyT y);
+    void reserveRow(vertexKeyT x, uint32_t capacity);
+    void sortRow(vertexKeyT x);
+    void updateHub(vertexKeyT x);
+    uint32_t hubDegree() const;
+    vertexKeyT appendVertex(const std::string& x);
+    vertexKeyT appendSuperNode(vertexKeyT si, vertexKeyT sj);
+    void removeVertex(vertexKeyT x);
+    void compact();
+    // codes the sorted rows of b into its packedSorted, for compressRows
+    void packSortedRows(sharedBaseT& b) const;
+
+public:
+    // constructor
+    csrGraphClass() {};
+    // constructor to convert from the string keyed graph
+    explicit csrGraphClass(const graphDatabaseClass& g);
+    // a copy shares the base and copies the row table and the own part
+    csrGraphClass(const csrGraphClass& other);
+    // move constructor
+    csrGraphClass(csrGraphClass&& other) : csrGraphClass() {
+        swap(*this, other);
+    }
+    // copy operator
+    csrGraphClass& operator= (csrGraphClass rhs) {
+        swap(*this, rhs);
+        return *this;
+    }
+
+    int numVerticies() { return liveVerticies; }
+    int numEdges() const { return edgeCount; }
+
+    void initializeGraph(int numVerticies, bool isDirected);
+    bool readGraph(FILE* ifile);
+    bool writeGraph(FILE* ofile);
+    // readGraph on numThreads threads, 0 for one per core; see csrparse.cpp
+    bool readGraphParallel(const char* fileName, unsigned int numThreads = 0);
+    // binary format of binarygraph.h; ofile must be opened "wb"
+    bool writeBinaryGraph(FILE* ofile);
+    // replaces the graph by the one in an open mapped file, whose
+    // sections become the arrays of the base; the base holds m open
+    bool readBinaryGraph(const std::shared_ptr<const mappedGraphClass>& m);
+    // replaces all edges by edges, inserting each one in both directions
+    void buildFromEdges(const std::vector<edgeT>& edges);
+    // the names of the verticies in key order and the edges, each once, in
+    // an order from which graphDatabaseClass::buildFromEdges makes every
+    // row as it is here; false if the rows do not pair up into edges
+    bool listEdges(std::vector<std::string>& names, std::vector<graphDatabaseClass::edgeT>& edges) const;
+    // moves the whole graph into a new base, so copies made after share all of it
+    void freeze();
+
+    bool deleteEdge(vertexKeyT x, vertexKeyT y);
+    void insertEdge(vertexKeyT x, vertexKeyT y, int w);
+    bool edgeExists(vertexKeyT x, vertexKeyT y);
+
+    vertexKeyT insertVertex(const std::string& x);
+    // finds an input vertex by name; super nodes are not found
+    vertexKeyT findVertex(const std::string& x) const;
+    void disconnectVertex(vertexKeyT x);
+    bool deleteVertex(vertexKeyT x);
+
+    void commonNeighbor(vertexKeyT si, vertexKeyT sj, std::vector<vertexKeyT>& returnVal);
+    // number of common neighbors, without building the list
+    int commonNeighborCount(vertexKeyT si, vertexKeyT sj) const;
+    // replaces sub by the subgraph on members, every row in the same order as here
+    void inducedSubgraph(const std::vector<vertexKeyT>& members, csrGraphClass& sub) const;
+
+    // start keeping the verticies in buckets by degree
+    void enableDegreeBuckets();
+    // first vertex in key order of smallest non-zero degree; needs enableDegreeBuckets()
+    bool minDegreeVertex(vertexKeyT& x, int& xDegree);
+
+    //
+    // accessors shared with graphDatabaseClass, see cliquepartition.h
+    //
+    int degree(vertexKeyT x) const { return (int) rows[x].degree; }
+    // the name of x; for a super node, made from its members
+    std::string vertexName(vertexKeyT x) const;
+    // true if x comes before y in key order, the order of their names
+    bool keyLess(vertexKeyT x, vertexKeyT y) const {
+        if (!isSuperNode(x) && !isSuperNode(y)) {
+            return memberName(x) < memberName(y);
+        }
+        return joinedKeyLess(x, y);
+    }
+    // calls f(key, degree) for each vertex in key order, merging the
+    // base and the own dictionaries and the super nodes
+    template <typename F> void forEachVertex(F f) const {
+        auto btr = base->nameToId.begin();
+        auto otr = ownNameToId.begin();
+        auto str = superNodes.begin();
+        while (true) {
+            while ((btr != base->nameToId.end()) && !rows[btr->second].live) {
+                ++btr;
+            }
+            // the first input vertex left, from btr or from otr
+            bool fromBase = (btr != base->nameToId.end()) &&
+                            ((otr == ownNameToId.end()) || (btr->first < otr->first));
+            vertexKeyT x = fromBase ? btr->second : ((otr != ownNameToId.end()) ? otr->second : noVertex);
+            if ((str != superNodes.end()) && ((x == noVertex) || keyLess(*str, x))) {
+                f(*str, (int) rows[*str].degree);
+                ++str;
+            } else if (x == noVertex) {
+                break;
+            } else {
+                f(x, (int) rows[x].degree);
+                if (fromBase) {
+                    ++btr;
+                } else {
+                    ++otr;
+                }
+            }
+        }
+    }
+    // calls f(neighborKey) for each edge of x in insertion order
+    template <typename F> void forEachNeighbor(vertexKeyT x, F f) const {
+        const rowRecord& r = rows[x];
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            f(rowTargets(r)[i]);
+        }
+    }
+    // calls f(neighborKey, weight) for each edge of x in insertion order
+    template <typename F> void forEachWeightedNeighbor(vertexKeyT x, F f) const {
+        const rowRecord& r = rows[x];
+        const vertexKeyT* t = rowTargets(r);
+        const int* w = rowWeights(r);
+        for (uint32_t i = 0; i < r.degree; ++i) {
+            f(t[i], w[i]);
+        }
+    }
+    // replaces si and sj by the super node "si,sj" linked to their
+    // common neighbors, each edge weighted w(si,c) + w(sj,c); returns
+    // the ID of the super node
+    vertexKeyT mergeVerticies(vertexKeyT si, vertexKeyT sj);
+
+    friend void swap(csrGraphClass& first, csrGraphClass& second) {
+        using std::swap;
+        swap(first.edgeCount, second.edgeCount);
+        swap(first.directed, second.directed);
+        swap(first.intersectKernel, second.intersectKernel);
+        swap(first.compressRows, second.compressRows);
+        swap(first.base, second.base);
+        swap(first.spareBase, second.spareBase);
+        swap(first.ownNames, second.ownNames);
+        swap(first.ownNameToId, second.ownNameToId);
+        swap(first.liveVerticies, second.liveVerticies);
+        swap(first.rows, second.rows);
+        swap(first.ownTargets, second.ownTargets);
+        swap(first.ownWeights, second.ownWeights);
+        swap(first.ownSortedTargets, second.ownSortedTargets);
+        swap(first.deadSlots, second.deadSlots);
+        swap(first.ownHubBits, second.ownHubBits);
+        swap(first.members, second.members);
+        swap(first.superNodes, second.superNodes);
+        swap(first.mark, second.mark);
+        swap(first.markWeight, second.markWeight);
+        swap(first.markEpoch, second.markEpoch);
+        swap(first.trackDegrees, second.trackDegrees);
+        swap(first.degreeBuckets, second.degreeBuckets);
+        first.rebindKeyOrder();
+        second.rebindKeyOrder();
+    }
+
+    // checks the graph database for consistency
+    void checkGraph();
+};
+
+#endif /* defined(__CliquePartitioning__csrgraph__) */
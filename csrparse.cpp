@@ -0,0 +1,254 @@
+//
+//  csrparse.cpp
+//  CliquePartitioning
+//
+
+#include "csrgraph.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <unordered_set>
+
+namespace {
+
+//
+// one piece of the edge section, parsed by one thread. Names are
+// interned into IDs local to the chunk, numbered in order of first
+// appearance, and mapped to graph IDs once all the chunks are done
+//
+struct parseChunkT {
+    const char* begin;
+    const char* end;
+    int numLines = 0;                   // lines in the chunk
+    std::vector<std::string> localNames; // local ID -> name
+    std::unordered_map<std::string, csrGraphClass::vertexKeyT> localIds;
+    std::vector<csrGraphClass::edgeT> edges;
+    std::vector<int> badLines;          // line numbers within the chunk, from 0
+};
+
+inline bool isBlank(char c) {
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+// end of the line starting at p, at its '\n' or at end
+inline const char* lineEnd(const char* p, const char* end) {
+    const char* nl = (const char*) memchr(p, '\n', end - p);
+    return (nl == nullptr) ? end : nl;
+}
+
+// start of the line after the one ending at e
+inline const char* nextLine(const char* e, const char* end) {
+    return (e == end) ? end : e + 1;
+}
+
+//
+// splits the line [p,end) at blanks into at most maxTokens tokens.
+// returns the number of tokens, or maxTokens+1 if there are more
+//
+int splitLine(const char* p, const char* end, const char** token, size_t* tokenLength, int maxTokens) {
+    int numTokens = 0;
+    while (true) {
+        while ((p < end) && isBlank(*p)) {
+            ++p;
+        }
+        if (p == end) {
+            return numTokens;
+        }
+        if (numTokens == maxTokens) {
+            return maxTokens + 1;
+        }
+        const char* start = p;
+        while ((p < end) && !isBlank(*p)) {
+            ++p;
+        }
+        token[numTokens] = start;
+        tokenLength[numTokens] = p - start;
+        ++numTokens;
+    }
+}
+
+// parses an integer the way fscanf's %i does; false if the token is not one
+bool parseInt(const char* token, size_t length, int& value) {
+    char buffer[32];
+    if (length >= sizeof(buffer)) {
+        return false;
+    }
+    memcpy(buffer, token, length);
+    buffer[length] = '\0';
+    char* stop = nullptr;
+    long v = strtol(buffer, &stop, 0);
+    if ((stop != buffer + length) || (v < std::numeric_limits<int>::min()) || (v > std::numeric_limits<int>::max())) {
+        return false;
+    }
+    value = (int) v;
+    return true;
+}
+
+csrGraphClass::vertexKeyT internLocal(parseChunkT& c, const char* token, size_t length) {
+    std::string name(token, length);
+    auto ntr = c.localIds.find(name);
+    if (ntr != c.localIds.end()) {
+        return ntr->second;
+    }
+    csrGraphClass::vertexKeyT id = (csrGraphClass::vertexKeyT) c.localNames.size();
+    c.localNames.push_back(name);
+    c.localIds.insert(std::make_pair(name, id));
+    return id;
+}
+
+// tokenizes and interns the edge lines of one chunk
+void parseChunk(parseChunkT& c) {
+    const char* p = c.begin;
+    while (p < c.end) {
+        const char* e = lineEnd(p, c.end);
+        const char* token[3];
+        size_t tokenLength[3];
+        int numTokens = splitLine(p, e, token, tokenLength, 3);
+        int w = 0;
+        if (numTokens == 3 && parseInt(token[2], tokenLength[2], w)) {
+            csrGraphClass::edgeT edge;
+            edge.from = internLocal(c, token[0], tokenLength[0]);
+            edge.to = internLocal(c, token[1], tokenLength[1]);
+            edge.weight = w;
+            c.edges.push_back(edge);
+        } else if (numTokens != 0) {
+            c.badLines.push_back(c.numLines);
+        }
+        ++c.numLines;
+        p = nextLine(e, c.end);
+    }
+}
+
+} // namespace
+
+//
+// Parallel loader for the text format of readGraph. The file is mapped,
+// the header and vertex names are read in order, and the edge section is
+// cut at line boundaries into one chunk per thread. Each thread
+// tokenizes its chunk and interns names locally; the local names are
+// then added to the graph chunk by chunk, so verticies get the same IDs
+// readGraph would give them, and the edges are built into rows in one
+// pass by buildFromEdges.
+//
+// Blank lines are skipped. A malformed line is reported with its line
+// number in the file and skipped, and readGraphParallel returns false.
+// Repeated edges, either way round, are dropped as the chunks are mapped
+// to graph IDs, keeping the first in file order as readGraph does, so a
+// well formed file gives the graph readGraph gives.
+//
+bool csrGraphClass::readGraphParallel(const char* fileName, unsigned int numThreads) {
+    mappedFileClass file;
+    if (!file.open(fileName)) {
+        initializeGraph(0, false);
+        return false;
+    }
+    const char* p = file.data();
+    const char* end = p + file.size();
+    int lineNum = 0;
+    bool returnVal = true;
+
+    // header: numVertices numEdges isDirected
+    int numVerticies = 0;
+    int numEdges = 0;
+    int isDirected = 0;
+    const char* token[3];
+    size_t tokenLength[3];
+    const char* e = (p == end) ? end : lineEnd(p, end);
+    ++lineNum;
+    if ((p == end) || (splitLine(p, e, token, tokenLength, 3) != 3) ||
+        !parseInt(token[0], tokenLength[0], numVerticies) ||
+        !parseInt(token[1], tokenLength[1], numEdges) ||
+        !parseInt(token[2], tokenLength[2], isDirected)) {
+        printf("Error reading graph file on line %i\n", lineNum);
+        initializeGraph(0, false); // as readGraph leaves it, not the last graph
+        return false;
+    }
+    p = nextLine(e, end);
+    initializeGraph(numVerticies, (isDirected==1));
+
+    // vertex names, one per line
+    for (int i = 0; (i < numVerticies) && (p < end); p = nextLine(e, end)) {
+        e = lineEnd(p, end);
+        ++lineNum;
+        int numTokens = splitLine(p, e, token, tokenLength, 1);
+        if (numTokens == 0) {
+            continue;
+        }
+        ++i;
+        if (numTokens != 1) {
+            printf("Error reading graph file on line %i\n", lineNum);
+            returnVal = false;
+            continue;
+        }
+        std::string name(token[0], tokenLength[0]);
+        if (findVertex(name) != noVertex) {
+            printf("readGraph(): duplicate vertex name %s; not inserted again\n", name.c_str());
+            continue;
+        }
+        appendVertex(name);
+    }
+
+    // cut the edges into chunks that end on a line
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t minChunkBytes = 1 << 16; // smaller chunks are not worth a thread
+    size_t numChunks = std::max((size_t) 1, std::min((size_t) numThreads, (size_t) (end - p) / minChunkBytes));
+    std::vector<parseChunkT> chunks(numChunks);
+    for (size_t c = 0; c < numChunks; ++c) {
+        chunks[c].begin = (c == 0) ? p : chunks[c - 1].end;
+        const char* cut = (c + 1 == numChunks) ? end : std::max(chunks[c].begin, p + (end - p) * (c + 1) / numChunks);
+        chunks[c].end = nextLine(lineEnd(cut, end), end);
+    }
+    std::vector<std::thread> threads;
+    for (size_t c = 1; c < numChunks; ++c) {
+        threads.push_back(std::thread(parseChunk, std::ref(chunks[c])));
+    }
+    parseChunk(chunks[0]);
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    // add the names in order of first appearance and map the edges to graph IDs
+    std::vector<edgeT> edges;
+    edges.reserve(std::max(numEdges, 0));
+    std::unordered_set<uint64_t> edgesSeen; // both ends, the smaller ID first
+    edgesSeen.reserve(std::max(numEdges, 0));
+    for (auto &c : chunks) {
+        for (int bad : c.badLines) {
+            printf("Error reading graph file on line %i\n", lineNum + bad + 1);
+            returnVal = false;
+        }
+        lineNum += c.numLines;
+        std::vector<vertexKeyT> globalId(c.localNames.size());
+        for (size_t i = 0; i < c.localNames.size(); ++i) {
+            vertexKeyT id = findVertex(c.localNames[i]);
+            if (id == noVertex) {
+                // edges may name verticies that were not listed
+                id = appendVertex(c.localNames[i]);
+            }
+            globalId[i] = id;
+        }
+        for (auto edge : c.edges) {
+            edge.from = globalId[edge.from];
+            edge.to = globalId[edge.to];
+            uint64_t key = ((uint64_t) std::min(edge.from, edge.to) << 32) | std::max(edge.from, edge.to);
+            if (!edgesSeen.insert(key).second) {
+                if (logging(logWarning)) {
+                    printf("readGraph(): duplicate edge from %s to %s; not inserted again\n",
+                           memberName(edge.from).c_str(), memberName(edge.to).c_str());
+                }
+                continue;
+            }
+            edges.push_back(edge);
+        }
+        // the chunk is done with; free it before the rows are built
+        decltype(c.localIds)().swap(c.localIds);
+        std::vector<edgeT>().swap(c.edges);
+    }
+    buildFromEdges(edges);
+    return returnVal;
+}
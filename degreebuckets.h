@@ -0,0 +1,77 @@
+//
+//  degreebuckets.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__degreebuckets__
+#define __CliquePartitioning__degreebuckets__
+
+#include <vector>
+#include <set>
+#include <functional>
+
+//
+// Bucket queue of verticies by degree, so the vertex with the smallest
+// non-zero degree is found without a scan of the graph. Verticies of
+// degree 0 are not kept. Inside a bucket the keys are ordered by their
+// operator<, so the first key of a bucket is the first vertex in key
+// order among those tied on degree. lessT gives the key order, for keys
+// whose order is not their operator<.
+//
+// minBucket only moves down when a vertex drops below it and moves up
+// past empty buckets when the minimum is asked for, so finding the
+// minimum is O(1) amortised over the degree changes.
+//
+template <typename keyT, typename lessT = std::less<keyT> >
+class degreeBucketClass {
+    typedef std::set<keyT, lessT> bucketT;
+    std::vector<bucketT> buckets; // buckets[d] holds the verticies of degree d
+    int minBucket = 1; // no vertex has a degree between 1 and minBucket-1
+    lessT less;
+public:
+    explicit degreeBucketClass(const lessT& keyLess = lessT()) : less(keyLess) {};
+    void clear() {
+        buckets.clear();
+        minBucket = 1;
+    }
+    // orders the buckets by keyLess, which must order the keys in them the same way
+    void setLess(const lessT& keyLess) {
+        less = keyLess;
+        for (auto &b : buckets) {
+            b = bucketT(b.begin(), b.end(), less);
+        }
+    }
+    // moves x from the bucket for oldDegree to the bucket for newDegree
+    void update(const keyT& x, int oldDegree, int newDegree) {
+        if (oldDegree == newDegree) {
+            return;
+        }
+        if (oldDegree > 0) {
+            buckets[oldDegree].erase(x);
+        }
+        if (newDegree > 0) {
+            if (newDegree >= (int) buckets.size()) {
+                buckets.resize(newDegree + 1, bucketT(less));
+            }
+            buckets[newDegree].insert(x);
+            if (newDegree < minBucket) {
+                minBucket = newDegree;
+            }
+        }
+    }
+    // first vertex in key order with the smallest non-zero degree;
+    // returns false if every vertex has degree 0
+    bool first(keyT& x, int& degree) {
+        while ((minBucket < (int) buckets.size()) && buckets[minBucket].empty()) {
+            ++minBucket;
+        }
+        if (minBucket >= (int) buckets.size()) {
+            return false;
+        }
+        x = *buckets[minBucket].begin();
+        degree = minBucket;
+        return true;
+    }
+};
+
+#endif /* defined(__CliquePartitioning__degreebuckets__) */
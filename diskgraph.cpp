@@ -0,0 +1,774 @@
+//
+//  diskgraph.cpp
+//  CliquePartitioning
+//
+
+#include "diskgraph.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include "intersect.h"
+
+const diskGraphClass::vertexKeyT diskGraphClass::noVertex;
+const uint32_t diskGraphClass::noLogEdge;
+
+//
+// A row file and its page cache. Pages are read with pread and the least
+// recently used ones dropped once the cache is full. The cache is shared
+// by the copies of a graph and by the threads of a scan, so it takes a
+// lock; the bytes of a row are copied out before they are decoded
+//
+struct diskGraphClass::rowFileT {
+    static const size_t pageBytes = 1 << 16;
+    struct pageT {
+        std::vector<uint8_t> bytes;
+        std::list<uint64_t>::iterator lru;
+    };
+    int fd;
+    size_t maxPages;
+    mutable std::mutex lock;
+    mutable std::unordered_map<uint64_t, pageT> pages;
+    mutable std::list<uint64_t> lru; // page numbers, most recently used first
+
+    rowFileT(int fileFd, size_t cacheMemory) :
+        fd(fileFd), maxPages(std::max((size_t) 2, cacheMemory / pageBytes)) {};
+    ~rowFileT() { close(fd); }
+    rowFileT(const rowFileT&) = delete;
+    rowFileT& operator= (const rowFileT&) = delete;
+
+    // copies n bytes at offset to out; false if they are not all in the file
+    bool read(uint64_t offset, size_t n, uint8_t* out) const {
+        std::lock_guard<std::mutex> guard(lock);
+        while (n > 0) {
+            uint64_t page = offset / pageBytes;
+            size_t at = (size_t) (offset % pageBytes);
+            auto ptr = pages.find(page);
+            if (ptr != pages.end()) {
+                lru.splice(lru.begin(), lru, ptr->second.lru);
+            } else {
+                std::vector<uint8_t> bytes;
+                if (pages.size() >= maxPages) {
+                    // reuse the buffer of the page dropped
+                    auto dropped = pages.find(lru.back());
+                    bytes.swap(dropped->second.bytes);
+                    pages.erase(dropped);
+                    lru.pop_back();
+                }
+                bytes.resize(pageBytes);
+                ssize_t got = pread(fd, bytes.data(), pageBytes, (off_t) (page * pageBytes));
+                if (got <= 0) {
+                    return false;
+                }
+                bytes.resize((size_t) got);
+                profileCount(counterPageReads);
+                lru.push_front(page);
+                ptr = pages.insert(std::make_pair(page, pageT())).first;
+                ptr->second.bytes.swap(bytes);
+                ptr->second.lru = lru.begin();
+            }
+            const std::vector<uint8_t>& bytes = ptr->second.bytes;
+            size_t take = std::min(n, pageBytes - at);
+            if (at + take > bytes.size()) {
+                return false;
+            }
+            memcpy(out, bytes.data() + at, take);
+            out += take;
+            offset += take;
+            n -= take;
+        }
+        return true;
+    }
+};
+
+namespace {
+
+struct diskEdgeRecordT {
+    diskGraphClass::vertexKeyT from;
+    diskGraphClass::vertexKeyT to;
+    int weight;
+};
+
+//
+// a scratch file next to nearName, so it is on the same disk as the
+// graph and not in a small /tmp. It is unlinked at once, and goes away
+// when it is closed
+//
+int openScratchFile(const std::string& nearName) {
+    std::string pattern = nearName + ".XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+    int fd = mkstemp(path.data());
+    if (fd < 0) {
+        printf("diskGraphClass: unable to make a scratch file next to %s\n", nearName.c_str());
+        return -1;
+    }
+    unlink(path.data());
+    return fd;
+}
+
+// reads all of n bytes at offset; false if the file is short
+bool preadAll(int fd, void* out, size_t n, uint64_t offset) {
+    char* p = (char*) out;
+    while (n > 0) {
+        ssize_t got = pread(fd, p, n, (off_t) offset);
+        if (got <= 0) {
+            return false;
+        }
+        p += got;
+        offset += (uint64_t) got;
+        n -= (size_t) got;
+    }
+    return true;
+}
+
+//
+// one sorted run of the external sort, in a scratch file or, for the
+// last one, still in memory
+//
+struct edgeRunT {
+    FILE* f = nullptr;
+    const std::vector<diskEdgeRecordT>* memory = nullptr;
+    size_t next = 0;
+    diskEdgeRecordT e;
+    // moves e to the next edge of the run; false at the end
+    bool advance() {
+        if (f != nullptr) {
+            return fread(&e, sizeof(e), 1, f) == 1;
+        }
+        if (next < memory->size()) {
+            e = (*memory)[next++];
+            return true;
+        }
+        return false;
+    }
+};
+
+// the edges of a run are in the order they were read within each row
+void sortRun(std::vector<diskEdgeRecordT>& run) {
+    std::stable_sort(run.begin(), run.end(), [](const diskEdgeRecordT& a, const diskEdgeRecordT& b) {
+        return a.from < b.from;
+    });
+}
+
+// the row of one vertex, encoded as in diskgraph.h
+struct rowEncoderT {
+    std::vector<uint8_t> bytes;
+    int64_t last = 0;
+    uint32_t degree = 0;
+    void start(diskGraphClass::vertexKeyT x) {
+        bytes.clear();
+        last = x;
+        degree = 0;
+    }
+    void add(diskGraphClass::vertexKeyT y, int w) {
+        diskPutVarint(bytes, diskZigzag((int64_t) y - last));
+        diskPutVarint(bytes, diskZigzag(w));
+        last = y;
+        ++degree;
+    }
+};
+
+} // namespace
+
+//
+// Two passes over the text. The first collects every name, those listed
+// and those only named by an edge as readGraph allows, and numbers them
+// in key order. The second turns each edge into a record for each
+// direction, sorted into runs by the vertex they are from. Merging the
+// runs, taking a tie from the earlier run, gives each row in the order
+// its edges were read, as the other stores build it
+//
+bool buildDiskGraph(const char* textName, const char* diskName, size_t memoryBytes) {
+    typedef diskGraphClass::vertexKeyT vertexKeyT;
+    profileTimerClass timer("buildDiskGraph");
+    FILE* f = fopen(textName, "r");
+    if (f == nullptr) {
+        printf("buildDiskGraph(): unable to open %s\n", textName);
+        return false;
+    }
+    int numVerticies=0;
+    int numEdges=0;
+    int isDirected=0;
+    int lineNum=0;
+    int w=0; // weight of edge
+    bool returnVal = true;
+    char fromVertexNameCstr[diskGraphClass::maxVertexNameLength];
+    char toVertexNameCstr[diskGraphClass::maxVertexNameLength];
+
+    fscanf(f, "%i %i %i", &numVerticies, &numEdges, &isDirected);
+    ++lineNum;
+    std::map<std::string, vertexKeyT> nameToId;
+    for(int i=0; i<numVerticies; ++i) {
+        fscanf(f, "%s", fromVertexNameCstr);
+        ++lineNum;
+        if(!nameToId.insert(std::make_pair(std::string(fromVertexNameCstr), 0)).second) {
+            printf("readGraph(): duplicate vertex name %s; not inserted again\n", fromVertexNameCstr);
+        }
+    }
+    long edgesAt = ftell(f);
+    int numEdgeLines = 0;
+    // blanks at the end of the file, such as its last newline, end the edges
+    while((fscanf(f, " ") == 0) && !feof(f)) {
+        if(3==fscanf(f, "%s %s %i", fromVertexNameCstr, toVertexNameCstr, &w)) {
+            ++lineNum;
+            ++numEdgeLines;
+            nameToId.insert(std::make_pair(std::string(fromVertexNameCstr), 0));
+            nameToId.insert(std::make_pair(std::string(toVertexNameCstr), 0));
+        } else {
+            printf("Error reading graph file on line %i\n", lineNum);
+            returnVal = false;
+            break;
+        }
+    }
+    std::vector<std::string> names;
+    names.reserve(nameToId.size());
+    for (auto &vtr : nameToId) {
+        vtr.second = (vertexKeyT) names.size();
+        names.push_back(vtr.first);
+    }
+
+    // the edges read again, into runs
+    size_t runRecords = std::max((size_t) 1024, memoryBytes / sizeof(diskEdgeRecordT));
+    std::vector<diskEdgeRecordT> run;
+    std::vector<FILE*> runFiles;
+    bool ok = true;
+    fseek(f, edgesAt, SEEK_SET);
+    for (int i = 0; ok && (i < numEdgeLines); ++i) {
+        fscanf(f, "%s %s %i", fromVertexNameCstr, toVertexNameCstr, &w);
+        vertexKeyT from = nameToId[fromVertexNameCstr];
+        vertexKeyT to = nameToId[toVertexNameCstr];
+        run.push_back(diskEdgeRecordT{from, to, w});
+        run.push_back(diskEdgeRecordT{to, from, w});
+        if (run.size() >= runRecords) {
+            sortRun(run);
+            int fd = openScratchFile(diskName);
+            FILE* runFile = (fd < 0) ? nullptr : fdopen(fd, "w+b");
+            ok = (runFile != nullptr) && (fwrite(run.data(), sizeof(diskEdgeRecordT), run.size(), runFile) == run.size());
+            if (runFile != nullptr) {
+                runFiles.push_back(runFile);
+            }
+            run.clear();
+        }
+    }
+    fclose(f);
+    std::map<std::string, vertexKeyT>().swap(nameToId);
+    sortRun(run);
+
+    FILE* out = ok ? fopen(diskName, "wb") : nullptr;
+    if (out == nullptr) {
+        printf("buildDiskGraph(): unable to write %s\n", diskName);
+        for (FILE* runFile : runFiles) {
+            fclose(runFile);
+        }
+        return false;
+    }
+    diskGraphHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, diskGraphMagic, sizeof(h.magic));
+    h.version = diskGraphVersion;
+    h.byteOrder = diskGraphByteOrder;
+    h.flags = (isDirected == 1) ? diskGraphDirected : 0;
+    h.numVerticies = names.size();
+    h.rowsAt = sizeof(h);
+    ok = (fwrite(&h, sizeof(h), 1, out) == 1);
+
+    // merge the runs by (from, run), the earlier run first on a tie
+    std::vector<edgeRunT> runs(runFiles.size() + 1);
+    typedef std::pair<vertexKeyT, size_t> headT;
+    std::priority_queue<headT, std::vector<headT>, std::greater<headT> > heads;
+    for (size_t r = 0; r < runs.size(); ++r) {
+        if (r < runFiles.size()) {
+            runs[r].f = runFiles[r];
+            rewind(runFiles[r]);
+        } else {
+            runs[r].memory = &run;
+        }
+        if (runs[r].advance()) {
+            heads.push(headT(runs[r].e.from, r));
+        }
+    }
+    std::vector<diskRowIndexT> index(names.size(), diskRowIndexT{0, 0, 0});
+    rowEncoderT row;
+    vertexKeyT rowVertex = diskGraphClass::noVertex;
+    std::unordered_set<vertexKeyT> rowTargets; // for the duplicate check
+    uint64_t offset = h.rowsAt;
+    auto endRow = [&]() {
+        if (rowVertex == diskGraphClass::noVertex) {
+            return;
+        }
+        index[rowVertex] = diskRowIndexT{offset, row.degree, (uint32_t) row.bytes.size()};
+        ok = (fwrite(row.bytes.data(), 1, row.bytes.size(), out) == row.bytes.size()) && ok;
+        offset += row.bytes.size();
+        h.numSlots += row.degree;
+    };
+    while (!heads.empty()) {
+        edgeRunT& r = runs[heads.top().second];
+        size_t runNumber = heads.top().second;
+        heads.pop();
+        if (r.e.from != rowVertex) {
+            endRow();
+            rowVertex = r.e.from;
+            row.start(rowVertex);
+            rowTargets.clear();
+        }
+        // as readGraph, the first of repeated edges is kept. A self loop
+        // is in its row twice, as in the other stores, so is not checked
+        bool repeated = (r.e.to != r.e.from) && !rowTargets.insert(r.e.to).second;
+        if (!repeated) {
+            row.add(r.e.to, r.e.weight);
+        } else if ((r.e.from < r.e.to) && logging(logWarning)) {
+            printf("readGraph(): duplicate edge from %s to %s; not inserted again\n", names[r.e.from].c_str(), names[r.e.to].c_str());
+        }
+        if (r.advance()) {
+            heads.push(headT(r.e.from, runNumber));
+        }
+    }
+    endRow();
+    for (FILE* runFile : runFiles) {
+        fclose(runFile);
+    }
+
+    h.indexAt = offset;
+    ok = (fwrite(index.data(), sizeof(diskRowIndexT), index.size(), out) == index.size()) && ok;
+    offset += sizeof(diskRowIndexT) * index.size();
+    h.namesAt = offset;
+    for (const auto &name : names) {
+        ok = (fwrite(name.c_str(), 1, name.size() + 1, out) == name.size() + 1) && ok;
+        offset += name.size() + 1;
+    }
+    h.fileBytes = offset;
+    ok = (fseek(out, 0, SEEK_SET) == 0) && (fwrite(&h, sizeof(h), 1, out) == 1) && ok;
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        printf("buildDiskGraph(): error writing %s\n", diskName);
+        return false;
+    }
+    return returnVal;
+}
+
+//
+// the copy of superNodes and degreeBuckets still orders by other until
+// rebindKeyOrder points them here
+//
+diskGraphClass::diskGraphClass(const diskGraphClass& other) :
+    edgeCount(other.edgeCount),
+    directed(other.directed),
+    rowFile(other.rowFile),
+    fileName(other.fileName),
+    cacheBytes(other.cacheBytes),
+    logBytes(other.logBytes),
+    names(other.names),
+    numInputs(other.numInputs),
+    rows(other.rows),
+    logEdges(other.logEdges),
+    liveVerticies(other.liveVerticies),
+    members(other.members),
+    superNodes(other.superNodes),
+    trackDegrees(other.trackDegrees),
+    degreeBuckets(other.degreeBuckets) {
+    rebindKeyOrder();
+}
+
+void diskGraphClass::rebindKeyOrder() {
+    superNodes = std::set<vertexKeyT, keyLessT>(superNodes.begin(), superNodes.end(), keyLessT{this});
+    degreeBuckets.setLess(keyLessT{this});
+}
+
+//
+// reads the header, the row index and the names; the rows stay on disk
+//
+bool diskGraphClass::open(const char* diskName, size_t cacheMemory, size_t logMemory) {
+    int fd = ::open(diskName, O_RDONLY);
+    if (fd < 0) {
+        printf("diskGraphClass::open(): unable to open %s\n", diskName);
+        return false;
+    }
+    diskGraphHeader h;
+    struct stat st;
+    bool ok = preadAll(fd, &h, sizeof(h), 0) && (fstat(fd, &st) == 0) &&
+              (memcmp(h.magic, diskGraphMagic, sizeof(h.magic)) == 0) &&
+              (h.version == diskGraphVersion) && (h.byteOrder == diskGraphByteOrder) &&
+              (h.fileBytes == (uint64_t) st.st_size) && (h.namesAt <= h.fileBytes) &&
+              (h.indexAt + sizeof(diskRowIndexT) * h.numVerticies == h.namesAt);
+    if (!ok) {
+        printf("diskGraphClass::open(): %s is not a disk graph file\n", diskName);
+        close(fd);
+        return false;
+    }
+    std::vector<diskRowIndexT> index((size_t) h.numVerticies);
+    std::vector<char> nameChars((size_t) (h.fileBytes - h.namesAt));
+    if (!preadAll(fd, index.data(), sizeof(diskRowIndexT) * index.size(), h.indexAt) ||
+        !preadAll(fd, nameChars.data(), nameChars.size(), h.namesAt)) {
+        printf("diskGraphClass::open(): error reading %s\n", diskName);
+        close(fd);
+        return false;
+    }
+    std::shared_ptr<std::vector<std::string> > inputNames = std::make_shared<std::vector<std::string> >();
+    inputNames->reserve(index.size());
+    for (size_t at = 0; at < nameChars.size(); at += inputNames->back().size() + 1) {
+        inputNames->push_back(std::string(nameChars.data() + at));
+    }
+    if (inputNames->size() != index.size()) {
+        printf("diskGraphClass::open(): %s has %zu names for %zu verticies\n", diskName, inputNames->size(), index.size());
+        close(fd);
+        return false;
+    }
+
+    *this = diskGraphClass();
+    rowFile = std::make_shared<rowFileT>(fd, cacheMemory);
+    fileName = diskName;
+    cacheBytes = cacheMemory;
+    logBytes = logMemory;
+    directed = (h.flags & diskGraphDirected) != 0;
+    names = inputNames;
+    numInputs = (vertexKeyT) index.size();
+    rows.resize(index.size());
+    for (size_t x = 0; x < index.size(); ++x) {
+        rows[x].offset = index[x].offset;
+        rows[x].bytes = index[x].bytes;
+        rows[x].degree = index[x].degree;
+        rows[x].live = true;
+    }
+    liveVerticies = (int) numInputs;
+    edgeCount = (int) h.numSlots;
+    return true;
+}
+
+bool diskGraphClass::readRow(vertexKeyT x, std::vector<uint8_t>& bytes) const {
+    const rowRecord& r = rows[x];
+    if (r.bytes == 0) {
+        return false;
+    }
+    bytes.resize(r.bytes);
+    if (!rowFile->read(r.offset, r.bytes, bytes.data())) {
+        printf("diskGraphClass: error reading the edges of %s from %s\n", vertexName(x).c_str(), fileName.c_str());
+        return false;
+    }
+    return true;
+}
+
+void diskGraphClass::sortedNeighbors(vertexKeyT x, std::vector<vertexKeyT>& neighbors) const {
+    neighbors.clear();
+    neighbors.reserve(rows[x].degree);
+    forEachNeighbor(x, [&](vertexKeyT y) {
+        neighbors.push_back(y);
+    });
+    std::sort(neighbors.begin(), neighbors.end());
+}
+
+//
+// The member names of a vertex, for joinedNameLess
+//
+struct diskGraphClass::memberNameListT {
+    const diskGraphClass* g;
+    vertexKeyT m;
+    const std::string* next() {
+        if (m == noVertex) {
+            return nullptr;
+        }
+        const std::string* name = &g->memberName(m);
+        m = g->nextMember(m);
+        return name;
+    }
+};
+
+bool diskGraphClass::joinedKeyLess(vertexKeyT x, vertexKeyT y) const {
+    // the first names decide unless one begins the other
+    const std::string& nx = memberName(firstMember(x));
+    const std::string& ny = memberName(firstMember(y));
+    int c = memcmp(nx.data(), ny.data(), std::min(nx.size(), ny.size()));
+    if (c != 0) {
+        return c < 0;
+    }
+    return joinedNameLess(memberNameListT{this, firstMember(x)}, memberNameListT{this, firstMember(y)});
+}
+
+std::string diskGraphClass::vertexName(vertexKeyT x) const {
+    if (!isSuperNode(x)) {
+        return memberName(x);
+    }
+    std::string name = memberName(firstMember(x));
+    for (vertexKeyT m = nextMember(firstMember(x)); m != noVertex; m = nextMember(m)) {
+        name += ",";
+        name += memberName(m);
+    }
+    return name;
+}
+
+//
+// appends x->y to the log of x
+//
+void diskGraphClass::insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w) {
+    profileCount(counterEdgeInserts);
+    uint32_t e = (uint32_t) logEdges.size();
+    logEdges.push_back(logEdgeT{y, w, noLogEdge});
+    rowRecord& r = rows[x];
+    if (r.logTail == noLogEdge) {
+        r.logHead = e;
+    } else {
+        logEdges[r.logTail].next = e;
+    }
+    r.logTail = e;
+    ++r.degree;
+    ++edgeCount;
+    degreeChanged(x, r.degree - 1, r.degree);
+}
+
+void diskGraphClass::insertEdge(vertexKeyT x, vertexKeyT y, int w) {
+    insertEdgeUtility(x, y, w);
+    insertEdgeUtility(y, x, w);
+    if (logging(logTrace)) {
+        printf("adding edge %s to %s\n", vertexName(x).c_str(), vertexName(y).c_str());
+    }
+}
+
+//
+// deletes all the edges to and from x. The edges to x in the rows of its
+// neighbors stay, and are passed over once removeVertex marks x dead;
+// here only the degrees change
+//
+void diskGraphClass::disconnectVertex(vertexKeyT x) {
+    forEachNeighbor(x, [&](vertexKeyT y) {
+        if (y != x) {
+            profileCount(counterEdgeDeletes);
+            rowRecord& r = rows[y];
+            --r.degree;
+            --edgeCount;
+            degreeChanged(y, r.degree + 1, r.degree);
+        }
+    });
+    rowRecord& r = rows[x];
+    edgeCount -= r.degree;
+    degreeChanged(x, r.degree, 0);
+    r.degree = 0;
+    r.bytes = 0;
+    r.logHead = r.logTail = noLogEdge;
+}
+
+// marks x dead; its ID is never reused
+void diskGraphClass::removeVertex(vertexKeyT x) {
+    rows[x].live = false;
+    if (isSuperNode(x)) {
+        superNodes.erase(x);
+    }
+    --liveVerticies;
+}
+
+//
+// adds the super node of si and sj, which have been removed, with no
+// edges. Its members are those of si followed by those of sj
+//
+diskGraphClass::vertexKeyT diskGraphClass::appendSuperNode(vertexKeyT si, vertexKeyT sj) {
+    vertexKeyT id = (vertexKeyT) rows.size();
+    rows.push_back(rowRecord());
+    rows.back().live = true;
+    memberRecord none = { noVertex, noVertex, noVertex };
+    members.resize(rows.size(), none);
+    members[id].first = firstMember(si);
+    members[id].last = lastMember(sj);
+    members[lastMember(si)].next = firstMember(sj);
+    superNodes.insert(id);
+    ++liveVerticies;
+    return id;
+}
+
+void diskGraphClass::enableDegreeBuckets() {
+    degreeBuckets.clear();
+    forEachVertex([&](vertexKeyT x, int xDegree) {
+        degreeBuckets.update(x, 0, xDegree);
+    });
+    trackDegrees = true;
+}
+
+bool diskGraphClass::minDegreeVertex(vertexKeyT& x, int& xDegree) {
+    return degreeBuckets.first(x, xDegree);
+}
+
+void diskGraphClass::commonNeighbor(vertexKeyT si, vertexKeyT sj, std::vector<vertexKeyT>& returnVal) {
+    returnVal.clear();
+    std::vector<vertexKeyT> sjNeighbors;
+    sortedNeighbors(sj, sjNeighbors);
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) rows[si].degree + rows[sj].degree);
+    forEachNeighbor(si, [&](vertexKeyT c) {
+        if (std::binary_search(sjNeighbors.begin(), sjNeighbors.end(), c)) {
+            returnVal.push_back(c);
+        }
+    });
+}
+
+int diskGraphClass::commonNeighborCount(vertexKeyT si, vertexKeyT sj) const {
+    std::vector<vertexKeyT> a;
+    std::vector<vertexKeyT> b;
+    sortedNeighbors(si, a);
+    sortedNeighbors(sj, b);
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) a.size() + b.size());
+    return (int) intersectCount(a.data(), a.size(), b.data(), b.size());
+}
+
+//
+// Merge si and sj into a super node by
+//   1. deleting all edges linking si and sj in graph
+//   2. merging verticies si and sj into one super node
+//   3. linking in the supernode with the common neighbor links
+// then compacting if the log has outgrown its budget
+//
+diskGraphClass::vertexKeyT diskGraphClass::mergeVerticies(vertexKeyT si, vertexKeyT sj) {
+    // the common neighbors in the order of si, with w(si,c) + w(sj,c)
+    std::vector<vertexKeyT> commonNeighbors;
+    std::vector<int> commonWeights;
+    std::unordered_map<vertexKeyT, int> sjWeight;
+    profileCount(counterMerges);
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) rows[si].degree + rows[sj].degree);
+    forEachWeightedNeighbor(sj, [&](vertexKeyT c, int w) {
+        sjWeight[c] = w;
+    });
+    forEachWeightedNeighbor(si, [&](vertexKeyT c, int w) {
+        auto ctr = sjWeight.find(c);
+        if (ctr != sjWeight.end()) {
+            commonNeighbors.push_back(c);
+            commonWeights.push_back(w + ctr->second);
+        }
+    });
+    disconnectVertex(si); removeVertex(si);
+    disconnectVertex(sj); removeVertex(sj);
+    vertexKeyT newVertex = appendSuperNode(si, sj);
+    for (size_t c = 0; c < commonNeighbors.size(); ++c) {
+        // si and sj are common neighbors only through self loops, and are gone
+        if (rows[commonNeighbors[c]].live) {
+            insertEdge(newVertex, commonNeighbors[c], commonWeights[c]);
+        }
+    }
+    if (logEdges.size() * sizeof(logEdgeT) > logBytes) {
+        compact();
+    }
+    return newVertex;
+}
+
+//
+// Writes the rows as they are now, the live edges of the row on disk and
+// of the log, to a new row file and empties the log. IDs do not change.
+// The new file is a scratch file next to the graph file, and the old
+// one is still read by the copies that share it
+//
+bool diskGraphClass::compact() {
+    profileTimerClass timer("diskGraphClass compact");
+    int fd = openScratchFile(fileName);
+    int writeFd = (fd < 0) ? -1 : dup(fd);
+    FILE* f = (writeFd < 0) ? nullptr : fdopen(writeFd, "wb");
+    bool ok = (f != nullptr);
+    std::vector<diskRowIndexT> index(rows.size(), diskRowIndexT{0, 0, 0});
+    rowEncoderT row;
+    uint64_t offset = 0;
+    for (vertexKeyT x = 0; ok && (x < rows.size()); ++x) {
+        if (!rows[x].live || (rows[x].degree == 0)) {
+            continue;
+        }
+        row.start(x);
+        forEachWeightedNeighbor(x, [&](vertexKeyT y, int w) {
+            row.add(y, w);
+        });
+        index[x] = diskRowIndexT{offset, row.degree, (uint32_t) row.bytes.size()};
+        ok = (fwrite(row.bytes.data(), 1, row.bytes.size(), f) == row.bytes.size());
+        offset += row.bytes.size();
+    }
+    ok = (f != nullptr) && (fclose(f) == 0) && ok;
+    if (!ok) {
+        // the log is kept instead, and grows without bound
+        printf("diskGraphClass::compact(): error writing a scratch file next to %s; edges are kept in memory\n", fileName.c_str());
+        if (fd >= 0) {
+            close(fd);
+        }
+        logBytes = std::numeric_limits<size_t>::max();
+        return false;
+    }
+    if (logging(logInfo)) {
+        printf("diskGraphClass::compact(): %zu log edges into %llu bytes of rows\n", logEdges.size(), (unsigned long long) offset);
+    }
+    rowFile = std::make_shared<rowFileT>(fd, cacheBytes);
+    for (vertexKeyT x = 0; x < rows.size(); ++x) {
+        rows[x].offset = index[x].offset;
+        rows[x].bytes = index[x].bytes;
+        rows[x].logHead = rows[x].logTail = noLogEdge;
+    }
+    logEdges.clear();
+    return true;
+}
+
+bool diskGraphClass::writeGraph(FILE* f) {
+    fprintf(f, "%d %d %i\n", liveVerticies, edgeCount, (directed?1:0));
+    // print the vertex names
+    forEachVertex([&](vertexKeyT x, int) {
+        fprintf(f, "%s\n", vertexName(x).c_str());
+    });
+    forEachVertex([&](vertexKeyT x, int) {
+        std::string xName = vertexName(x);
+        forEachWeightedNeighbor(x, [&](vertexKeyT y, int w) {
+            fprintf(f, "%s ", xName.c_str());
+            fprintf(f, "%s ", vertexName(y).c_str());
+            fprintf(f, "%i\n", w);
+        });
+    });
+    return true;
+}
+
+//
+// checks everything for consistency. Every row is read, so this costs
+// a pass over the file, and the back pointer check a row for each edge
+//
+void diskGraphClass::checkGraph() {
+    int checkEdgeCount = 0; // count edges in graph
+    int checkVerticies = 0; // count live verticies
+    std::vector<vertexKeyT> row;
+    std::vector<vertexKeyT> yRow;
+    for (vertexKeyT x = 0; x < rows.size(); ++x) {
+        const rowRecord& r = rows[x];
+        if (!r.live) {
+            if (r.degree != 0) {
+                printf("checkGraph(): deleted vertex %u still has %u edges\n", x, r.degree);
+            }
+            continue;
+        }
+        ++checkVerticies;
+        const std::string& name = vertexName(x);
+        if (isSuperNode(x) && (superNodes.count(x) == 0)) {
+            printf("checkGraph(): vertex %s is not in the dictionary\n", name.c_str());
+        }
+        sortedNeighbors(x, row);
+        checkEdgeCount += (int) row.size();
+        if (row.size() != r.degree) {
+            printf("checkGraph(): vertex %s has %zu edges but degree %u\n", name.c_str(), row.size(), r.degree);
+        }
+        for (size_t i = 0; i < row.size(); ++i) {
+            vertexKeyT y = row[i];
+            if ((i > 0) && (row[i - 1] == y)) {
+                printf("checkGraph(): Duplicate edge %s to %s\n", name.c_str(), vertexName(y).c_str());
+                continue;
+            }
+            // If undirected graph, give error if no back pointer
+            if (!directed) {
+                sortedNeighbors(y, yRow);
+                if (!std::binary_search(yRow.begin(), yRow.end(), x)) {
+                    printf("checkGraph(): undirected graph edge %s to %s does not have back pointer\n", name.c_str(), vertexName(y).c_str());
+                }
+            }
+        }
+    }
+    if (checkVerticies != liveVerticies) {
+        printf("checkGraph(): vertex count is wrong: should be %i but is %i\n", checkVerticies, liveVerticies);
+    }
+    if (checkEdgeCount != edgeCount) {
+        printf("checkGraph(): edge count on graph is wrong: should be %i but is %i\n", checkEdgeCount, edgeCount);
+    }
+}
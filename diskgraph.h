@@ -0,0 +1,340 @@
+//
+//  diskgraph.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__diskgraph__
+#define __CliquePartitioning__diskgraph__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <set>
+#include <memory>
+#include "logging.h"
+#include "profile.h"
+#include "degreebuckets.h"
+#include "partition.h"
+
+//
+// Out of core graph store, for graphs whose edges do not fit in memory.
+// The verticies, their names and a few words of state each stay in
+// memory; the edge lists stay on disk and are read a row at a time
+// through a page cache of bounded size. BhaskerAlgorithm only ever looks
+// at the neighborhood of p, so its working set is that neighborhood and
+// not the graph.
+//
+// buildDiskGraph turns a text graph into a disk graph file with an
+// external sort: the edges are cut into sorted runs that fit the memory
+// budget and the runs merged into rows. The file holds
+//   diskGraphHeader
+//   rows                                   edge lists, see below
+//   diskRowIndexT index[numVerticies]      where each row is
+//   char names[]                           NUL terminated, in key order
+// Vertex IDs are 0..numVerticies-1 in key order. A row is the edges of
+// one vertex in insertion order, each the zigzag varint of the change
+// from the vertex before (the vertex itself for the first edge) and the
+// zigzag varint of the weight. Numbers are in the byte order of the
+// machine that wrote the file.
+//
+// The file is never written once built. A merge only removes edges to
+// si and sj, which are dead from then on, and adds the edges of the
+// super node. So the edges of a vertex are those of its row on disk that
+// go to live verticies, followed by those it gained since, which are
+// kept in memory in an append log. Once the log outgrows its budget the
+// current rows are compacted into a new row file, and the log emptied.
+// Row files made by compaction are unlinked as soon as they are made and
+// go away with the last graph that reads them.
+//
+// Copies share the row files and their cache, so the working copy of
+// the algorithms costs the in memory part only. Super nodes keep the
+// list of their members like csrGraphClass, and keyLess orders them by
+// their joined names in the same way.
+//
+// Edges are only ever given in the order they were inserted, as in the
+// other stores, so the algorithms find the same cliques on all of them.
+//
+
+struct diskGraphHeader {
+    char magic[8];              // "CLQDISKG"
+    uint32_t version;           // diskGraphVersion
+    uint32_t byteOrder;         // diskGraphByteOrder as written
+    uint32_t flags;             // diskGraphDirected
+    uint32_t reserved;
+    uint64_t numVerticies;
+    uint64_t numSlots;          // edge list entries, both directions of each edge
+    // file offsets of the sections
+    uint64_t rowsAt;
+    uint64_t indexAt;
+    uint64_t namesAt;
+    uint64_t fileBytes;
+};
+
+struct diskRowIndexT {
+    uint64_t offset;            // file offset of the row
+    uint32_t degree;            // # edges in the row
+    uint32_t bytes;             // # bytes of the row
+};
+
+const char diskGraphMagic[8] = { 'C', 'L', 'Q', 'D', 'I', 'S', 'K', 'G' };
+const uint32_t diskGraphVersion = 1;
+const uint32_t diskGraphByteOrder = 0x01020304;
+const uint32_t diskGraphDirected = (1 << 0);
+
+// memory used by buildDiskGraph and a diskGraphClass unless told otherwise
+const size_t diskGraphDefaultMemory = (size_t) 256 << 20;
+
+//
+// Reads the text graph textName, in the format of readGraph and with its
+// diagnostics, into the disk graph file diskName. Sorts in runs of at
+// most memoryBytes, written to scratch files next to diskName. Returns
+// false if a line could not be read, after building the graph of the
+// lines before it as readGraph does, or if a file could not be written
+//
+bool buildDiskGraph(const char* textName, const char* diskName, size_t memoryBytes = diskGraphDefaultMemory);
+
+// appends x as a varint, 7 bits a byte, low bits first
+inline void diskPutVarint(std::vector<uint8_t>& bytes, uint64_t x) {
+    while (x >= 0x80) {
+        bytes.push_back((uint8_t) (x | 0x80));
+        x >>= 7;
+    }
+    bytes.push_back((uint8_t) x);
+}
+
+inline uint64_t diskGetVarint(const uint8_t*& p) {
+    uint64_t x = 0;
+    for (int shift = 0; ; shift += 7) {
+        uint8_t b = *p++;
+        x |= (uint64_t) (b & 0x7f) << shift;
+        if (b < 0x80) {
+            return x;
+        }
+    }
+}
+
+inline uint64_t diskZigzag(int64_t x) { return ((uint64_t) x << 1) ^ (uint64_t) (x >> 63); }
+inline int64_t diskUnzigzag(uint64_t x) { return (int64_t) (x >> 1) ^ -(int64_t) (x & 1); }
+
+class diskGraphClass {
+public:
+    //
+    // vertex key is the vertex ID
+    //
+    typedef uint32_t vertexKeyT;
+    static const vertexKeyT noVertex = 0xffffffffu;
+    static const int maxVertexNameLength = 256;
+
+    int edgeCount = 0; // number of edges in the graph
+    bool directed = false;
+
+private:
+    // a row file and its page cache, see diskgraph.cpp
+    struct rowFileT;
+    //
+    // The in memory part of a vertex. Its row is in rowFile at offset,
+    // bytes 0 for none. Its edges since are the log entries from logHead
+    //
+    static const uint32_t noLogEdge = 0xffffffffu;
+    struct rowRecord {
+        uint64_t offset;
+        uint32_t bytes;
+        uint32_t degree;        // # live edges, in the row and in the log
+        uint32_t logHead;
+        uint32_t logTail;
+        bool live;              // false once the vertex is merged away
+        rowRecord() : offset(0), bytes(0), degree(0), logHead(noLogEdge), logTail(noLogEdge), live(false) {
+            // empty
+        }
+    };
+    struct logEdgeT {
+        vertexKeyT to;
+        int weight;
+        uint32_t next;
+    };
+
+    std::shared_ptr<const rowFileT> rowFile;
+    std::string fileName;       // of the graph file, where compaction writes
+    size_t cacheBytes = diskGraphDefaultMemory / 2;
+    size_t logBytes = diskGraphDefaultMemory / 4;
+    // names of the input verticies 0..numInputs-1, shared by the copies;
+    // super nodes are numbered from numInputs on
+    std::shared_ptr<const std::vector<std::string> > names;
+    vertexKeyT numInputs = 0;
+    std::vector<rowRecord> rows;
+    std::vector<logEdgeT> logEdges;
+    int liveVerticies = 0;
+
+    //
+    // Members of the super nodes, as in csrGraphClass. members[x].first
+    // and last are the ends of the list of super node x, and
+    // members[m].next the member after input vertex m
+    //
+    struct memberRecord {
+        vertexKeyT first;
+        vertexKeyT last;
+        vertexKeyT next;
+    };
+    std::vector<memberRecord> members;
+    bool isSuperNode(vertexKeyT x) const { return x >= numInputs; }
+    vertexKeyT firstMember(vertexKeyT x) const { return isSuperNode(x) ? members[x].first : x; }
+    vertexKeyT lastMember(vertexKeyT x) const { return isSuperNode(x) ? members[x].last : x; }
+    vertexKeyT nextMember(vertexKeyT m) const { return (m < members.size()) ? members[m].next : noVertex; }
+    const std::string& memberName(vertexKeyT m) const { return (*names)[m]; }
+    struct memberNameListT;
+    bool joinedKeyLess(vertexKeyT x, vertexKeyT y) const;
+    //
+    // orders IDs by key for the ordered sets below. It points back at the
+    // graph, so copies and swaps point it at the new owner, see rebindKeyOrder
+    //
+    struct keyLessT {
+        const diskGraphClass* g;
+        bool operator()(vertexKeyT x, vertexKeyT y) const { return g->keyLess(x, y); }
+    };
+    // the live super nodes in key order
+    std::set<vertexKeyT, keyLessT> superNodes{keyLessT{this}};
+    void rebindKeyOrder();
+    bool trackDegrees = false;
+    degreeBucketClass<vertexKeyT, keyLessT> degreeBuckets{keyLessT{this}};
+    void degreeChanged(vertexKeyT x, int oldDegree, int newDegree) {
+        if (trackDegrees) {
+            degreeBuckets.update(x, oldDegree, newDegree);
+        }
+    }
+
+    // copies the row of x on disk to bytes; false if there is none
+    bool readRow(vertexKeyT x, std::vector<uint8_t>& bytes) const;
+    // the live neighbors of x, sorted
+    void sortedNeighbors(vertexKeyT x, std::vector<vertexKeyT>& neighbors) const;
+    void insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w);
+    void disconnectVertex(vertexKeyT x);
+    void removeVertex(vertexKeyT x);
+    vertexKeyT appendSuperNode(vertexKeyT si, vertexKeyT sj);
+    bool compact();
+
+public:
+    // constructor
+    diskGraphClass() {};
+    // a copy shares the row files and copies the in memory part
+    diskGraphClass(const diskGraphClass& other);
+    // move constructor
+    diskGraphClass(diskGraphClass&& other) : diskGraphClass() {
+        swap(*this, other);
+    }
+    // copy operator
+    diskGraphClass& operator= (diskGraphClass rhs) {
+        swap(*this, rhs);
+        return *this;
+    }
+
+    //
+    // opens a file made by buildDiskGraph. cacheMemory bounds the page
+    // cache, and logMemory the append log before it is compacted
+    //
+    bool open(const char* diskName, size_t cacheMemory = diskGraphDefaultMemory / 2,
+              size_t logMemory = diskGraphDefaultMemory / 4);
+
+    int numVerticies() const { return liveVerticies; }
+    int numEdges() const { return edgeCount; }
+    bool writeGraph(FILE* ofile);
+
+    void insertEdge(vertexKeyT x, vertexKeyT y, int w);
+    void commonNeighbor(vertexKeyT si, vertexKeyT sj, std::vector<vertexKeyT>& returnVal);
+    // number of common neighbors, without building the list
+    int commonNeighborCount(vertexKeyT si, vertexKeyT sj) const;
+
+    // start keeping the verticies in buckets by degree
+    void enableDegreeBuckets();
+    // first vertex in key order of smallest non-zero degree; needs enableDegreeBuckets()
+    bool minDegreeVertex(vertexKeyT& x, int& xDegree);
+
+    //
+    // accessors shared with the other stores, see cliquepartition.h
+    //
+    int degree(vertexKeyT x) const { return (int) rows[x].degree; }
+    // the name of x; for a super node, made from its members
+    std::string vertexName(vertexKeyT x) const;
+    // true if x comes before y in key order. Input verticies are
+    // numbered in key order, so only super nodes compare names
+    bool keyLess(vertexKeyT x, vertexKeyT y) const {
+        if (!isSuperNode(x) && !isSuperNode(y)) {
+            return x < y;
+        }
+        return joinedKeyLess(x, y);
+    }
+    // calls f(key, degree) for each vertex in key order
+    template <typename F> void forEachVertex(F f) const {
+        auto str = superNodes.begin();
+        for (vertexKeyT x = 0; x < numInputs; ++x) {
+            if (!rows[x].live) {
+                continue;
+            }
+            while ((str != superNodes.end()) && keyLess(*str, x)) {
+                f(*str, (int) rows[*str].degree);
+                ++str;
+            }
+            f(x, (int) rows[x].degree);
+        }
+        for (; str != superNodes.end(); ++str) {
+            f(*str, (int) rows[*str].degree);
+        }
+    }
+    // calls f(neighborKey, weight) for each edge of x in insertion order
+    template <typename F> void forEachWeightedNeighbor(vertexKeyT x, F f) const {
+        std::vector<uint8_t> bytes;
+        if (readRow(x, bytes)) {
+            const uint8_t* p = bytes.data();
+            const uint8_t* end = p + bytes.size();
+            int64_t y = x;
+            while (p < end) {
+                y += diskUnzigzag(diskGetVarint(p));
+                int w = (int) diskUnzigzag(diskGetVarint(p));
+                if (rows[(vertexKeyT) y].live) {
+                    f((vertexKeyT) y, w);
+                }
+            }
+        }
+        for (uint32_t e = rows[x].logHead; e != noLogEdge; e = logEdges[e].next) {
+            if (rows[logEdges[e].to].live) {
+                f(logEdges[e].to, logEdges[e].weight);
+            }
+        }
+    }
+    // calls f(neighborKey) for each edge of x in insertion order
+    template <typename F> void forEachNeighbor(vertexKeyT x, F f) const {
+        forEachWeightedNeighbor(x, [&](vertexKeyT y, int) {
+            f(y);
+        });
+    }
+    // replaces si and sj by the super node "si,sj" linked to their
+    // common neighbors, each edge weighted w(si,c) + w(sj,c); returns
+    // the ID of the super node
+    vertexKeyT mergeVerticies(vertexKeyT si, vertexKeyT sj);
+
+    friend void swap(diskGraphClass& first, diskGraphClass& second) {
+        using std::swap;
+        swap(first.edgeCount, second.edgeCount);
+        swap(first.directed, second.directed);
+        swap(first.rowFile, second.rowFile);
+        swap(first.fileName, second.fileName);
+        swap(first.cacheBytes, second.cacheBytes);
+        swap(first.logBytes, second.logBytes);
+        swap(first.names, second.names);
+        swap(first.numInputs, second.numInputs);
+        swap(first.rows, second.rows);
+        swap(first.logEdges, second.logEdges);
+        swap(first.liveVerticies, second.liveVerticies);
+        swap(first.members, second.members);
+        swap(first.superNodes, second.superNodes);
+        swap(first.trackDegrees, second.trackDegrees);
+        swap(first.degreeBuckets, second.degreeBuckets);
+        first.rebindKeyOrder();
+        second.rebindKeyOrder();
+    }
+
+    // checks the graph for consistency
+    void checkGraph();
+};
+
+#endif /* defined(__CliquePartitioning__diskgraph__) */
@@ -0,0 +1,125 @@
+//
+//  edgeindex.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__edgeindex__
+#define __CliquePartitioning__edgeindex__
+
+#include <stdint.h>
+#include <vector>
+
+//
+// Index of the edge list of one vertex, from the vertex at the other
+// end of an edge to the record before the first edge to it. The edge
+// lists are singly linked, so the record before is what unlinking an
+// edge needs; noEdge stands for the head of the list. count is the
+// number of edges to the vertex in the list, more than one only for
+// repeated edges and self loops.
+//
+// Open addressing with linear probing in a table of twice the entries
+// or more, rounded to a power of two. Erasing shifts the entries after
+// back into the hole, so there are no tombstones and a lookup stops at
+// the first empty entry.
+//
+class edgeIndexClass {
+public:
+    typedef uint32_t keyT;
+    typedef uint32_t edgeIndexT;
+    static const keyT noKey = 0xffffffffu;
+
+    struct entryT {
+        keyT key;
+        edgeIndexT before;
+        uint32_t count;
+    };
+
+private:
+    std::vector<entryT> table;
+    size_t numEntries = 0;
+
+    size_t home(keyT key) const {
+        return (size_t) ((key * 0x9e3779b1u) & (table.size() - 1));
+    }
+    void grow() {
+        std::vector<entryT> old;
+        old.swap(table);
+        table.assign(old.empty() ? 16 : 2 * old.size(), entryT{noKey, 0, 0});
+        numEntries = 0;
+        for (const auto &e : old) {
+            if (e.key != noKey) {
+                *insertKey(e.key) = e;
+            }
+        }
+    }
+    // the entry for key, made empty but for the key if it is new
+    entryT* insertKey(keyT key) {
+        if (2 * (numEntries + 1) > table.size()) {
+            grow();
+        }
+        size_t mask = table.size() - 1;
+        for (size_t i = home(key); ; i = (i + 1) & mask) {
+            if (table[i].key == key) {
+                return &table[i];
+            }
+            if (table[i].key == noKey) {
+                table[i] = entryT{key, 0, 0};
+                ++numEntries;
+                return &table[i];
+            }
+        }
+    }
+
+public:
+    void clear() {
+        std::vector<entryT>().swap(table);
+        numEntries = 0;
+    }
+    size_t size() const { return numEntries; }
+
+    entryT* find(keyT key) {
+        if (table.empty()) {
+            return nullptr;
+        }
+        size_t mask = table.size() - 1;
+        for (size_t i = home(key); table[i].key != noKey; i = (i + 1) & mask) {
+            if (table[i].key == key) {
+                return &table[i];
+            }
+        }
+        return nullptr;
+    }
+    const entryT* find(keyT key) const {
+        return const_cast<edgeIndexClass*>(this)->find(key);
+    }
+    // counts one more edge to key; before is used if it is the first
+    void insert(keyT key, edgeIndexT before) {
+        entryT* e = insertKey(key);
+        if (e->count++ == 0) {
+            e->before = before;
+        }
+    }
+    // removes the entry of key with all its count
+    void erase(keyT key) {
+        entryT* e = find(key);
+        if (e == nullptr) {
+            return;
+        }
+        size_t mask = table.size() - 1;
+        size_t hole = (size_t) (e - table.data());
+        for (size_t i = (hole + 1) & mask; table[i].key != noKey; i = (i + 1) & mask) {
+            // an entry moves back into the hole unless its home lies
+            // cyclically in (hole, i]
+            size_t h = home(table[i].key);
+            bool stays = (hole <= i) ? ((hole < h) && (h <= i)) : ((hole < h) || (h <= i));
+            if (!stays) {
+                table[hole] = table[i];
+                hole = i;
+            }
+        }
+        table[hole].key = noKey;
+        --numEntries;
+    }
+};
+
+#endif /* defined(__CliquePartitioning__edgeindex__) */
@@ -7,51 +7,250 @@
 //
 
 #include "graphdb.h"
+#include <unordered_map>
+#include <unordered_set>
 
-// copies the verticies and their edgelists
+// const member definitions
+const graphDatabaseClass::edgeIndexT graphDatabaseClass::noEdge;
+const graphDatabaseClass::vertexSlotT graphDatabaseClass::noSlot;
+const uint32_t graphDatabaseClass::noIndex;
+const int graphDatabaseClass::defaultEdgeIndexDegree;
+const size_t graphDatabaseClass::parallelBulkEdges;
+
+//
+// copies the verticies and their edgelists. Edge records link by index
+// and name verticies by slot, so the edge pool is copied as one block;
+// only the slot table has to be pointed at the new verticies.
+//
+// On a large graph the verticies, the degree buckets, pieces of the
+// edge pool and runs of the edge indexes are copied side by side. The
+// map of verticies cannot be split, so it is one task, handed out first
+//
 void graphDatabaseClass::deepCopy(const graphDatabaseClass& src) {
     edgeCount = src.edgeCount;
     directed = src.directed;
-	// copy the verticies
-	verticies = src.verticies;
-	// copy the edge lists
-	auto dstVertex = verticies.begin();
-	auto srcVertex = src.verticies.begin();
-	while((dstVertex != verticies.end()) && (srcVertex != src.verticies.end())) {
-		dstVertex->second.vertexBits = srcVertex->second.vertexBits;
-		// copy the edge list
-		if (srcVertex->second.edgeList) {
-			// copy first edge
-			dstVertex->second.edgeList = new edgeRecord(*srcVertex->second.edgeList);
-			// copy the remaining edges
-			edgeRecord* dstEdge = dstVertex->second.edgeList;
-			edgeRecord* srcEdge = srcVertex->second.edgeList;
-			while(srcEdge->next != nullptr) {
-				dstEdge->next = new edgeRecord(*srcEdge->next);
-				srcEdge = srcEdge->next;
-				dstEdge = dstEdge->next;
+    bulkThreads = src.bulkThreads;
+    trackDegrees = src.trackDegrees;
+	freeSlots = src.freeSlots;
+	edgeIndexDegree = src.edgeIndexDegree;
+	freeEdgeIndexes = src.freeEdgeIndexes;
+	edgePool.copyShape(src.edgePool);
+	edgeIndexes.resize(src.edgeIndexes.size());
+	threadPoolClass pool(bulkThreadsFor(src.edgePool.blockSize()));
+	size_t numPieces = (pool.size() == 1) ? 1 : 4 * pool.size();
+	size_t numRecords = src.edgePool.blockSize();
+	size_t numIndexes = src.edgeIndexes.size();
+	// task 0 is the verticies, 1 the degree buckets, then the pieces of
+	// the edge pool and the runs of the edge indexes
+	pool.parallelFor(2 + 2 * numPieces, [&](size_t t) {
+		if (t == 0) {
+			verticies = src.verticies;
+			vertexSlots.assign(src.vertexSlots.size(), nullptr);
+			for (auto &vtr : verticies) {
+				if (vtr.second.slot != noSlot) {
+					vertexSlots[vtr.second.slot] = &vtr;
+				}
+			}
+		} else if (t == 1) {
+			degreeBuckets = src.degreeBuckets;
+		} else if (t < 2 + numPieces) {
+			size_t piece = t - 2;
+			edgePool.copyRecords(src.edgePool, numRecords * piece / numPieces, numRecords * (piece + 1) / numPieces);
+		} else {
+			size_t piece = t - 2 - numPieces;
+			for (size_t i = numIndexes * piece / numPieces; i < numIndexes * (piece + 1) / numPieces; ++i) {
+				edgeIndexes[i] = src.edgeIndexes[i];
 			}
 		}
-		++dstVertex;
-		++srcVertex;
-	}
+	});
 }
 
 //
 // deletes all the edges
 //
 void graphDatabaseClass::clearEdgeLists() {
-	edgeRecord* edgeToDelete = nullptr;
-    verticiesT::iterator vtr;
-    for (vtr = verticies.begin(); vtr != verticies.end(); ++vtr) {
-		edgeRecord* e = vtr->second.edgeList;
-		while (e != nullptr) {
-			edgeToDelete = e;
-			e = e->next;
-			delete edgeToDelete;
+	threadPoolClass pool(bulkThreadsFor(edgePool.blockSize()));
+	releaseStorage(pool, false);
+}
+
+unsigned int graphDatabaseClass::bulkThreadsFor(size_t numRecords) const {
+	return (numRecords < parallelBulkEdges) ? 1 : bulkThreads;
+}
+
+//
+// Each edge index and the map of verticies are blocks of their own, so
+// the index tables are freed in runs while one task frees or resets
+// the verticies
+//
+void graphDatabaseClass::releaseStorage(threadPoolClass& pool, bool dropVerticies) {
+	size_t numPieces = (pool.size() == 1) ? 1 : 4 * pool.size();
+	size_t numIndexes = edgeIndexes.size();
+	pool.parallelFor(2 + numPieces, [&](size_t t) {
+		if (t == 0) {
+			if (dropVerticies) {
+				verticiesT().swap(verticies);
+				std::vector<verticiesT::value_type*>().swap(vertexSlots);
+			} else {
+				for (auto &vtr : verticies) {
+					vtr.second.edgeList = noEdge;
+					vtr.second.edgeTail = noEdge;
+					vtr.second.edgeIndex = noIndex;
+				}
+			}
+		} else if (t == 1) {
+			edgePool.clear();
+			if (dropVerticies) {
+				degreeBuckets.clear();
+			}
+		} else {
+			size_t piece = t - 2;
+			for (size_t i = numIndexes * piece / numPieces; i < numIndexes * (piece + 1) / numPieces; ++i) {
+				edgeIndexes[i].clear();
+			}
+		}
+	});
+	edgeIndexes.clear();
+	freeEdgeIndexes.clear();
+}
+
+void graphDatabaseClass::setEdgeIndexDegree(int minDegree) {
+	edgeIndexDegree = minDegree;
+	for (auto &vtr : verticies) {
+		vertexRecord& v = vtr.second;
+		if ((minDegree > 0) && (v.degree >= minDegree)) {
+			buildEdgeIndex(v);
+		} else {
+			dropEdgeIndex(v);
+		}
+	}
+}
+
+void graphDatabaseClass::buildEdgeIndex(vertexRecord& v) {
+	if (v.edgeIndex == noIndex) {
+		if (freeEdgeIndexes.empty()) {
+			v.edgeIndex = (uint32_t) edgeIndexes.size();
+			edgeIndexes.push_back(edgeIndexClass());
+		} else {
+			v.edgeIndex = freeEdgeIndexes.back();
+			freeEdgeIndexes.pop_back();
+		}
+	}
+	edgeIndexClass& index = edgeIndexes[v.edgeIndex];
+	index.clear();
+	edgeIndexT before = noEdge;
+	for (edgeIndexT e = v.edgeList; e != noEdge; before = e, e = edgePool[e].next) {
+		index.insert(edgePool[e].vertexSlot, before);
+	}
+}
+
+void graphDatabaseClass::dropEdgeIndex(vertexRecord& v) {
+	if (v.edgeIndex == noIndex) {
+		return;
+	}
+	edgeIndexes[v.edgeIndex].clear();
+	freeEdgeIndexes.push_back(v.edgeIndex);
+	v.edgeIndex = noIndex;
+}
+
+graphDatabaseClass::edgeIndexT graphDatabaseClass::findEdge(vertexRecord& v, vertexSlotT ySlot, edgeIndexT& before) {
+	before = noEdge;
+	if (v.edgeIndex != noIndex) {
+		const edgeIndexClass::entryT* entry = edgeIndexes[v.edgeIndex].find(ySlot);
+		if (entry == nullptr) {
+			return noEdge;
+		}
+		before = entry->before;
+		return (before == noEdge) ? v.edgeList : edgePool[before].next;
+	}
+	for (edgeIndexT e = v.edgeList; e != noEdge; before = e, e = edgePool[e].next) {
+		if (edgePool[e].vertexSlot == ySlot) {
+			return e;
 		}
-		vtr->second.edgeList = nullptr;
 	}
+	return noEdge;
+}
+
+void graphDatabaseClass::appendEdge(vertexRecord& v, edgeIndexT e) {
+	if (v.edgeTail == noEdge) {
+		v.edgeList = e;
+	} else {
+		edgePool[v.edgeTail].next = e;
+	}
+	if (v.edgeIndex != noIndex) {
+		edgeIndexes[v.edgeIndex].insert(edgePool[e].vertexSlot, v.edgeTail);
+	}
+	v.edgeTail = e;
+}
+
+//
+// unlinks e, the first edge of v to its vertex, with before the record
+// ahead of it. The index keeps the record before the first edge to each
+// vertex, so the edge after e now has before in place of e, and if e
+// was not the only edge to its vertex the next one becomes the first
+//
+void graphDatabaseClass::unlinkEdge(vertexRecord& v, edgeIndexT before, edgeIndexT e) {
+	edgeIndexT next = edgePool[e].next;
+	if (before == noEdge) {
+		v.edgeList = next;
+	} else {
+		edgePool[before].next = next;
+	}
+	if (v.edgeTail == e) {
+		v.edgeTail = before;
+	}
+	if (v.edgeIndex == noIndex) {
+		return;
+	}
+	edgeIndexClass& index = edgeIndexes[v.edgeIndex];
+	vertexSlotT slot = edgePool[e].vertexSlot;
+	edgeIndexClass::entryT* entry = index.find(slot);
+	if (--entry->count == 0) {
+		index.erase(slot);
+	} else {
+		edgeIndexT b = before;
+		for (edgeIndexT f = next; edgePool[f].vertexSlot != slot; b = f, f = edgePool[f].next);
+		entry->before = b;
+	}
+	if (next != noEdge) {
+		edgeIndexClass::entryT* nextEntry = index.find(edgePool[next].vertexSlot);
+		if (nextEntry->before == e) {
+			nextEntry->before = before;
+		}
+	}
+}
+
+//
+// slot of the vertex at vtr, giving it one if it has none
+//
+graphDatabaseClass::vertexSlotT graphDatabaseClass::slotOf(verticiesT::iterator vtr) {
+	vertexRecord& v = vtr->second;
+	if (v.slot == noSlot) {
+		if (freeSlots.empty()) {
+			v.slot = (vertexSlotT) vertexSlots.size();
+			vertexSlots.push_back(&*vtr);
+		} else {
+			v.slot = freeSlots.back();
+			freeSlots.pop_back();
+			vertexSlots[v.slot] = &*vtr;
+		}
+	}
+	return v.slot;
+}
+
+//
+// erases x from the verticies and frees its slot
+//
+void graphDatabaseClass::eraseVertex(const vertexKeyT& x) {
+	auto vtr = verticies.find(x);
+	if (vtr == verticies.end()) {
+		return;
+	}
+	if (vtr->second.slot != noSlot) {
+		vertexSlots[vtr->second.slot] = nullptr;
+		freeSlots.push_back(vtr->second.slot);
+	}
+	dropEdgeIndex(vtr->second);
+	verticies.erase(vtr);
 }
 
 graphDatabaseClass::graphDatabaseClass() {
@@ -72,29 +271,42 @@ graphDatabaseClass& graphDatabaseClass::operator= (graphDatabaseClass rhs) {
 };
 
 graphDatabaseClass::~graphDatabaseClass() {
-	clearEdgeLists();
-	// rest are STL containers with own destructors
+	// the edge pool and the rest are STL containers with own destructors;
+	// a large graph frees them side by side instead of one after another
+	unsigned int numThreads = bulkThreadsFor(edgePool.blockSize());
+	if (numThreads != 1) {
+		threadPoolClass pool(numThreads);
+		releaseStorage(pool, true);
+	}
 };
 
 void graphDatabaseClass::initializeGraph(int numVerticies, bool isDirected) {
     directed = isDirected;
 	clearEdgeLists();
 	verticies.clear();
+	vertexSlots.clear();
+	freeSlots.clear();
+	degreeBuckets.clear();
 };
 
 
 void graphDatabaseClass::insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w) {
-	edgeRecord* newEdge = new edgeRecord;
-    newEdge->vertexID = y;
-    newEdge->weight = w;
-	if (verticies[x].edgeList) {
-        edgeRecord* e = verticies[x].edgeList;
-        for (; e->next != nullptr; e = e->next);
-		e->next = newEdge;
-		++verticies[x].degree;
-	} else {
-		verticies[x].edgeList = newEdge;
-		verticies[x].degree = 1;
+	// y gets a slot for the edge to name it by; insertEdge adds y->x next anyway
+	vertexSlotT ySlot = slotOf(verticies.insert(vertexT(y, vertexRecord())).first);
+	profileCount(counterEdgeInserts);
+	if (!edgePool.hasFree()) {
+		profileCount(counterEdgeAllocations);
+	}
+	edgeIndexT newEdge = edgePool.allocate();
+    edgePool[newEdge].vertexSlot = ySlot;
+    edgePool[newEdge].weight = w;
+    edgePool[newEdge].next = noEdge;
+	vertexRecord& v = verticies[x];
+	appendEdge(v, newEdge);
+	++v.degree;
+	degreeChanged(x, v.degree - 1, v.degree);
+	if ((v.edgeIndex == noIndex) && (edgeIndexDegree > 0) && (v.degree >= edgeIndexDegree)) {
+		buildEdgeIndex(v);
 	}
     ++edgeCount;
 }
@@ -102,39 +314,32 @@ void graphDatabaseClass::insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w) {
 void graphDatabaseClass::insertEdge(vertexKeyT x, vertexKeyT y, int w) {
 	insertEdgeUtility(x, y, w);
 	insertEdgeUtility(y, x, w);
-	if (noisy()) {
+	if (logging(logTrace)) {
 		printf("adding edge %s to %s\n", x.c_str(), y.c_str());
 	}
 }
 
 bool graphDatabaseClass::deleteEdgeUtility(vertexKeyT x, vertexKeyT y) {
 	bool returnVal = false;
-	if (verticies[x].edgeList->vertexID == y) {
-		// delete the head of the edgeList
-        edgeRecord* edgeToDelete = verticies[x].edgeList;
-		verticies[x].edgeList = verticies[x].edgeList->next;
-        delete edgeToDelete;
-        --edgeCount;
-		--verticies[x].degree;
+	profileCount(counterEdgeDeletes);
+	auto ytr = verticies.find(y);
+	vertexSlotT ySlot = (ytr == verticies.end()) ? noSlot : ytr->second.slot;
+	vertexRecord& v = verticies[x];
+	edgeIndexT before = noEdge;
+	// no edge can point to y without a slot
+	edgeIndexT edgeToDelete = (ySlot == noSlot) ? noEdge : findEdge(v, ySlot, before);
+	if (edgeToDelete != noEdge) {
+		unlinkEdge(v, before, edgeToDelete);
+		edgePool.release(edgeToDelete);
+		--edgeCount;
+		--v.degree;
+		degreeChanged(x, v.degree + 1, v.degree);
+		if (v.degree < edgeIndexDegree / 2) {
+			dropEdgeIndex(v);
+		}
 		returnVal = true;
-	} else {
-		// search the edge list for the edge to delete
-		edgeRecord* e = verticies[x].edgeList;
-		do {
-			if ((e->next != nullptr) && (e->next->vertexID == y)) {
-				edgeRecord* edgeToDelete = e->next;
-				e->next = e->next->next;
-				delete edgeToDelete;
-				returnVal = true;
-                --edgeCount;
-				--verticies[x].degree;
-				break;
-			} else {
-				e = e->next;
-			}
-		} while (e != nullptr);
 	}
-	if (noisy()) {
+	if (logging(logWarning)) {
 		if (returnVal == false) {
 			printf("deleteEdgeUtility(): Not able to find an edge to delete from %s to %s\n", x.c_str(), y.c_str());
 		}
@@ -151,20 +356,21 @@ bool graphDatabaseClass::deleteEdge(vertexKeyT x, vertexKeyT y) {
 }
 
 bool graphDatabaseClass::deleteVertex(vertexKeyT x) {
-	if (noisy()) {
+	if (logging(logTrace)) {
 		printf("deleting vertex %s\n", x.c_str());
 	}
-    if(verticies[x].edgeList != nullptr) {
+    if(verticies[x].edgeList != noEdge) {
         printf("Deleting a vertex with non-empty edgelist\n");
     }
+    degreeChanged(x, verticies[x].degree, 0);
 	// erase from the list of verticies
-	verticies.erase(x);
+	eraseVertex(x);
 	return true;
 }
 
 
 void graphDatabaseClass::insertVertex(vertexKeyT x) {
-    if (noisy()) {
+    if (logging(logTrace)) {
         printf("adding vertex %s\n", x.c_str());
     }
     auto vtr = verticies.find(x);
@@ -179,39 +385,249 @@ void graphDatabaseClass::insertVertex(vertexKeyT x) {
 // deletes all the edges to and from from vertex x
 //
 void graphDatabaseClass::disconnectVertex(vertexKeyT x) {
-	edgeRecord* e = verticies[x].edgeList;
-	edgeRecord* edgeToDelete = nullptr;
-	while (e != nullptr) {
-		edgeToDelete = e;
-		deleteEdgeUtility(e->vertexID, x); // delete the back edge
-		e = e->next;
-		delete edgeToDelete;
+	edgeIndexT e = verticies[x].edgeList;
+	while (e != noEdge) {
+		if (edgeVertex(edgePool[e]) != x) {
+			deleteEdgeUtility(edgeVertex(edgePool[e]), x); // delete the back edge
+		}
+		edgeIndexT edgeToDelete = e;
+		e = edgePool[e].next;
+		edgePool.release(edgeToDelete);
 		--edgeCount;
 	}
-	verticies[x].edgeList = nullptr;
+	verticies[x].edgeList = noEdge;
+	verticies[x].edgeTail = noEdge;
+	dropEdgeIndex(verticies[x]);
+	degreeChanged(x, verticies[x].degree, 0);
 	verticies[x].degree = 0;
 }
 
+void graphDatabaseClass::enableDegreeBuckets() {
+    degreeBuckets.clear();
+    for (const auto &vtr : verticies) {
+        degreeBuckets.update(vtr.first, 0, vtr.second.degree);
+    }
+    trackDegrees = true;
+}
+
 void graphDatabaseClass::commonNeighbor(vertexKeyT si, vertexKeyT sj, std::vector<vertexKeyT>& returnVal) {
     returnVal.clear();
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) verticies[si].degree * verticies[sj].degree);
     // go through each edgeList for si and sj to determine which edges have the same destination
-    for(edgeRecord* esi = verticies[si].edgeList; esi != nullptr; esi = esi->next) {
-        for(edgeRecord* esj = verticies[sj].edgeList; esj != nullptr; esj = esj->next) {
-            if(esi->vertexID == esj->vertexID) {
-                returnVal.push_back(esi->vertexID);
+    edgeIndexT sjEdges = verticies[sj].edgeList;
+    for(edgeIndexT esi = verticies[si].edgeList; esi != noEdge; esi = edgePool[esi].next) {
+        for(edgeIndexT esj = sjEdges; esj != noEdge; esj = edgePool[esj].next) {
+            if(edgePool[esi].vertexSlot == edgePool[esj].vertexSlot) {
+                returnVal.push_back(edgeVertex(edgePool[esi]));
+            }
+        }
+    }
+}
+
+int graphDatabaseClass::commonNeighborCount(const vertexKeyT& si, const vertexKeyT& sj) const {
+    int count = 0;
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) vertexAt(si).degree * vertexAt(sj).degree);
+    edgeIndexT sjEdges = vertexAt(sj).edgeList;
+    for(edgeIndexT esi = vertexAt(si).edgeList; esi != noEdge; esi = edgePool[esi].next) {
+        for(edgeIndexT esj = sjEdges; esj != noEdge; esj = edgePool[esj].next) {
+            if(edgePool[esi].vertexSlot == edgePool[esj].vertexSlot) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+//
+// Copies the edge lists record by record, linking each at the tail, so
+// the algorithms see the same edge order in sub as here. Edges to
+// verticies not in members are left out.
+//
+void graphDatabaseClass::inducedSubgraph(const std::vector<vertexKeyT>& members, graphDatabaseClass& sub) const {
+    sub.initializeGraph((int) members.size(), directed);
+    sub.edgeCount = 0;
+    sub.edgeIndexDegree = edgeIndexDegree;
+    for (const auto &x : members) {
+        sub.verticies[x].vertexBits = vertexAt(x).vertexBits;
+    }
+    for (const auto &x : members) {
+        verticiesT::iterator xtr = sub.verticies.find(x);
+        edgeIndexT tail = noEdge;
+        for (edgeIndexT e = vertexAt(x).edgeList; e != noEdge; e = edgePool[e].next) {
+            verticiesT::iterator ytr = sub.verticies.find(edgeVertex(edgePool[e]));
+            if (ytr == sub.verticies.end()) {
+                continue;
+            }
+            edgeIndexT newEdge = sub.edgePool.allocate();
+            sub.edgePool[newEdge].vertexSlot = sub.slotOf(ytr);
+            sub.edgePool[newEdge].weight = edgePool[e].weight;
+            sub.edgePool[newEdge].edgeBits = edgePool[e].edgeBits;
+            sub.edgePool[newEdge].next = noEdge;
+            if (tail == noEdge) {
+                xtr->second.edgeList = newEdge;
+            } else {
+                sub.edgePool[tail].next = newEdge;
+            }
+            tail = newEdge;
+            ++xtr->second.degree;
+            ++sub.edgeCount;
+        }
+        xtr->second.edgeTail = tail;
+        if ((edgeIndexDegree > 0) && (xtr->second.degree >= edgeIndexDegree)) {
+            sub.buildEdgeIndex(xtr->second);
+        }
+    }
+}
+
+//
+// Bulk construction. Edge i becomes records 2i, from->to, and 2i+1,
+// to->from, as insertEdge would allocate them, and the slots are given
+// out in the order insertEdge gives them, so the graph is the same to
+// the record. The edges are cut into runs, one per thread; each run
+// walks its edges backwards, linking the records it owns onto the front
+// of a list per vertex, and then the lists of each vertex are joined in
+// run order. A run keeps a head, tail and count per vertex, so there
+// are no more runs than records per vertex.
+//
+void graphDatabaseClass::buildFromEdges(const std::vector<vertexKeyT>& names, const std::vector<edgeT>& edges) {
+	struct runT {
+		std::vector<edgeIndexT> head;
+		std::vector<edgeIndexT> tail;
+		std::vector<int> count;
+	};
+	initializeGraph((int) names.size(), directed);
+	size_t n = names.size();
+	std::vector<verticiesT::value_type*> node(n);
+	for (size_t x = 0; x < n; ++x) {
+		node[x] = &*verticies.insert(vertexT(names[x], vertexRecord())).first;
+	}
+	std::vector<vertexSlotT> slot(n, noSlot);
+	for (const auto &e : edges) {
+		for (uint32_t x : {e.to, e.from}) {
+			if (slot[x] == noSlot) {
+				slot[x] = (vertexSlotT) vertexSlots.size();
+				node[x]->second.slot = slot[x];
+				vertexSlots.push_back(node[x]);
+			}
+		}
+		if (logging(logTrace)) {
+			printf("adding edge %s to %s\n", names[e.from].c_str(), names[e.to].c_str());
+		}
+	}
+
+	size_t numRecords = 2 * edges.size();
+	profileCount(counterEdgeInserts, numRecords);
+	profileCount(counterEdgeAllocations, numRecords);
+	edgePool.resizeBlock(numRecords);
+	threadPoolClass pool(bulkThreadsFor(numRecords));
+	size_t numRuns = std::max((size_t) 1, std::min((size_t) pool.size(), numRecords / std::max(n, (size_t) 1)));
+	std::vector<runT> runs(numRuns);
+	pool.parallelFor(numRuns, [&](size_t r) {
+		runT& run = runs[r];
+		run.head.assign(n, noEdge);
+		run.tail.assign(n, noEdge);
+		run.count.assign(n, 0);
+		auto link = [&](edgeIndexT k, uint32_t x, uint32_t y, int w) {
+			edgeRecord& rec = edgePool[k];
+			rec.vertexSlot = slot[y];
+			rec.weight = w;
+			rec.edgeBits = 0;
+			rec.next = run.head[x];
+			if (run.head[x] == noEdge) {
+				run.tail[x] = k;
+			}
+			run.head[x] = k;
+			++run.count[x];
+		};
+		for (size_t i = edges.size() * (r + 1) / numRuns; i-- > edges.size() * r / numRuns; ) {
+			const edgeT& e = edges[i];
+			link((edgeIndexT) (2 * i + 1), e.to, e.from, e.weight);
+			link((edgeIndexT) (2 * i), e.from, e.to, e.weight);
+		}
+	});
+	size_t numPieces = (pool.size() == 1) ? 1 : 4 * pool.size();
+	pool.parallelFor(numPieces, [&](size_t piece) {
+		for (size_t x = n * piece / numPieces; x < n * (piece + 1) / numPieces; ++x) {
+			vertexRecord& v = node[x]->second;
+			for (const auto &run : runs) {
+				if (run.head[x] == noEdge) {
+					continue;
+				}
+				if (v.edgeList == noEdge) {
+					v.edgeList = run.head[x];
+				} else {
+					edgePool[v.edgeTail].next = run.head[x];
+				}
+				v.edgeTail = run.tail[x];
+				v.degree += run.count[x];
+			}
+		}
+	});
+	std::vector<runT>().swap(runs);
+	edgeCount = (int) numRecords;
+
+	// the hubs get their indexes numbered here and built in parallel
+	if (edgeIndexDegree > 0) {
+		std::vector<vertexRecord*> hubs;
+		for (auto &vtr : verticies) {
+			if (vtr.second.degree >= edgeIndexDegree) {
+				vtr.second.edgeIndex = (uint32_t) edgeIndexes.size();
+				edgeIndexes.push_back(edgeIndexClass());
+				hubs.push_back(&vtr.second);
+			}
+		}
+		pool.parallelFor(hubs.size(), [&](size_t h) {
+			buildEdgeIndex(*hubs[h]);
+		});
+	}
+	if (trackDegrees) {
+		enableDegreeBuckets();
+	}
+}
+
+//
+// Merge si and sj into a super node by
+//   1. deleting all edges linking si and sj in graph
+//   2. merging verticies si and sj into one super node
+//   3. linking in the supernode with the common neighbor links
+//
+graphDatabaseClass::vertexKeyT graphDatabaseClass::mergeVerticies(const vertexKeyT& si, const vertexKeyT& sj) {
+    // the common neighbors in the order of si, with w(si,c) + w(sj,c)
+    std::vector<vertexKeyT> commonNeighbors;
+    std::vector<int> commonWeights;
+    profileCount(counterMerges);
+    profileCount(counterCommonNeighborCalls);
+    profileCount(counterIntersectionWork, (uint64_t) verticies[si].degree * verticies[sj].degree);
+    edgeIndexT sjEdges = verticies[sj].edgeList;
+    for(edgeIndexT esi = verticies[si].edgeList; esi != noEdge; esi = edgePool[esi].next) {
+        for(edgeIndexT esj = sjEdges; esj != noEdge; esj = edgePool[esj].next) {
+            if(edgePool[esi].vertexSlot == edgePool[esj].vertexSlot) {
+                commonNeighbors.push_back(edgeVertex(edgePool[esi]));
+                commonWeights.push_back(edgePool[esi].weight + edgePool[esj].weight);
             }
         }
     }
+    vertexKeyT newVertexKey = si + "," + sj;
+    disconnectVertex(si); eraseVertex(si);
+    disconnectVertex(sj); eraseVertex(sj);
+    insertVertex(newVertexKey);
+    // insert edges to the common neighbers
+    for (size_t c = 0; c < commonNeighbors.size(); ++c) {
+        insertEdge(newVertexKey, commonNeighbors[c], commonWeights[c]);
+    }
+    return newVertexKey;
 }
 
 // for edge x->y, return true if there is a x->y in the graph
 bool graphDatabaseClass::edgeExists(graphDatabaseClass::vertexKeyT x, graphDatabaseClass::vertexKeyT y) {
-    for (auto e = verticies[x].edgeList; e != nullptr; e = e->next) {
-        if (e->vertexID.compare(y) == 0) {
-            return true;
-        }
+    auto ytr = verticies.find(y);
+    if ((ytr == verticies.end()) || (ytr->second.slot == noSlot)) {
+        return false;
     }
-    return false;
+    edgeIndexT before;
+    return findEdge(verticies[x], ytr->second.slot, before) != noEdge;
 }
 // file format
 // 1: numVertices numEedges isDirected
@@ -224,28 +640,45 @@ bool graphDatabaseClass::readGraph(FILE* f) {
     int isDirected=0;
     int lineNum=0;
     int w=0; // weight of edge
+    // the graph is built by buildFromEdges once the file is read
+    std::vector<vertexKeyT> names;
+    std::unordered_map<vertexKeyT, uint32_t> ids;
+    std::vector<edgeT> edges;
+    std::unordered_set<uint64_t> edgesSeen; // both ends, the smaller ID first
+    auto intern = [&](const vertexKeyT& x) -> uint32_t {
+        auto itr = ids.insert(std::make_pair(x, (uint32_t) names.size()));
+        if (itr.second) {
+            names.push_back(x);
+        }
+        return itr.first->second;
+    };
     
-    fscanf(f, "%i %i %i", &numVerticies, &numEdges, &isDirected);
     ++lineNum;
+    if(3!=fscanf(f, "%i %i %i", &numVerticies, &numEdges, &isDirected)) {
+        printf("Error reading graph file on line %i\n", lineNum);
+        initializeGraph(0, false);
+        return false;
+    }
     initializeGraph(numVerticies, (isDirected==1));
     // read in the vertex names
     for(int i=0; i<numVerticies; ++i) {
-        verticiesT::iterator vtr;
         char vertexToInsertCstr[maxVertexNameLength];
         vertexKeyT vertexToInsert;
         fscanf(f, "%s", vertexToInsertCstr);
         ++lineNum;
         vertexToInsert.assign(vertexToInsertCstr);
-        vtr = verticies.find(vertexToInsertCstr);
-        if(vtr != verticies.end()) {
+        if(ids.count(vertexToInsert) != 0) {
             printf("readGraph(): duplicate vertex name %s; not inserted again\n", vertexToInsert.c_str());
             continue;
         }
-        verticies[vertexToInsert]; // inserts vertex
+        intern(vertexToInsert); // inserts vertex
     }
+    edges.reserve(std::max(numEdges, 0));
     
     // Read in the edges.
-    while(!feof(f)) {
+    bool returnVal = true;
+    // blanks at the end of the file, such as its last newline, end the edges
+    while((fscanf(f, " ") == 0) && !feof(f)) {
         char fromVertexNameCstr[maxVertexNameLength];
         char toVertexNameCstr[maxVertexNameLength];
         vertexKeyT fromVertexKey, toVertexKey;
@@ -253,19 +686,30 @@ bool graphDatabaseClass::readGraph(FILE* f) {
             ++lineNum;
             fromVertexKey.assign(fromVertexNameCstr);
             toVertexKey.assign(toVertexNameCstr);
-            if(noisy()) {
-                if(edgeExists(fromVertexKey, toVertexKey)) {
+            edgeT edge;
+            edge.from = intern(fromVertexKey);
+            edge.to = intern(toVertexKey);
+            edge.weight = w;
+            // insertEdge links both ways, so either direction is a duplicate;
+            // the algorithms need each edge once, so this is always checked
+            uint64_t key = ((uint64_t) std::min(edge.from, edge.to) << 32) | std::max(edge.from, edge.to);
+            if(!edgesSeen.insert(key).second) {
+                if(logging(logWarning)) {
                     printf("readGraph(): duplicate edge from %s to %s; not inserted again\n", fromVertexKey.c_str(), toVertexKey.c_str());
-                    continue;
                 }
+                continue;
             }
-            insertEdge(fromVertexKey, toVertexKey , w); // all edges are explicit
+            edges.push_back(edge); // all edges are explicit
         } else {
             printf("Error reading graph file on line %i\n", lineNum);
-            return false;
+            returnVal = false;
+            break;
         }
     }
-    return true;
+    decltype(ids)().swap(ids);
+    decltype(edgesSeen)().swap(edgesSeen);
+    buildFromEdges(names, edges);
+    return returnVal;
 }
 
 bool graphDatabaseClass::writeGraph (FILE* f) {
@@ -279,45 +723,85 @@ bool graphDatabaseClass::writeGraph (FILE* f) {
     };
     
     for(vtr=verticies.begin(); vtr != verticies.end(); ++vtr) {
-        for(edgeRecord* e = vtr->second.edgeList; e != nullptr; e=e->next) {
+        for(edgeIndexT e = vtr->second.edgeList; e != noEdge; e=edgePool[e].next) {
             fprintf(f, "%s ", vtr->first.c_str());
-            fprintf(f, "%s ", e->vertexID.c_str());
-            fprintf(f, "%i\n", e->weight);
+            fprintf(f, "%s ", edgeVertex(edgePool[e]).c_str());
+            fprintf(f, "%i\n", edgePool[e].weight);
         }
     }
     return true;
 }
 
+//
+// checks the tail of the edge list of x and its index, if it has one,
+// against a walk of the list
+//
+void graphDatabaseClass::checkEdgeIndex(const vertexKeyT& x, vertexRecord& v) {
+	std::map<vertexSlotT, edgeIndexClass::entryT> firstEdges;
+	edgeIndexT before = noEdge;
+	for (edgeIndexT e = v.edgeList; e != noEdge; before = e, e = edgePool[e].next) {
+		edgeIndexClass::entryT& first = firstEdges[edgePool[e].vertexSlot];
+		if (first.count++ == 0) {
+			first.before = before;
+		}
+	}
+	if (v.edgeTail != before) {
+		printf("checkGraph(): edge list tail of vertex %s is wrong\n", x.c_str());
+	}
+	if (v.edgeIndex == noIndex) {
+		if ((edgeIndexDegree > 0) && (v.degree >= edgeIndexDegree)) {
+			printf("checkGraph(): vertex %s of degree %i has no edge index\n", x.c_str(), v.degree);
+		}
+		return;
+	}
+	const edgeIndexClass& index = edgeIndexes[v.edgeIndex];
+	if (index.size() != firstEdges.size()) {
+		printf("checkGraph(): edge index of vertex %s has %lu entries for %lu verticies\n", x.c_str(), index.size(), firstEdges.size());
+	}
+	for (const auto &ftr : firstEdges) {
+		const edgeIndexClass::entryT* entry = index.find(ftr.first);
+		if ((entry == nullptr) || (entry->before != ftr.second.before) || (entry->count != ftr.second.count)) {
+			printf("checkGraph(): edge index of vertex %s is wrong for vertex slot %u\n", x.c_str(), ftr.first);
+		}
+	}
+}
+
 //
 // checks everything for consistency
 //
 void graphDatabaseClass::checkGraph() {
 	int checkEdgeCount = 0; // count edges in graph
-	std::vector<vertexKeyT> toVertexID; // remember vertexIDs in edgelist to check for dups
+	std::vector<vertexSlotT> toVertexSlot; // remember vertex slots in edgelist to check for dups
     for (auto vtr = verticies.begin(); vtr != verticies.end(); ++vtr) {
 		int checkDegreeCount = 0; // count degree for this vertex
-		toVertexID.clear();
+		toVertexSlot.clear();
+		if ((vtr->second.slot != noSlot) &&
+			((vtr->second.slot >= vertexSlots.size()) || (vertexSlots[vtr->second.slot] != &*vtr))) {
+			printf("checkGraph(): slot of vertex %s does not point back to it\n", vtr->first.c_str());
+		}
 		// verify the edge list
-		for (auto e = vtr->second.edgeList; e != nullptr; e = e->next) {
+		for (auto e = vtr->second.edgeList; e != noEdge; e = edgePool[e].next) {
 			++checkDegreeCount;
 			++checkEdgeCount;
 			// check one edge
 			// check to see if the other vertex is in the graph
-			if (verticies.count(e->vertexID) == 0) {
-				printf("checkGraph(): edge with vertex %s not in graph\n", e->vertexID.c_str());
+			vertexSlotT slot = edgePool[e].vertexSlot;
+			if ((slot >= vertexSlots.size()) || (vertexSlots[slot] == nullptr)) {
+				printf("checkGraph(): edge from %s to vertex slot %u not in graph\n", vtr->first.c_str(), slot);
 			} else { // vertex is in the graph. 
+				const vertexKeyT& toVertex = vertexSlots[slot]->first;
 				// If undirected graph, give error if no back pointer
-				if((!directed) and (!edgeExists(e->vertexID, vtr->first))) {
-					printf("checkGraph(): undirected graph edge %s to %s does not have back pointer\n", vtr->first.c_str(), e->vertexID.c_str());
+				if((!directed) and (!edgeExists(toVertex, vtr->first))) {
+					printf("checkGraph(): undirected graph edge %s to %s does not have back pointer\n", vtr->first.c_str(), toVertex.c_str());
 				}
-				// check that e.vertexID is not duplicated in this edgelist
-				for (auto dupItr : toVertexID) {
-					if (e->vertexID.compare(dupItr) == 0) {
-						printf("checkGraph(): Duplicate edge %s to %s\n", vtr->first.c_str(), e->vertexID.c_str());
+				// check that the vertex is not duplicated in this edgelist
+				for (auto dupItr : toVertexSlot) {
+					if (slot == dupItr) {
+						printf("checkGraph(): Duplicate edge %s to %s\n", vtr->first.c_str(), toVertex.c_str());
 					}
 				} // end duplicate check
 			} // end check one edge
-			toVertexID.push_back(e->vertexID); // remember we have seen this vertex ID in this edgelist
+			toVertexSlot.push_back(slot); // remember we have seen this vertex in this edgelist
 		} // end of verify edge list
 		// 
 		// now check the vertex degree
@@ -325,8 +809,12 @@ void graphDatabaseClass::checkGraph() {
 		if (checkDegreeCount != vtr->second.degree) {
 			printf("checkGraph(): degree Count on vertex %s is wrong: should be %i but is %i\n", vtr->first.c_str(), checkDegreeCount, vtr->second.degree);
 		}
+		checkEdgeIndex(vtr->first, vtr->second);
 	}
 	if (checkEdgeCount != edgeCount) {
 		printf("checkGraph(): edge count on graph is wrong: should be %i but is %i\n", checkEdgeCount, edgeCount);
 	}
+	if (edgePool.size() != (size_t) checkEdgeCount) {
+		printf("checkGraph(): edge pool holds %lu edges for %i in the edge lists\n", edgePool.size(), checkEdgeCount);
+	}
 }
@@ -13,8 +13,14 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <stdint.h>
+#include "degreebuckets.h"
+#include "recordpool.h"
+#include "edgeindex.h"
+#include "threadpool.h"
+#include "logging.h"
+#include "profile.h"
 
-const bool inline noisy() { return true; };
 
 class graphDatabaseClass {
 public:
@@ -29,31 +35,24 @@ public:
 
     int edgeCount = 0; // number of edges in the graph
     //
+    // Edge records live in edgePool and link to each other by index. The
+    // other end of an edge is held as the slot of that vertex, an index
+    // into vertexSlots, rather than as a copy of its key, so a record has
+    // no storage of its own and the pool copies as one block.
+    //
+    typedef uint32_t edgeIndexT;
+    typedef uint32_t vertexSlotT;
+    static const edgeIndexT noEdge = 0xffffffffu;
+    static const vertexSlotT noSlot = 0xffffffffu;
+    static const uint32_t noIndex = 0xffffffffu;
+    //
     // Adacency list records for edges
     //
 	struct edgeRecord {
-        vertexKeyT vertexID;
-		int weight = 0;
-		unsigned int edgeBits = 0;
-		edgeRecord* next;
-        //
-		// default constructor
-        //
-		edgeRecord() {
-            vertexID.clear();
-			weight = 0;
-			edgeBits = 0;
-			next = nullptr;
-		}
-        //
-		// copy constructor
-        //
-		edgeRecord(edgeRecord &other) {
-			vertexID.assign(other.vertexID);
-			weight = other.weight;
-			edgeBits = other.edgeBits;
-			next = nullptr;
-		}
+        vertexSlotT vertexSlot; // the other vertex, see edgeVertex()
+		int weight;
+		unsigned int edgeBits;
+		edgeIndexT next;
 	};
     //
     // vertecies are string key with vertex information
@@ -62,19 +61,14 @@ public:
         // vertex name is the key
         int degree; // # edges in edgeList, convenience
         unsigned int vertexBits=0;
-        edgeRecord* edgeList;
+        edgeIndexT edgeList;
+        edgeIndexT edgeTail; // last record of edgeList, where edges are appended
+        vertexSlotT slot; // noSlot until an edge points here
+        uint32_t edgeIndex; // in edgeIndexes, noIndex if the vertex has none
         // empty constructor
-        vertexRecord() : degree(0), vertexBits(0), edgeList(nullptr) {
+        vertexRecord() : degree(0), vertexBits(0), edgeList(noEdge), edgeTail(noEdge), slot(noSlot), edgeIndex(noIndex) {
             // empty
         };
-        // duplicate constructor
-        vertexRecord(const vertexRecord &other) :
-	       degree(other.degree),
-	       vertexBits(other.vertexBits),
-	       edgeList(nullptr) 
-		{
-            // empty
-        }
     };
     
     struct vertexKeyCompare {
@@ -90,12 +84,55 @@ public:
     verticiesT verticies;
     
 private:
+    recordPoolClass<edgeRecord> edgePool;
+    // slot -> vertex, nullptr for a free slot
+    std::vector<verticiesT::value_type*> vertexSlots;
+    std::vector<vertexSlotT> freeSlots;
+    vertexSlotT slotOf(verticiesT::iterator vtr);
+    // record of a vertex that exists; unlike verticies[x], safe to call
+    // from several threads at once
+    const vertexRecord& vertexAt(const vertexKeyT& x) const { return verticies.find(x)->second; }
+    void eraseVertex(const vertexKeyT& x);
+    
+    //
+    // verticies by degree, kept up to date once enableDegreeBuckets() is called
+    //
+    bool trackDegrees = false;
+    degreeBucketClass<vertexKeyT> degreeBuckets;
+    void degreeChanged(const vertexKeyT& x, int oldDegree, int newDegree) {
+        if (trackDegrees) {
+            degreeBuckets.update(x, oldDegree, newDegree);
+        }
+    }
     
+    //
+    // Verticies of degree edgeIndexDegree and up have their edge list
+    // indexed by the vertex at the other end, see edgeindex.h, so that
+    // finding and unlinking an edge of a hub does not walk its list. An
+    // index is dropped when the degree falls below half of
+    // edgeIndexDegree, so a vertex near the threshold does not build it
+    // over and over.
+    //
+    int edgeIndexDegree = defaultEdgeIndexDegree;
+    std::vector<edgeIndexClass> edgeIndexes;
+    std::vector<uint32_t> freeEdgeIndexes;
+    void buildEdgeIndex(vertexRecord& v);
+    void dropEdgeIndex(vertexRecord& v);
+    // first edge of v to the vertex in ySlot and the record before it, noEdge if none
+    edgeIndexT findEdge(vertexRecord& v, vertexSlotT ySlot, edgeIndexT& before);
+    void appendEdge(vertexRecord& v, edgeIndexT e);
+    void unlinkEdge(vertexRecord& v, edgeIndexT before, edgeIndexT e);
+    void checkEdgeIndex(const vertexKeyT& x, vertexRecord& v);
+
     void insertEdgeUtility(vertexKeyT x, vertexKeyT y, int w);
     bool deleteEdgeUtility(vertexKeyT x, vertexKeyT y);
     void deepCopy(const graphDatabaseClass& src);
     void clearEdgeLists();
-    bool edgeExists(vertexKeyT x, vertexKeyT y);
+    // threads for bulk work on numRecords edge records, 1 if too few to split
+    unsigned int bulkThreadsFor(size_t numRecords) const;
+    // frees the edge pool, the edge indexes and the degree buckets, and
+    // the verticies too if dropVerticies, side by side on pool
+    void releaseStorage(threadPoolClass& pool, bool dropVerticies);
     
 public:
    
@@ -112,22 +149,93 @@ public:
 	// destructor
     ~graphDatabaseClass();
     
-    int numVerticies();
-    int numEdges() { return edgeCount; }
-    bool directed;
+    int numVerticies() { return (int) verticies.size(); }
+    int numEdges() const { return edgeCount; }
+    bool directed = false;
+
+    //
+    // Deep copy, teardown and buildFromEdges split their work over
+    // bulkThreads threads, 0 for one per core, once the graph has
+    // parallelBulkEdges edge records; below that, starting the threads
+    // costs more than they save. A copy takes bulkThreads from the graph
+    // it copies, so the copies the algorithms make follow the original
+    //
+    unsigned int bulkThreads = 1;
+    static const size_t parallelBulkEdges = 1 << 16;
+
+    static const int defaultEdgeIndexDegree = 64;
+    // verticies of degree minDegree and up get an edge index; 0 for none
+    void setEdgeIndexDegree(int minDegree);
     
     void initializeGraph(int numVerticies, bool isDirected);
     bool readGraph(FILE* ifile);
+    // edge of buildFromEdges, its ends given as indices into the names
+    struct edgeT {
+        uint32_t from;
+        uint32_t to;
+        int weight;
+    };
+    //
+    // replaces the graph by the verticies names, which must be distinct,
+    // and the edges; the same graph as insertVertex of each name and then
+    // insertEdge of each edge in order, built with bulkThreads threads
+    //
+    void buildFromEdges(const std::vector<vertexKeyT>& names, const std::vector<edgeT>& edges);
     bool writeGraph(FILE* ofile);
     
     bool deleteEdge(vertexKeyT x, vertexKeyT y);
     void insertEdge(vertexKeyT x, vertexKeyT y, int w);
+    bool edgeExists(vertexKeyT x, vertexKeyT y);
     
     void insertVertex(vertexKeyT x);
 	void disconnectVertex(vertexKeyT x);
     bool deleteVertex(vertexKeyT x);
     
     void commonNeighbor(vertexKeyT si, vertexKeyT sj, std::vector<vertexKeyT>& returnVal);
+    // number of common neighbors, without building the list
+    int commonNeighborCount(const vertexKeyT& si, const vertexKeyT& sj) const;
+    // replaces sub by the subgraph on members, every edge list in the same order as here
+    void inducedSubgraph(const std::vector<vertexKeyT>& members, graphDatabaseClass& sub) const;
+    
+    // start keeping the verticies in buckets by degree
+    void enableDegreeBuckets();
+    // first vertex in key order of smallest non-zero degree; needs enableDegreeBuckets()
+    bool minDegreeVertex(vertexKeyT& x, int& xDegree) { return degreeBuckets.first(x, xDegree); }
+    
+    //
+    // accessors shared with csrGraphClass so the clique algorithms
+    // can be written once as templates over the graph type
+    //
+    int degree(const vertexKeyT& x) const { return vertexAt(x).degree; }
+    const std::string& vertexName(const vertexKeyT& x) const { return x; }
+    // true if x comes before y in key order
+    bool keyLess(const vertexKeyT& x, const vertexKeyT& y) const { return x < y; }
+    // calls f(key, degree) for each vertex in key order
+    template <typename F> void forEachVertex(F f) const {
+        for (const auto &vtr : verticies) {
+            f(vtr.first, vtr.second.degree);
+        }
+    }
+    // calls f(neighborKey) for each edge of x in edge list order
+    template <typename F> void forEachNeighbor(const vertexKeyT& x, F f) const {
+        for (edgeIndexT e = vertexAt(x).edgeList; e != noEdge; e = edgePool[e].next) {
+            f(edgeVertex(edgePool[e]));
+        }
+    }
+    // calls f(neighborKey, weight) for each edge of x in edge list order
+    template <typename F> void forEachWeightedNeighbor(const vertexKeyT& x, F f) const {
+        for (edgeIndexT e = vertexAt(x).edgeList; e != noEdge; e = edgePool[e].next) {
+            f(edgeVertex(edgePool[e]), edgePool[e].weight);
+        }
+    }
+    // edge records, walked from vertexRecord::edgeList through next
+    const edgeRecord& edge(edgeIndexT e) const { return edgePool[e]; }
+    // key of the vertex at the other end of e
+    const vertexKeyT& edgeVertex(const edgeRecord& e) const { return vertexSlots[e.vertexSlot]->first; }
+    // replaces si and sj by the super node "si,sj" linked to their
+    // common neighbors, each edge weighted w(si,c) + w(sj,c); returns
+    // the key of the super node
+    vertexKeyT mergeVerticies(const vertexKeyT& si, const vertexKeyT& sj);
     
     friend void swap(graphDatabaseClass& first, graphDatabaseClass& second) {
         // enable ADL (not necessary in our case, but good practice)
@@ -135,7 +243,17 @@ public:
         // by swapping the members of two classes,
         // the two classes are effectively swapped
         swap(first.edgeCount, second.edgeCount);
+        swap(first.directed, second.directed);
+        swap(first.bulkThreads, second.bulkThreads);
         swap(first.verticies, second.verticies);
+        swap(first.edgePool, second.edgePool);
+        swap(first.vertexSlots, second.vertexSlots);
+        swap(first.freeSlots, second.freeSlots);
+        swap(first.edgeIndexDegree, second.edgeIndexDegree);
+        swap(first.edgeIndexes, second.edgeIndexes);
+        swap(first.freeEdgeIndexes, second.freeEdgeIndexes);
+        swap(first.trackDegrees, second.trackDegrees);
+        swap(first.degreeBuckets, second.degreeBuckets);
     }
 	// checks the graph database for consistency
 	void checkGraph();
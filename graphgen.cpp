@@ -0,0 +1,368 @@
+//
+//  graphgen.cpp
+//  CliquePartitioning
+//
+
+#include "graphgen.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+
+namespace {
+
+//
+// random numbers made from the raw engine output, so they are the same
+// with every standard library
+//
+class randomSourceT {
+    std::mt19937_64 engine;
+
+public:
+    explicit randomSourceT(uint64_t seed) : engine(seed) {};
+    // uniform in [0,1)
+    double uniform() { return (double) (engine() >> 11) * (1.0 / 9007199254740992.0); }
+    // uniform in 0..n-1; the bias of the modulus is below 2^-32 for any n used here
+    uint64_t below(uint64_t n) { return engine() % n; }
+};
+
+uint64_t maxPairs(uint32_t n) {
+    return (uint64_t) n * (n - (n > 0 ? 1 : 0)) / 2;
+}
+
+void addEdge(std::vector<generatedEdgeT>& edges, uint32_t from, uint32_t to) {
+    generatedEdgeT e;
+    e.from = from;
+    e.to = to;
+    e.weight = 1;
+    edges.push_back(e);
+}
+
+void allPairs(uint32_t n, std::vector<generatedEdgeT>& edges) {
+    for (uint32_t v = 1; v < n; ++v) {
+        for (uint32_t w = 0; w < v; ++w) {
+            addEdge(edges, w, v);
+        }
+    }
+}
+
+//
+// G(n,p) with p chosen to give numEdges on average. Instead of drawing
+// for every pair, the gap to the next edge is drawn from the geometric
+// distribution (Batagelj and Brandes), so the time is in the edges made
+//
+void generateErdosRenyi(const graphSpecT& spec, randomSourceT& rnd, std::vector<generatedEdgeT>& edges) {
+    uint32_t n = spec.numVerticies;
+    uint64_t pairs = maxPairs(n);
+    if (spec.numEdges >= pairs) {
+        allPairs(n, edges);
+        return;
+    }
+    if (spec.numEdges == 0) {
+        return;
+    }
+    double p = (double) spec.numEdges / (double) pairs;
+    double logq = log(1.0 - p);
+    edges.reserve(spec.numEdges + spec.numEdges / 16);
+    int64_t v = 1;
+    int64_t w = -1;
+    while (v < n) {
+        w += 1 + (int64_t) floor(log(1.0 - rnd.uniform()) / logq);
+        while ((w >= v) && (v < n)) {
+            w -= v;
+            ++v;
+        }
+        if (v < n) {
+            addEdge(edges, (uint32_t) w, (uint32_t) v);
+        }
+    }
+}
+
+//
+// Chung-Lu: vertex i has expected degree in proportion to
+// (i+1)^(-1/(exponent-1)), and both ends of each edge are drawn in
+// proportion to the expected degrees. Draws that repeat an edge or make
+// a loop are dropped and made up in further rounds; the hubs saturate,
+// so a few rounds may still leave the graph a little short
+//
+void generatePowerLaw(const graphSpecT& spec, randomSourceT& rnd, std::vector<generatedEdgeT>& edges) {
+    uint32_t n = spec.numVerticies;
+    uint64_t wanted = std::min(spec.numEdges, maxPairs(n));
+    if (wanted == 0) {
+        return;
+    }
+    std::vector<double> cumulative(n);
+    double total = 0.0;
+    double power = -1.0 / (spec.exponent - 1.0);
+    for (uint32_t i = 0; i < n; ++i) {
+        total += pow((double) (i + 1), power);
+        cumulative[i] = total;
+    }
+    auto draw = [&]() -> uint32_t {
+        auto ctr = std::upper_bound(cumulative.begin(), cumulative.end(), rnd.uniform() * total);
+        return (ctr == cumulative.end()) ? n - 1 : (uint32_t) (ctr - cumulative.begin());
+    };
+
+    // edges as from<<32|to with from < to, kept sorted to find repeats
+    std::vector<uint64_t> keys;
+    keys.reserve(wanted + wanted / 8);
+    const int maxRounds = 16;
+    for (int round = 0; (round < maxRounds) && (keys.size() < wanted); ++round) {
+        size_t sorted = keys.size();
+        for (uint64_t k = wanted - keys.size(); k > 0; --k) {
+            uint32_t a = draw();
+            uint32_t b = draw();
+            if (a == b) {
+                continue;
+            }
+            if (a > b) {
+                std::swap(a, b);
+            }
+            keys.push_back(((uint64_t) a << 32) | b);
+        }
+        std::sort(keys.begin() + sorted, keys.end());
+        std::inplace_merge(keys.begin(), keys.begin() + sorted, keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+    edges.reserve(keys.size());
+    for (uint64_t key : keys) {
+        addEdge(edges, (uint32_t) (key >> 32), (uint32_t) key);
+    }
+}
+
+// chance two uniform points in the unit square are closer than r, for r <= 1
+double geometricEdgeChance(double r) {
+    return M_PI * r * r - (8.0 / 3.0) * r * r * r + 0.5 * r * r * r * r;
+}
+
+//
+// random geometric graph. The radius is solved for from numEdges, with
+// the loss at the edges of the square taken into account, and the
+// points are bucketed in a grid of cells no smaller than the radius so
+// only neighboring cells are searched
+//
+void generateGeometric(const graphSpecT& spec, randomSourceT& rnd, std::vector<generatedEdgeT>& edges) {
+    uint32_t n = spec.numVerticies;
+    uint64_t pairs = maxPairs(n);
+    if (spec.numEdges >= pairs) {
+        allPairs(n, edges);
+        return;
+    }
+    if (spec.numEdges == 0) {
+        return;
+    }
+    double p = (double) spec.numEdges / (double) pairs;
+    double lo = 0.0;
+    double hi = 1.0;
+    for (int i = 0; i < 64; ++i) {
+        double mid = 0.5 * (lo + hi);
+        if (geometricEdgeChance(mid) < p) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    double r = hi;
+    double r2 = r * r;
+
+    std::vector<double> px(n);
+    std::vector<double> py(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        px[i] = rnd.uniform();
+        py[i] = rnd.uniform();
+    }
+    // no more cells than about 4 per point
+    uint32_t side = (uint32_t) std::max(1.0, std::min(floor(1.0 / r), 2.0 * sqrt((double) n)));
+    auto cellOf = [&](uint32_t i) -> uint64_t {
+        uint32_t cx = std::min(side - 1, (uint32_t) (px[i] * side));
+        uint32_t cy = std::min(side - 1, (uint32_t) (py[i] * side));
+        return (uint64_t) cy * side + cx;
+    };
+    // counting sort of the points by cell
+    std::vector<uint64_t> cellStart((uint64_t) side * side + 1, 0);
+    for (uint32_t i = 0; i < n; ++i) {
+        ++cellStart[cellOf(i) + 1];
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    std::vector<uint32_t> byCell(n);
+    {
+        std::vector<uint64_t> fill(cellStart.begin(), cellStart.end() - 1);
+        for (uint32_t i = 0; i < n; ++i) {
+            byCell[fill[cellOf(i)]++] = i;
+        }
+    }
+
+    edges.reserve(spec.numEdges + spec.numEdges / 16);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint64_t c = cellOf(i);
+        int64_t cx = (int64_t) (c % side);
+        int64_t cy = (int64_t) (c / side);
+        for (int64_t y = std::max((int64_t) 0, cy - 1); y <= std::min((int64_t) side - 1, cy + 1); ++y) {
+            for (int64_t x = std::max((int64_t) 0, cx - 1); x <= std::min((int64_t) side - 1, cx + 1); ++x) {
+                uint64_t d = (uint64_t) y * side + x;
+                for (uint64_t k = cellStart[d]; k < cellStart[d + 1]; ++k) {
+                    uint32_t j = byCell[k];
+                    double dx = px[i] - px[j];
+                    double dy = py[i] - py[j];
+                    if ((j > i) && (dx * dx + dy * dy < r2)) {
+                        addEdge(edges, i, j);
+                    }
+                }
+            }
+        }
+    }
+}
+
+//
+// lifetimes with uniform starts in [0,1) and lengths scale*u, u uniform
+// in [0,1); two lifetimes are compatible if one ends before the other
+// starts. The scale is solved for by counting the compatible pairs,
+// which is one binary search per lifetime over the sorted starts
+//
+void generateInterval(const graphSpecT& spec, randomSourceT& rnd, std::vector<generatedEdgeT>& edges) {
+    uint32_t n = spec.numVerticies;
+    uint64_t wanted = std::min(spec.numEdges, maxPairs(n));
+    std::vector<double> start(n);
+    std::vector<double> length(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        start[i] = rnd.uniform();
+        length[i] = rnd.uniform();
+    }
+    // the lifetimes in order of start
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return (start[a] < start[b]) || ((start[a] == start[b]) && (a < b));
+    });
+    std::vector<double> sortedStart(n);
+    for (uint32_t k = 0; k < n; ++k) {
+        sortedStart[k] = start[order[k]];
+    }
+    // first lifetime, in order of start, that starts after i ends
+    auto firstAfter = [&](uint32_t i, double scale) -> uint32_t {
+        double end = start[i] + scale * length[i];
+        return (uint32_t) (std::upper_bound(sortedStart.begin(), sortedStart.end(), end) - sortedStart.begin());
+    };
+    auto countPairs = [&](double scale) -> uint64_t {
+        uint64_t count = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            count += n - firstAfter(i, scale);
+        }
+        return count;
+    };
+    double lo = 0.0;
+    double hi = 2.0;
+    for (int i = 0; i < 40; ++i) {
+        double mid = 0.5 * (lo + hi);
+        if (countPairs(mid) > wanted) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    double scale = hi;
+
+    edges.reserve(countPairs(scale));
+    for (uint32_t i = 0; i < n; ++i) {
+        for (uint32_t k = firstAfter(i, scale); k < n; ++k) {
+            addEdge(edges, i, order[k]);
+        }
+    }
+}
+
+} // namespace
+
+const char* graphFamilyName(graphFamilyT family) {
+    switch (family) {
+        case familyErdosRenyi:
+            return "er";
+        case familyPowerLaw:
+            return "powerlaw";
+        case familyGeometric:
+            return "geometric";
+        case familyInterval:
+            return "interval";
+    }
+    return "unknown";
+}
+
+bool parseGraphFamily(const char* name, graphFamilyT& family) {
+    const graphFamilyT families[] = { familyErdosRenyi, familyPowerLaw, familyGeometric, familyInterval };
+    for (graphFamilyT f : families) {
+        if (strcmp(name, graphFamilyName(f)) == 0) {
+            family = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool generateGraph(const graphSpecT& spec, generatedGraphT& graph) {
+    if (spec.numVerticies == 0xffffffffu) {
+        printf("generateGraph(): too many verticies\n");
+        return false;
+    }
+    if (spec.maxWeight < 1) {
+        printf("generateGraph(): maxWeight must be at least 1\n");
+        return false;
+    }
+    if ((spec.family == familyPowerLaw) && !(spec.exponent > 2.0)) {
+        printf("generateGraph(): power law exponent must be greater than 2\n");
+        return false;
+    }
+    randomSourceT rnd(spec.seed);
+    graph.numVerticies = spec.numVerticies;
+    graph.edges.clear();
+    switch (spec.family) {
+        case familyErdosRenyi:
+            generateErdosRenyi(spec, rnd, graph.edges);
+            break;
+        case familyPowerLaw:
+            generatePowerLaw(spec, rnd, graph.edges);
+            break;
+        case familyGeometric:
+            generateGeometric(spec, rnd, graph.edges);
+            break;
+        case familyInterval:
+            generateInterval(spec, rnd, graph.edges);
+            break;
+    }
+
+    // files are not written in any order; shuffle the edges and their
+    // directions so neither store sees a sorted input
+    std::vector<generatedEdgeT>& edges = graph.edges;
+    for (size_t i = edges.size(); i > 1; --i) {
+        std::swap(edges[i - 1], edges[rnd.below(i)]);
+    }
+    for (auto &e : edges) {
+        if (rnd.below(2) != 0) {
+            std::swap(e.from, e.to);
+        }
+        e.weight = 1 + (int) rnd.below((uint64_t) spec.maxWeight);
+    }
+    return true;
+}
+
+void generatedVertexName(uint32_t x, char* name, size_t nameLength) {
+    snprintf(name, nameLength, "v%u", x);
+}
+
+bool writeGeneratedGraph(FILE* f, const generatedGraphT& graph) {
+    char from[16];
+    char to[16];
+    fprintf(f, "%u %llu 0", graph.numVerticies, (unsigned long long) graph.edges.size());
+    for (uint32_t x = 0; x < graph.numVerticies; ++x) {
+        generatedVertexName(x, from, sizeof(from));
+        fprintf(f, "\n%s", from);
+    }
+    for (const auto &e : graph.edges) {
+        generatedVertexName(e.from, from, sizeof(from));
+        generatedVertexName(e.to, to, sizeof(to));
+        fprintf(f, "\n%s %s %i", from, to, e.weight);
+    }
+    return ferror(f) == 0;
+}
@@ -0,0 +1,76 @@
+//
+//  graphgen.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__graphgen__
+#define __CliquePartitioning__graphgen__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+//
+// Synthetic workloads for the benchmark. Each generator makes an
+// undirected graph with no self loops and no duplicate edges, and the
+// same spec always makes the same graph on every platform: the random
+// numbers come straight from std::mt19937_64, whose output the standard
+// fixes, and not from the std distributions, whose output it does not.
+//
+//   familyErdosRenyi   every pair an edge with the same probability
+//   familyPowerLaw     Chung-Lu graph with a power law degree sequence,
+//                      a few hubs and many verticies of low degree
+//   familyGeometric    random points in the unit square, an edge
+//                      between points closer than a radius
+//   familyInterval     random lifetimes, an edge between lifetimes that
+//                      do not overlap, as in the compatibility graphs
+//                      of register and functional unit sharing
+//
+// numEdges is the number wanted; the random families come within a
+// few percent of it, and none makes more than n(n-1)/2.
+//
+enum graphFamilyT {
+    familyErdosRenyi,
+    familyPowerLaw,
+    familyGeometric,
+    familyInterval
+};
+
+struct graphSpecT {
+    graphFamilyT family = familyErdosRenyi;
+    uint32_t numVerticies = 1000;
+    uint64_t numEdges = 5000;
+    double exponent = 2.5;      // familyPowerLaw: degree distribution exponent, > 2
+    int maxWeight = 1;          // weights are uniform in 1..maxWeight
+    uint64_t seed = 1;
+};
+
+struct generatedEdgeT {
+    uint32_t from;
+    uint32_t to;
+    int weight;
+};
+
+struct generatedGraphT {
+    uint32_t numVerticies = 0;
+    std::vector<generatedEdgeT> edges;
+};
+
+// short name for the family, as on the benchmark command line
+const char* graphFamilyName(graphFamilyT family);
+// false if name is not a family
+bool parseGraphFamily(const char* name, graphFamilyT& family);
+
+// prints the reason and returns false if the spec cannot be made
+bool generateGraph(const graphSpecT& spec, generatedGraphT& graph);
+
+// name of vertex x in files written by writeGeneratedGraph
+void generatedVertexName(uint32_t x, char* name, size_t nameLength);
+
+//
+// writes the graph in the text format of readGraph. There is no newline
+// after the last edge, which readGraph would report as a bad line
+//
+bool writeGeneratedGraph(FILE* f, const generatedGraphT& graph);
+
+#endif /* defined(__CliquePartitioning__graphgen__) */
@@ -0,0 +1,46 @@
+//
+//  incremental.cpp
+//  CliquePartitioning
+//
+
+#include "incremental.h"
+#include <string.h>
+
+bool readGraphChanges(FILE* f, std::vector<graphChangeT>& changes) {
+    const int maxVertexNameLength = 256;
+    char line[3 * maxVertexNameLength];
+    int lineNum = 0;
+    changes.clear();
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        ++lineNum;
+        char op[4];
+        char x[maxVertexNameLength];
+        char y[maxVertexNameLength];
+        graphChangeT change;
+        int numFields = sscanf(line, "%3s %255s %255s %i", op, x, y, &change.weight);
+        if (numFields <= 0) {
+            continue; // blank line
+        }
+        bool ok = false;
+        if ((strcmp(op, "+v") == 0) || (strcmp(op, "-v") == 0)) {
+            change.kind = (op[0] == '+') ? changeInsertVertex : changeDeleteVertex;
+            ok = (numFields == 2);
+        } else if (strcmp(op, "+e") == 0) {
+            change.kind = changeInsertEdge;
+            ok = (numFields == 4);
+        } else if (strcmp(op, "-e") == 0) {
+            change.kind = changeDeleteEdge;
+            ok = (numFields == 3);
+        }
+        if (!ok) {
+            printf("Error reading graph changes on line %i\n", lineNum);
+            return false;
+        }
+        change.x = x;
+        if (numFields > 2) {
+            change.y = y;
+        }
+        changes.push_back(change);
+    }
+    return true;
+}
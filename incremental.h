@@ -0,0 +1,474 @@
+//
+//  incremental.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__incremental__
+#define __CliquePartitioning__incremental__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unordered_map>
+#include "graphdb.h"
+#include "csrgraph.h"
+#include "cliquepartition.h"
+#include "partition.h"
+
+//
+// Repairing a partition after the graph changes, instead of running the
+// heuristics again from scratch.
+//
+// The cliques of a partition can be taken as the super nodes of a
+// graph in which two cliques are linked when their union is a clique,
+// with the summed weight of the edges between them. Merging two super
+// nodes there links the result to their common neighbors, the same as
+// mergeVerticies does, so the heuristics can carry on from a partition
+// as well as from single verticies. The partitions they give leave no
+// two cliques that could be merged.
+//
+// After a batch of changes only some cliques are affected:
+//   - a clique that lost an edge between two of its members is no
+//     longer a clique and is broken up into its members
+//   - a clique that gained an edge or lost a member may now merge with
+//     another, and a new vertex, or one deleted and inserted again, is
+//     a clique of its own that may merge
+// The rest could not merge with each other before and still cannot,
+// since no edge between them was added. partitionRepairClass builds the
+// graph of super nodes on the affected cliques and the cliques linked
+// to them, runs the algorithm on it and merges the cliques as it says.
+//
+// It keeps the clique of each vertex, by name, from one batch to the
+// next, so a batch only looks at the cliques its changes name and their
+// neighbors; nothing in repair is linear in the graph. Numbering the
+// verticies in key order and sorting the cliques, as a
+// cliquePartitionClass has them, is left to partition, for when the
+// result is wanted.
+//
+// The repaired partition is the heuristic run from the previous one on
+// the affected part, so it need not be the partition a run from
+// scratch would give. Edge counts decide which cliques are linked, so g
+// must have no duplicate edges, as readGraph and applyGraphChanges make
+// sure.
+//
+
+enum graphChangeKindT {
+    changeInsertVertex,
+    changeDeleteVertex,
+    changeInsertEdge,
+    changeDeleteEdge
+};
+
+// one change to the graph, naming verticies by their names in the input
+struct graphChangeT {
+    graphChangeKindT kind = changeInsertEdge;
+    std::string x;
+    std::string y;      // other end of an edge change
+    int weight = 1;     // of an inserted edge
+};
+
+//
+// reads a list of changes, one to a line:
+//   +v x        insert vertex x
+//   -v x        delete vertex x and its edges
+//   +e x y w    insert the edge x y of weight w
+//   -e x y      delete the edge x y
+// prints the line of the first bad change and returns false
+//
+bool readGraphChanges(FILE* f, std::vector<graphChangeT>& changes);
+
+//
+// the key of the vertex named name, false if there is none, and the
+// key of a new vertex, so applyGraphChanges is written once for both
+// stores
+//
+inline bool findVertexNamed(const graphDatabaseClass& g, const std::string& name, graphDatabaseClass::vertexKeyT& x) {
+    x = name;
+    return g.verticies.find(name) != g.verticies.end();
+}
+inline bool findVertexNamed(const csrGraphClass& g, const std::string& name, csrGraphClass::vertexKeyT& x) {
+    x = g.findVertex(name);
+    return x != csrGraphClass::noVertex;
+}
+inline graphDatabaseClass::vertexKeyT insertVertexNamed(graphDatabaseClass& g, const std::string& name) {
+    g.insertVertex(name);
+    return name;
+}
+inline csrGraphClass::vertexKeyT insertVertexNamed(csrGraphClass& g, const std::string& name) {
+    return g.insertVertex(name);
+}
+
+//
+// makes the changes to g in order. An edge inserted between verticies
+// not in g inserts them too, and one g has already takes the new weight;
+// deleting what is not there does nothing
+//
+template <typename graphT>
+void applyGraphChanges(graphT& g, const std::vector<graphChangeT>& changes) {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    for (const auto &c : changes) {
+        vertexKeyT x = vertexKeyT(), y = vertexKeyT();
+        bool xFound = findVertexNamed(g, c.x, x);
+        bool yFound = false;
+        switch (c.kind) {
+            case changeInsertVertex:
+                if (!xFound) {
+                    insertVertexNamed(g, c.x);
+                }
+                break;
+            case changeDeleteVertex:
+                if (xFound) {
+                    g.disconnectVertex(x);
+                    g.deleteVertex(x);
+                }
+                break;
+            case changeInsertEdge:
+                if (!xFound) {
+                    x = insertVertexNamed(g, c.x);
+                }
+                yFound = findVertexNamed(g, c.y, y);
+                if (!yFound) {
+                    y = insertVertexNamed(g, c.y);
+                }
+                if (xFound && yFound && g.edgeExists(x, y)) {
+                    g.deleteEdge(x, y);
+                }
+                g.insertEdge(x, y, c.weight);
+                break;
+            case changeDeleteEdge:
+                yFound = findVertexNamed(g, c.y, y);
+                if (xFound && yFound) {
+                    g.deleteEdge(x, y);
+                }
+                break;
+        }
+    }
+}
+
+//
+// the clique partition of a graph that changes, see above. g is the
+// graph the changes are made to; it is read, never changed, here
+//
+template <typename graphT>
+class partitionRepairClass {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    static const uint32_t noClique = 0xffffffffu;
+    struct placeT {
+        uint32_t clique;
+        uint32_t position;  // in the members of the clique
+    };
+
+    const graphT& g;
+    cliqueAlgorithmT algorithm;
+    unsigned int numThreads;
+    std::unordered_map<std::string, placeT> placeOf;    // by vertex name
+    std::vector<std::vector<std::string> > members;     // by clique; an empty one is free
+    std::vector<uint32_t> freeCliques;
+    size_t liveCliques = 0;
+    // by clique, for one repair, and reset for only the cliques it set
+    std::vector<char> affected;
+    std::vector<uint32_t> nodeOf;       // super node of the clique
+    std::vector<uint64_t> edgesTo;
+    std::vector<int64_t> weightTo;
+
+    uint32_t newClique() {
+        uint32_t c;
+        if (!freeCliques.empty()) {
+            c = freeCliques.back();
+            freeCliques.pop_back();
+        } else {
+            c = (uint32_t) members.size();
+            members.push_back(std::vector<std::string>());
+            affected.push_back(false);
+            nodeOf.push_back(noClique);
+            edgesTo.push_back(0);
+            weightTo.push_back(0);
+        }
+        ++liveCliques;
+        return c;
+    }
+    void addTo(uint32_t c, const std::string& name) {
+        placeT& place = placeOf[name];
+        place.clique = c;
+        place.position = (uint32_t) members[c].size();
+        members[c].push_back(name);
+    }
+    // takes name out of its clique, leaving the clique to be freed if it empties
+    void remove(const std::string& name) {
+        auto ptr = placeOf.find(name);
+        std::vector<std::string>& from = members[ptr->second.clique];
+        uint32_t position = ptr->second.position;
+        if (position + 1 != from.size()) {
+            placeOf[from.back()].position = position;
+            from[position].swap(from.back());
+        }
+        from.pop_back();
+        if (from.empty()) {
+            --liveCliques;
+        }
+        placeOf.erase(ptr);
+    }
+    uint32_t cliqueNamed(const std::string& name) const {
+        auto ptr = placeOf.find(name);
+        return (ptr == placeOf.end()) ? noClique : ptr->second.clique;
+    }
+
+public:
+    partitionRepairClass(const graphT& graph, cliqueAlgorithmT cliqueAlgorithm, unsigned int threads = 0) :
+        g(graph), algorithm(cliqueAlgorithm), numThreads(threads) {}
+
+    // starts from cliques, a clique partition of g
+    void load(const cliquePartitionClass& cliques);
+    // repairs the partition after changes, which have been made to g
+    void repair(const std::vector<graphChangeT>& changes);
+    size_t numCliques() const { return liveCliques; }
+    // the partition, in the member IDs and order of the algorithms
+    void partition(cliquePartitionClass& cliques) const;
+};
+
+template <typename graphT>
+const uint32_t partitionRepairClass<graphT>::noClique;
+
+template <typename graphT>
+void partitionRepairClass<graphT>::load(const cliquePartitionClass& cliques) {
+    placeOf.clear();
+    members.clear();
+    freeCliques.clear();
+    affected.clear();
+    nodeOf.clear();
+    edgesTo.clear();
+    weightTo.clear();
+    liveCliques = 0;
+    placeOf.reserve(cliques.numMembers());
+    for (size_t c = 0; c < cliques.numCliques(); ++c) {
+        uint32_t clique = newClique();
+        for (auto m = cliques.cliqueBegin(c); m != cliques.cliqueEnd(c); ++m) {
+            addTo(clique, cliques.memberName(*m));
+        }
+    }
+}
+
+template <typename graphT>
+void partitionRepairClass<graphT>::repair(const std::vector<graphChangeT>& changes) {
+    profileTimerClass timer("repairPartition");
+    std::vector<uint32_t> touched;      // the affected cliques, each once
+    std::vector<uint32_t> broken;
+    std::vector<std::string> fresh;     // verticies that may be new
+    auto touch = [&](uint32_t c) {
+        if ((c != noClique) && !affected[c]) {
+            affected[c] = true;
+            touched.push_back(c);
+        }
+    };
+    for (const auto &c : changes) {
+        uint32_t cx = cliqueNamed(c.x);
+        uint32_t cy = ((c.kind == changeInsertEdge) || (c.kind == changeDeleteEdge)) ? cliqueNamed(c.y) : noClique;
+        switch (c.kind) {
+            case changeInsertVertex:
+            case changeInsertEdge:
+                for (const std::string* name : {&c.x, &c.y}) {
+                    uint32_t cn = (name == &c.x) ? cx : cy;
+                    if ((cn == noClique) && !name->empty()) {
+                        fresh.push_back(*name);
+                    }
+                    touch(cn);
+                }
+                break;
+            case changeDeleteEdge:
+                if ((cx == cy) && (cx != noClique)) {
+                    broken.push_back(cx);
+                    touch(cx);
+                }
+                break;
+            case changeDeleteVertex:
+                if (cx != noClique) {
+                    remove(c.x);
+                    touch(cx);
+                }
+                break;
+        }
+    }
+    // broken cliques come apart into their members, and new verticies are cliques of their own
+    for (uint32_t b : broken) {
+        while (members[b].size() > 1) {
+            std::string name = members[b].back();
+            remove(name);
+            uint32_t c = newClique();
+            addTo(c, name);
+            touch(c);
+        }
+    }
+    for (const auto &name : fresh) {
+        vertexKeyT x;
+        if ((cliqueNamed(name) == noClique) && findVertexNamed(g, name, x)) {
+            uint32_t c = newClique();
+            addTo(c, name);
+            touch(c);
+        }
+    }
+    std::sort(touched.begin(), touched.end());
+
+    //
+    // The super nodes are the affected cliques and the cliques linked to
+    // them; a link to the clique b is counted once for each edge, and
+    // there is a link if every member of a has an edge to every member of b
+    //
+    std::vector<uint32_t> nodes;
+    std::vector<graphDatabaseClass::edgeT> superEdges;
+    std::vector<uint32_t> linked;
+    auto superNode = [&](uint32_t a) -> uint32_t {
+        if (nodeOf[a] == noClique) {
+            nodeOf[a] = (uint32_t) nodes.size();
+            nodes.push_back(a);
+        }
+        return nodeOf[a];
+    };
+    for (uint32_t a : touched) {
+        if (members[a].empty()) {
+            continue;
+        }
+        superNode(a);
+        linked.clear();
+        for (const auto &name : members[a]) {
+            vertexKeyT x;
+            findVertexNamed(g, name, x);
+            g.forEachWeightedNeighbor(x, [&](const vertexKeyT& y, int w) {
+                uint32_t b = placeOf.find(g.vertexName(y))->second.clique;
+                if (b == a) {
+                    return;
+                }
+                if (edgesTo[b]++ == 0) {
+                    linked.push_back(b);
+                }
+                weightTo[b] += w;
+            });
+        }
+        for (uint32_t b : linked) {
+            bool clique = (edgesTo[b] == (uint64_t) members[a].size() * members[b].size());
+            if (clique && (!affected[b] || (a < b))) {
+                graphDatabaseClass::edgeT e;
+                e.from = superNode(a);
+                e.to = superNode(b);
+                e.weight = (int) weightTo[b];
+                superEdges.push_back(e);
+            }
+            edgesTo[b] = 0;
+            weightTo[b] = 0;
+        }
+    }
+    if (logging(logDebug)) {
+        printf("repairPartition(): %lu super nodes and %lu links of %lu cliques\n", nodes.size(), superEdges.size(), liveCliques);
+    }
+
+    // super nodes are named by their members, as merges name them
+    graphDatabaseClass superGraph;
+    std::vector<std::string> superNames(nodes.size());
+    std::unordered_map<std::string, uint32_t> nodeNamed;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (const auto &name : members[nodes[i]]) {
+            if (!superNames[i].empty()) {
+                superNames[i] += ",";
+            }
+            superNames[i] += name;
+        }
+        nodeNamed[superNames[i]] = (uint32_t) i;
+    }
+    superGraph.buildFromEdges(superNames, superEdges);
+    cliquePartitionClass superCliques;
+    runCliqueAlgorithm(algorithm, superGraph, superCliques, numThreads);
+
+    // each clique of super nodes becomes the clique of its first one
+    std::vector<uint32_t> merged;
+    for (size_t c = 0; c < superCliques.numCliques(); ++c) {
+        uint32_t into = nodes[nodeNamed[superCliques.memberName(*superCliques.cliqueBegin(c))]];
+        for (auto s = superCliques.cliqueBegin(c) + 1; s != superCliques.cliqueEnd(c); ++s) {
+            uint32_t from = nodes[nodeNamed[superCliques.memberName(*s)]];
+            std::vector<std::string> moving;
+            moving.swap(members[from]);
+            for (const auto &name : moving) {
+                addTo(into, name);
+            }
+            --liveCliques;
+            freeCliques.push_back(from);
+        }
+        merged.push_back(into);
+    }
+
+    if (validating()) {
+        // every member of a merged clique has an edge to each other member of it
+        for (uint32_t c : merged) {
+            for (const auto &name : members[c]) {
+                size_t inClique = 0;
+                vertexKeyT x;
+                findVertexNamed(g, name, x);
+                g.forEachNeighbor(x, [&](const vertexKeyT& y) {
+                    const std::string& other = g.vertexName(y);
+                    if ((other != name) && (cliqueNamed(other) == c)) {
+                        ++inClique;
+                    }
+                });
+                if (inClique != members[c].size() - 1) {
+                    printf("repairPartition(): clique of %s is not a clique of the graph\n", name.c_str());
+                }
+            }
+        }
+    }
+    // the cliques merged away were freed as they emptied; those emptied by deletes are freed here
+    for (uint32_t a : touched) {
+        affected[a] = false;
+        if (members[a].empty() && (nodeOf[a] == noClique)) {
+            freeCliques.push_back(a);
+        }
+    }
+    for (uint32_t a : nodes) {
+        nodeOf[a] = noClique;
+    }
+}
+
+template <typename graphT>
+void partitionRepairClass<graphT>::partition(cliquePartitionClass& cliques) const {
+    typedef cliquePartitionClass::memberT memberT;
+    cliques.clear();
+    std::unordered_map<std::string, memberT> memberNamed;
+    memberNamed.reserve(placeOf.size());
+    g.forEachVertex([&](const vertexKeyT& x, int) {
+        memberNamed[g.vertexName(x)] = cliques.addName(g.vertexName(x));
+    });
+    for (const auto &m : members) {
+        if (m.empty()) {
+            continue;
+        }
+        for (const auto &name : m) {
+            cliques.addMember(memberNamed.find(name)->second);
+        }
+        cliques.endClique();
+    }
+    cliques.sortCliques();
+}
+
+//
+// gives in cliques the partition of g repaired from previous, a
+// partition of g before changes were made to it, by running algorithm
+// on the cliques the changes affect; numThreads as for
+// runCliqueAlgorithm. cliques must not be previous. Loading previous
+// and writing cliques are linear in the graph; to repair batch after
+// batch, keep a partitionRepairClass instead
+//
+template <typename graphT>
+void repairPartition(const graphT& g,
+                     const cliquePartitionClass& previous,
+                     const std::vector<graphChangeT>& changes,
+                     cliqueAlgorithmT algorithm,
+                     cliquePartitionClass& cliques,
+                     unsigned int numThreads = 0
+                     )
+{
+    partitionRepairClass<graphT> repair(g, algorithm, numThreads);
+    repair.load(previous);
+    repair.repair(changes);
+    repair.partition(cliques);
+}
+
+#endif /* defined(__CliquePartitioning__incremental__) */
@@ -0,0 +1,189 @@
+//
+//  intersect.cpp
+//  CliquePartitioning
+//
+
+#include "intersect.h"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+intersectKernelT intersectChooseKernel(size_t na, size_t nb) {
+    size_t small = std::min(na, nb);
+    size_t large = std::max(na, nb);
+    if (large >= intersectGallopRatio * small) {
+        return intersectKernelGalloping;
+    }
+    if (small >= intersectSimdMinLength) {
+        return intersectKernelSimd;
+    }
+    return intersectKernelMerge;
+}
+
+size_t intersectCountMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    size_t i = 0, j = 0, count = 0;
+    while ((i < na) && (j < nb)) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            ++count;
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+size_t intersectMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    size_t i = 0, j = 0, count = 0;
+    while ((i < na) && (j < nb)) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            out[count++] = a[i];
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+//
+// first index k >= lo with b[k] >= x: doubles the step from lo until it
+// passes x, then binary searches the last step
+//
+static size_t gallop(const uint32_t* b, size_t lo, size_t nb, uint32_t x) {
+    size_t step = 1;
+    size_t hi = lo;
+    while ((hi < nb) && (b[hi] < x)) {
+        lo = hi + 1;
+        hi += step;
+        step <<= 1;
+    }
+    if (hi > nb) {
+        hi = nb;
+    }
+    return std::lower_bound(b + lo, b + hi, x) - b;
+}
+
+size_t intersectCountGalloping(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    size_t j = 0, count = 0;
+    for (size_t i = 0; (i < na) && (j < nb); ++i) {
+        j = gallop(b, j, nb, a[i]);
+        if ((j < nb) && (b[j] == a[i])) {
+            ++count;
+            ++j;
+        }
+    }
+    return count;
+}
+
+size_t intersectGalloping(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out) {
+    if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+    }
+    size_t j = 0, count = 0;
+    for (size_t i = 0; (i < na) && (j < nb); ++i) {
+        j = gallop(b, j, nb, a[i]);
+        if ((j < nb) && (b[j] == a[i])) {
+            out[count++] = a[i];
+            ++j;
+        }
+    }
+    return count;
+}
+
+//
+// Block intersection: compare a block of a against every rotation of a
+// block of b, count the matches, then advance whichever block ends
+// lower. Lists are sets, so each element matches at most once.
+//
+size_t intersectCountSimd(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    size_t i = 0, j = 0, count = 0;
+#if defined(__AVX2__)
+    const __m256i rotate = _mm256_set_epi32(0, 7, 6, 5, 4, 3, 2, 1);
+    while ((i + 8 <= na) && (j + 8 <= nb)) {
+        __m256i va = _mm256_loadu_si256((const __m256i*) (a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*) (b + j));
+        __m256i match = _mm256_cmpeq_epi32(va, vb);
+        for (int r = 1; r < 8; ++r) {
+            vb = _mm256_permutevar8x32_epi32(vb, rotate);
+            match = _mm256_or_si256(match, _mm256_cmpeq_epi32(va, vb));
+        }
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(match)));
+        uint32_t amax = a[i + 7];
+        uint32_t bmax = b[j + 7];
+        if (amax <= bmax) {
+            i += 8;
+        }
+        if (bmax <= amax) {
+            j += 8;
+        }
+    }
+#elif defined(__SSE2__)
+    while ((i + 4 <= na) && (j + 4 <= nb)) {
+        __m128i va = _mm_loadu_si128((const __m128i*) (a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*) (b + j));
+        __m128i match = _mm_cmpeq_epi32(va, vb);
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+        match = _mm_or_si128(match, _mm_cmpeq_epi32(va, vb));
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(match)));
+        uint32_t amax = a[i + 3];
+        uint32_t bmax = b[j + 3];
+        if (amax <= bmax) {
+            i += 4;
+        }
+        if (bmax <= amax) {
+            j += 4;
+        }
+    }
+#endif
+    // the tails, or everything without vector support
+    return count + intersectCountMerge(a + i, na - i, b + j, nb - j);
+}
+
+size_t intersectCountBitset(const uint32_t* a, size_t na, const uint64_t* bits, size_t nbits) {
+    size_t count = 0;
+    for (size_t i = 0; i < na; ++i) {
+        count += bitsetTest(bits, nbits, a[i]) ? 1 : 0;
+    }
+    return count;
+}
+
+size_t intersectBitset(const uint32_t* a, size_t na, const uint64_t* bits, size_t nbits, uint32_t* out) {
+    size_t count = 0;
+    for (size_t i = 0; i < na; ++i) {
+        if (bitsetTest(bits, nbits, a[i])) {
+            out[count++] = a[i];
+        }
+    }
+    return count;
+}
+
+size_t intersectCount(const uint32_t* a, size_t na, const uint32_t* b, size_t nb) {
+    switch (intersectChooseKernel(na, nb)) {
+        case intersectKernelGalloping:
+            return intersectCountGalloping(a, na, b, nb);
+        case intersectKernelSimd:
+            return intersectCountSimd(a, na, b, nb);
+        default:
+            return intersectCountMerge(a, na, b, nb);
+    }
+}
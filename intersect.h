@@ -0,0 +1,62 @@
+//
+//  intersect.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__intersect__
+#define __CliquePartitioning__intersect__
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Intersection kernels for sorted lists of vertex IDs, used by
+// csrGraphClass to count and list common neighbors.
+//
+//   merge      both lists walked in step; best when the lengths are close
+//   galloping  each element of the short list is searched for in the long
+//              one with exponential then binary search; best when one list
+//              is much longer than the other
+//   simd       merge done a block at a time with vector compares (SSE2 or
+//              AVX2 when the compiler targets them, otherwise merge)
+//   bitset     the long list is a bitset over vertex IDs and each element of
+//              the short list is a bit test; for high degree hubs
+//
+// The count variants do no allocation.
+//
+enum intersectKernelT {
+    intersectKernelAuto,      // choose by list lengths, see intersectChooseKernel
+    intersectKernelMerge,
+    intersectKernelGalloping,
+    intersectKernelSimd,
+    intersectKernelBitset
+};
+
+// lists shorter than this are merged, longer ones use the SIMD kernel
+const size_t intersectSimdMinLength = 16;
+// galloping pays when the long list is this many times the short one
+const size_t intersectGallopRatio = 32;
+
+// picks merge, galloping or simd for lists of lengths na and nb
+intersectKernelT intersectChooseKernel(size_t na, size_t nb);
+
+size_t intersectCountMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+size_t intersectCountGalloping(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+size_t intersectCountSimd(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+// counts the elements of a whose bit is set in bits, a bitset of nbits bits
+size_t intersectCountBitset(const uint32_t* a, size_t na, const uint64_t* bits, size_t nbits);
+
+// intersection written to out, which must have room for min(na, nb) IDs;
+// returns the number written
+size_t intersectMerge(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out);
+size_t intersectGalloping(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* out);
+size_t intersectBitset(const uint32_t* a, size_t na, const uint64_t* bits, size_t nbits, uint32_t* out);
+
+// count with the kernel chosen by intersectChooseKernel
+size_t intersectCount(const uint32_t* a, size_t na, const uint32_t* b, size_t nb);
+
+inline bool bitsetTest(const uint64_t* bits, size_t nbits, uint32_t x) {
+    return (x < nbits) && ((bits[x >> 6] >> (x & 63)) & 1);
+}
+
+#endif /* defined(__CliquePartitioning__intersect__) */
@@ -0,0 +1,79 @@
+//
+//  logging.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__logging__
+#define __CliquePartitioning__logging__
+
+//
+// Diagnostics. Messages are guarded by logging(level):
+//
+//   if (logging(logTrace)) {
+//       printf("adding vertex %s\n", x.c_str());
+//   }
+//
+// maxLogLevel is fixed when compiling, and logging() is false for any
+// level above it without looking at anything else, so the guarded code
+// is dropped from the build. Debug builds (DEBUG defined, as in the
+// Xcode Debug configuration) keep every level; other builds keep
+// warnings and errors. Define CLIQUE_MAX_LOG_LEVEL to choose otherwise.
+// Below maxLogLevel the level is set at run time with setLogLevel().
+//
+// Consistency checks, such as checkGraph() in the algorithm loops and
+// the cross checks of the incremental scores, are not logging: they run
+// only in validation mode, which is off unless setValidation(true) is
+// called, and is compiled out unless CLIQUE_VALIDATION is non-zero
+// (the default in debug builds).
+//
+enum logLevelT {
+    logSilent = 0,
+    logError,       // the run cannot go on as asked
+    logWarning,     // something was skipped or looks wrong
+    logInfo,        // progress, once per phase
+    logDebug,       // once per algorithm step
+    logTrace        // once per vertex or edge
+};
+
+#ifndef CLIQUE_MAX_LOG_LEVEL
+#ifdef DEBUG
+#define CLIQUE_MAX_LOG_LEVEL logTrace
+#else
+#define CLIQUE_MAX_LOG_LEVEL logWarning
+#endif
+#endif
+
+#ifndef CLIQUE_VALIDATION
+#ifdef DEBUG
+#define CLIQUE_VALIDATION 1
+#else
+#define CLIQUE_VALIDATION 0
+#endif
+#endif
+
+const logLevelT maxLogLevel = CLIQUE_MAX_LOG_LEVEL;
+
+// the run time settings, one copy for the program
+inline logLevelT& runtimeLogLevel() {
+    static logLevelT level = logWarning;
+    return level;
+}
+inline bool& runtimeValidation() {
+    static bool validation = false;
+    return validation;
+}
+
+inline void setLogLevel(logLevelT level) { runtimeLogLevel() = level; }
+inline void setValidation(bool validation) { runtimeValidation() = validation; }
+
+// true if messages of level are to be printed
+inline bool logging(logLevelT level) {
+    return (level <= maxLogLevel) && (level <= runtimeLogLevel());
+}
+
+// true if consistency checks are to be run
+inline bool validating() {
+    return (CLIQUE_VALIDATION != 0) && runtimeValidation();
+}
+
+#endif /* defined(__CliquePartitioning__logging__) */
@@ -0,0 +1,190 @@
+//
+//  lowerbound.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__lowerbound__
+#define __CliquePartitioning__lowerbound__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <unordered_map>
+#include "threadpool.h"
+#include "profile.h"
+
+//
+// Lower bound on the number of cliques in any clique partition of a
+// graph. No two verticies of an independent set can share a clique, so
+// the size of any independent set is a bound; the best bound of this
+// kind is the largest, the independence number. An independent set of
+// the graph is a clique of its complement, so this is the bound a
+// colouring of the complement starts from, found without making the
+// complement, which is dense when the graph is sparse.
+//
+// Each trial grows an independent set greedily: it takes a vertex of
+// least degree among those left, removes it and its neighbors, and
+// repeats. Trial 0 breaks ties by key order; the others shuffle the
+// verticies first with a seed of their own. The trials run on a thread
+// pool and the largest set wins, so the bound depends on the number of
+// trials but not on the number of threads.
+//
+// When the cliques of an algorithm are as few as the bound they are as
+// few as there can be, and running another algorithm to look for fewer
+// is wasted. Every cliqueAlgorithmT gives a clique partition, weighted
+// or not, so the bound holds for all of them.
+//
+
+const unsigned int cliqueBoundTrials = 8;
+
+//
+// the verticies of g numbered 0..n-1 in key order and their neighbors,
+// those of vertex v being adjacency[start[v] .. start[v+1]) in order.
+// Each edge is listed at both ends, once, whether g has it at one end
+// or both, once or more; self loops are left out
+//
+struct boundGraphT {
+    std::vector<size_t> start;
+    std::vector<uint32_t> adjacency;
+
+    uint32_t numVerticies() const { return (uint32_t) (start.size() - 1); }
+    uint32_t degree(uint32_t v) const { return (uint32_t) (start[v + 1] - start[v]); }
+};
+
+template <typename graphT>
+void boundGraph(const graphT& g, boundGraphT& b) {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    std::vector<vertexKeyT> keys;
+    std::unordered_map<vertexKeyT, uint32_t> position;
+    g.forEachVertex([&](const vertexKeyT& x, int) {
+        position[x] = (uint32_t) keys.size();
+        keys.push_back(x);
+    });
+    const uint32_t n = (uint32_t) keys.size();
+    std::vector<std::pair<uint32_t, uint32_t> > edges;
+    for (uint32_t v = 0; v < n; ++v) {
+        g.forEachNeighbor(keys[v], [&](const vertexKeyT& y) {
+            uint32_t u = position.find(y)->second;
+            if (u != v) {
+                edges.push_back(std::make_pair(v, u));
+                edges.push_back(std::make_pair(u, v));
+            }
+        });
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    b.start.assign(n + 1, 0);
+    b.adjacency.resize(edges.size());
+    for (size_t i = 0; i < edges.size(); ++i) {
+        ++b.start[edges[i].first + 1];
+        b.adjacency[i] = edges[i].second;
+    }
+    for (uint32_t v = 0; v < n; ++v) {
+        b.start[v + 1] += b.start[v];
+    }
+}
+
+//
+// one greedy trial on b, the verticies considered in order, which sets
+// the tie breaks. Returns the independent set in independent
+//
+inline void greedyIndependentSet(const boundGraphT& b, const std::vector<uint32_t>& order,
+                                 std::vector<uint32_t>& independent) {
+    const uint32_t n = b.numVerticies();
+    std::vector<uint32_t> degree(n);
+    std::vector<bool> removed(n, false);
+    // buckets by degree left; an entry is stale once its vertex is
+    // removed or its degree drops, and is skipped when it comes up
+    std::vector<std::vector<uint32_t> > buckets;
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        uint32_t v = *it;
+        degree[v] = b.degree(v);
+        if (degree[v] >= buckets.size()) {
+            buckets.resize(degree[v] + 1);
+        }
+        buckets[degree[v]].push_back(v);
+    }
+    independent.clear();
+    size_t least = 0;
+    while (least < buckets.size()) {
+        if (buckets[least].empty()) {
+            ++least;
+            continue;
+        }
+        uint32_t v = buckets[least].back();
+        buckets[least].pop_back();
+        if (removed[v] || (degree[v] != least)) {
+            continue;
+        }
+        independent.push_back(v);
+        removed[v] = true;
+        for (size_t i = b.start[v]; i < b.start[v + 1]; ++i) {
+            uint32_t u = b.adjacency[i];
+            if (removed[u]) {
+                continue;
+            }
+            removed[u] = true;
+            for (size_t j = b.start[u]; j < b.start[u + 1]; ++j) {
+                uint32_t w = b.adjacency[j];
+                if (!removed[w]) {
+                    buckets[--degree[w]].push_back(w);
+                    least = std::min(least, (size_t) degree[w]);
+                }
+            }
+        }
+    }
+}
+
+//
+// a lower bound on the cliques of any clique partition of g, from
+// numTrials greedy independent sets run on numThreads threads, 0 for
+// one per core. The names of the verticies of the largest set go to
+// witness, if given
+//
+template <typename graphT>
+size_t cliqueCoverLowerBound(const graphT& g, unsigned int numThreads = 0,
+                             unsigned int numTrials = cliqueBoundTrials,
+                             std::vector<std::string>* witness = nullptr) {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    profileTimerClass timer("cliqueCoverLowerBound");
+    boundGraphT b;
+    boundGraph(g, b);
+    numTrials = std::max(numTrials, 1u);
+    std::vector<std::vector<uint32_t> > sets(numTrials);
+    threadPoolClass pool(numThreads);
+    pool.parallelFor(numTrials, [&](size_t t) {
+        std::vector<uint32_t> order(b.numVerticies());
+        for (uint32_t v = 0; v < order.size(); ++v) {
+            order[v] = v;
+        }
+        if (t > 0) {
+            std::mt19937_64 rng(t);
+            std::shuffle(order.begin(), order.end(), rng);
+        }
+        greedyIndependentSet(b, order, sets[t]);
+    });
+    size_t best = 0;
+    for (size_t t = 1; t < numTrials; ++t) {
+        if (sets[t].size() > sets[best].size()) {
+            best = t;
+        }
+    }
+    if (witness != nullptr) {
+        std::vector<bool> chosen(b.numVerticies(), false);
+        for (auto v : sets[best]) {
+            chosen[v] = true;
+        }
+        witness->clear();
+        uint32_t v = 0;
+        g.forEachVertex([&](const vertexKeyT& x, int) {
+            if (chosen[v++]) {
+                witness->push_back(g.vertexName(x));
+            }
+        });
+    }
+    return sets[best].size();
+}
+
+#endif /* defined(__CliquePartitioning__lowerbound__) */
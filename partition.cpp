@@ -0,0 +1,87 @@
+//
+//  partition.cpp
+//  CliquePartitioning
+//
+
+#include "partition.h"
+#include <algorithm>
+
+const cliquePartitionClass::memberT cliquePartitionClass::noMember;
+
+namespace {
+
+// the member names of one clique, for joinedNameLess
+struct cliqueNameListT {
+    const cliquePartitionClass* partition;
+    const cliquePartitionClass::memberT* m;
+    const cliquePartitionClass::memberT* end;
+    const std::string* next() {
+        return (m == end) ? nullptr : &partition->memberName(*m++);
+    }
+};
+
+} // namespace
+
+void cliquePartitionClass::clear() {
+    names.clear();
+    members.clear();
+    cliqueStart.assign(1, 0);
+}
+
+std::string cliquePartitionClass::cliqueName(size_t c) const {
+    std::string name;
+    for (const memberT* m = cliqueBegin(c); m != cliqueEnd(c); ++m) {
+        if (m != cliqueBegin(c)) {
+            name += ",";
+        }
+        name += names[*m];
+    }
+    return name;
+}
+
+void cliquePartitionClass::cliqueNames(std::vector<std::string>& cliques) const {
+    cliques.clear();
+    cliques.reserve(numCliques());
+    for (size_t c = 0; c < numCliques(); ++c) {
+        cliques.push_back(cliqueName(c));
+    }
+}
+
+bool cliquePartitionClass::writeCliques(FILE* f) const {
+    for (size_t c = 0; c < numCliques(); ++c) {
+        fprintf(f, "  %i. ", (int) c + 1);
+        for (const memberT* m = cliqueBegin(c); m != cliqueEnd(c); ++m) {
+            if (m != cliqueBegin(c)) {
+                fputc(',', f);
+            }
+            fputs(names[*m].c_str(), f);
+        }
+        fputc('\n', f);
+    }
+    return ferror(f) == 0;
+}
+
+bool cliquePartitionClass::cliqueLess(size_t a, size_t b) const {
+    return joinedNameLess(cliqueNameListT{this, cliqueBegin(a), cliqueEnd(a)},
+                          cliqueNameListT{this, cliqueBegin(b), cliqueEnd(b)});
+}
+
+void cliquePartitionClass::sortCliques() {
+    std::vector<size_t> order(numCliques());
+    for (size_t c = 0; c < order.size(); ++c) {
+        order[c] = c;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return cliqueLess(a, b);
+    });
+    std::vector<memberT> sortedMembers;
+    std::vector<size_t> sortedStart(1, 0);
+    sortedMembers.reserve(members.size());
+    sortedStart.reserve(cliqueStart.size());
+    for (size_t c : order) {
+        sortedMembers.insert(sortedMembers.end(), cliqueBegin(c), cliqueEnd(c));
+        sortedStart.push_back(sortedMembers.size());
+    }
+    members.swap(sortedMembers);
+    cliqueStart.swap(sortedStart);
+}
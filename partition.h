@@ -0,0 +1,162 @@
+//
+//  partition.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__partition__
+#define __CliquePartitioning__partition__
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+//
+// Result of a clique partitioning. The verticies of the input graph
+// are numbered 0..n-1 in key order, and each clique is a span of these
+// member IDs, in the order the verticies were merged into it. The
+// cliques are in the order the algorithms list them, which is key
+// order of their super nodes.
+//
+// The name of a super node is the names of its members joined with
+// commas. Names are only made when asked for, by cliqueName and
+// cliqueNames; cliqueLess compares two cliques as their names would
+// compare, without making them.
+//
+class cliquePartitionClass {
+public:
+    typedef uint32_t memberT;
+    static const memberT noMember = 0xffffffffu;
+
+private:
+    std::vector<std::string> names;   // of the input verticies, by member ID
+    std::vector<memberT> members;     // the cliques, one after the other
+    std::vector<size_t> cliqueStart;  // clique c is members[cliqueStart[c] .. cliqueStart[c+1])
+
+public:
+    cliquePartitionClass() : cliqueStart(1, 0) {};
+
+    void clear();
+    // gives the next input vertex its member ID
+    memberT addName(const std::string& name) {
+        names.push_back(name);
+        return (memberT) (names.size() - 1);
+    }
+    // adds m to the clique being built; endClique closes it
+    void addMember(memberT m) { members.push_back(m); }
+    void endClique() { cliqueStart.push_back(members.size()); }
+    // puts the cliques in key order
+    void sortCliques();
+
+    size_t numMembers() const { return names.size(); }
+    size_t numCliques() const { return cliqueStart.size() - 1; }
+    const memberT* cliqueBegin(size_t c) const { return members.data() + cliqueStart[c]; }
+    const memberT* cliqueEnd(size_t c) const { return members.data() + cliqueStart[c + 1]; }
+    size_t cliqueSize(size_t c) const { return cliqueStart[c + 1] - cliqueStart[c]; }
+    const std::string& memberName(memberT m) const { return names[m]; }
+
+    // names of the members of clique c joined with commas
+    std::string cliqueName(size_t c) const;
+    // the name of every clique, in order
+    void cliqueNames(std::vector<std::string>& cliques) const;
+    // prints the cliques one to a line, numbered from 1, without making their names
+    bool writeCliques(FILE* f) const;
+    // true if clique a comes before clique b in key order
+    bool cliqueLess(size_t a, size_t b) const;
+};
+
+//
+// Walks the string a list of names would make joined with commas, one
+// character at a time, without making it. nameListT::next() gives the
+// next name, or nullptr after the last one
+//
+template <typename nameListT>
+class joinedNameCursorClass {
+    nameListT names;
+    const std::string* name;
+    size_t i = 0;
+
+public:
+    explicit joinedNameCursorClass(const nameListT& nameList) : names(nameList), name(names.next()) {};
+    // next character as an unsigned char, the way std::string compares, or -1 at the end
+    int get() {
+        if (name == nullptr) {
+            return -1;
+        }
+        if (i < name->size()) {
+            return (unsigned char) (*name)[i++];
+        }
+        name = names.next();
+        i = 0;
+        return (name == nullptr) ? -1 : ',';
+    }
+};
+
+// true if the joined names of a come before those of b, as std::string compares
+template <typename nameListAT, typename nameListBT>
+bool joinedNameLess(const nameListAT& a, const nameListBT& b) {
+    joinedNameCursorClass<nameListAT> ca(a);
+    joinedNameCursorClass<nameListBT> cb(b);
+    while (true) {
+        int x = ca.get();
+        int y = cb.get();
+        if (x != y) {
+            return x < y;
+        }
+        if (x < 0) {
+            return false;
+        }
+    }
+}
+
+//
+// The cliques of one run as they form. Each vertex of the working
+// graph keeps the list of input verticies merged into it, linked by
+// member ID through next, so a merge joins two lists in O(1) whatever
+// their length
+//
+template <typename graphT>
+class cliqueMembersClass {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    typedef cliquePartitionClass::memberT memberT;
+    struct memberListT {
+        memberT first;
+        memberT last;
+    };
+    std::unordered_map<vertexKeyT, memberListT> lists;
+    std::vector<memberT> next;
+
+public:
+    // numbers the verticies of g and gives their names to partition, which is cleared
+    cliqueMembersClass(const graphT& g, cliquePartitionClass& partition) {
+        partition.clear();
+        g.forEachVertex([&](const vertexKeyT& x, int) {
+            memberT m = partition.addName(g.vertexName(x));
+            lists[x] = memberListT{m, m};
+        });
+        next.assign(partition.numMembers(), cliquePartitionClass::noMember);
+    }
+    // si and sj were merged into n
+    void merge(const vertexKeyT& si, const vertexKeyT& sj, const vertexKeyT& n) {
+        auto itr = lists.find(si);
+        auto jtr = lists.find(sj);
+        memberListT joined = {itr->second.first, jtr->second.last};
+        next[itr->second.last] = jtr->second.first;
+        lists.erase(itr);
+        lists.erase(jtr);
+        lists[n] = joined;
+    }
+    // adds a clique to partition for each vertex of gPrime, in key order
+    void finish(const graphT& gPrime, cliquePartitionClass& partition) const {
+        gPrime.forEachVertex([&](const vertexKeyT& x, int) {
+            for (memberT m = lists.find(x)->second.first; m != cliquePartitionClass::noMember; m = next[m]) {
+                partition.addMember(m);
+            }
+            partition.endClique();
+        });
+    }
+};
+
+#endif /* defined(__CliquePartitioning__partition__) */
@@ -0,0 +1,284 @@
+//
+//  partitioncache.cpp
+//  CliquePartitioning
+//
+
+#include "partitioncache.h"
+#include <stdio.h>
+#include <errno.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <algorithm>
+#include "logging.h"
+
+const uint64_t partitionCacheClass::defaultMaxBytes;
+
+namespace {
+
+const char entrySuffix[] = ".clq";
+
+// the hash of an entry's sizes and members, as written
+void payloadHash(const std::vector<uint32_t>& sizes, const std::vector<uint32_t>& members, uint64_t hash[2]) {
+    contentHashClass h;
+    h.add(sizes.data(), sizes.size() * sizeof(uint32_t));
+    h.add(members.data(), members.size() * sizeof(uint32_t));
+    h.result(hash);
+}
+
+bool isEntryName(const char* name) {
+    size_t n = strlen(name);
+    size_t suffix = sizeof(entrySuffix) - 1;
+    return (name[0] != '.') && (n > suffix) && (strcmp(name + n - suffix, entrySuffix) == 0);
+}
+
+} // namespace
+
+bool partitionCacheClass::open(const char* cacheDirectory, uint64_t cacheBytes) {
+    directory.clear();
+    if ((mkdir(cacheDirectory, 0777) != 0) && (errno != EEXIST)) {
+        printf("partitionCacheClass: unable to make directory %s\n", cacheDirectory);
+        return false;
+    }
+    struct stat st;
+    if ((stat(cacheDirectory, &st) != 0) || !S_ISDIR(st.st_mode)) {
+        printf("partitionCacheClass: %s is not a directory\n", cacheDirectory);
+        return false;
+    }
+    DIR* dir = opendir(cacheDirectory);
+    if (dir == nullptr) {
+        printf("partitionCacheClass: unable to read directory %s\n", cacheDirectory);
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    directory = cacheDirectory;
+    maxBytes = cacheBytes;
+    index.clear();
+    leastRecent.clear();
+    totalBytes = 0;
+
+    // the entries there already, modified longest ago first, by name when
+    // the times tie so every process puts them in the same order
+    struct foundT {
+        std::string name;
+        time_t modified;
+        uint64_t bytes;
+    };
+    std::vector<foundT> found;
+    for (struct dirent* e = readdir(dir); e != nullptr; e = readdir(dir)) {
+        if (!isEntryName(e->d_name)) {
+            continue;
+        }
+        foundT entry;
+        entry.name = directory + "/" + e->d_name;
+        if ((stat(entry.name.c_str(), &st) != 0) || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        entry.modified = st.st_mtime;
+        entry.bytes = (uint64_t) st.st_size;
+        found.push_back(entry);
+    }
+    closedir(dir);
+    std::sort(found.begin(), found.end(), [](const foundT& a, const foundT& b) {
+        return (a.modified != b.modified) ? (a.modified < b.modified) : (a.name < b.name);
+    });
+    for (const auto &entry : found) {
+        used(entry.name, entry.bytes);
+    }
+    evict();
+    return true;
+}
+
+void partitionCacheClass::used(const std::string& name, uint64_t bytes) {
+    auto ptr = index.find(name);
+    if (ptr == index.end()) {
+        leastRecent.push_back(name);
+        indexEntryT entry;
+        entry.bytes = bytes;
+        entry.used = std::prev(leastRecent.end());
+        index.insert(std::make_pair(name, entry));
+        totalBytes += bytes;
+        return;
+    }
+    totalBytes += bytes - ptr->second.bytes;
+    ptr->second.bytes = bytes;
+    leastRecent.splice(leastRecent.end(), leastRecent, ptr->second.used);
+}
+
+void partitionCacheClass::discard(const keyT& key, const char* problem) {
+    std::string name = entryName(key);
+    if (logging(logWarning)) {
+        printf("partitionCacheClass: deleting %s, %s\n", name.c_str(), problem);
+    }
+    unlink(name.c_str());
+    std::lock_guard<std::mutex> guard(lock);
+    auto ptr = index.find(name);
+    if (ptr != index.end()) {
+        totalBytes -= ptr->second.bytes;
+        leastRecent.erase(ptr->second.used);
+        index.erase(ptr);
+    }
+}
+
+std::string partitionCacheClass::entryName(const keyT& key) const {
+    char name[64];
+    snprintf(name, sizeof(name), "/%016llx%016llx-%d%s", (unsigned long long) key.graphHash[0],
+             (unsigned long long) key.graphHash[1], (int) key.algorithm, entrySuffix);
+    return directory + name;
+}
+
+bool partitionCacheClass::loadEntry(const keyT& key, cliquePartitionClass& cliques) {
+    std::string name = entryName(key);
+    FILE* f = fopen(name.c_str(), "rb");
+    if (f == nullptr) {
+        return false;
+    }
+    profileTimerClass timer("partitionCache load");
+    partitionCacheHeader header;
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> members;
+    const char* problem = nullptr;
+    if (fread(&header, sizeof(header), 1, f) != 1) {
+        problem = "short header";
+    } else if ((memcmp(header.magic, partitionCacheMagic, sizeof(header.magic)) != 0) ||
+               (header.version != partitionCacheVersion) ||
+               (header.byteOrder != partitionCacheByteOrder)) {
+        problem = "not an entry this program can read";
+    } else if ((header.graphHash[0] != key.graphHash[0]) || (header.graphHash[1] != key.graphHash[1]) ||
+               (header.algorithm != (uint32_t) key.algorithm)) {
+        problem = "the key does not match";
+    } else if ((header.numMembers != cliques.numMembers()) || (header.numCliques > header.numMembers)) {
+        problem = "the size does not match the graph";
+    } else {
+        sizes.resize((size_t) header.numCliques);
+        members.resize((size_t) header.numMembers);
+        char extra;
+        if ((fread(sizes.data(), sizeof(uint32_t), sizes.size(), f) != sizes.size()) ||
+            (fread(members.data(), sizeof(uint32_t), members.size(), f) != members.size()) ||
+            (fread(&extra, 1, 1, f) != 0)) {
+            problem = "the file is the wrong size";
+        }
+    }
+    fclose(f);
+    if (problem == nullptr) {
+        uint64_t hash[2];
+        payloadHash(sizes, members, hash);
+        if ((hash[0] != header.payloadHash[0]) || (hash[1] != header.payloadHash[1])) {
+            problem = "the cliques do not match their hash";
+        }
+    }
+    if (problem == nullptr) {
+        // every member in exactly one clique, and no clique empty
+        std::vector<bool> seen(members.size(), false);
+        uint64_t total = 0;
+        for (auto size : sizes) {
+            total += size;
+            if (size == 0) {
+                problem = "an empty clique";
+            }
+        }
+        if (total != members.size()) {
+            problem = "the clique sizes do not add up";
+        }
+        for (auto m : members) {
+            if ((m >= members.size()) || seen[m]) {
+                problem = "the cliques are not a partition";
+                break;
+            }
+            seen[m] = true;
+        }
+    }
+    if (problem != nullptr) {
+        discard(key, problem);
+        return false;
+    }
+
+    size_t next = 0;
+    for (auto size : sizes) {
+        for (uint32_t i = 0; i < size; ++i) {
+            cliques.addMember(members[next++]);
+        }
+        cliques.endClique();
+    }
+    // most recently used, here and for the next process to open the directory
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        used(name, sizeof(header) + (sizes.size() + members.size()) * sizeof(uint32_t));
+    }
+    utimes(name.c_str(), nullptr);
+    return true;
+}
+
+bool partitionCacheClass::store(const keyT& key, const cliquePartitionClass& cliques) {
+    if (!isOpen()) {
+        return false;
+    }
+    profileTimerClass timer("partitionCache store");
+    partitionCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, partitionCacheMagic, sizeof(header.magic));
+    header.version = partitionCacheVersion;
+    header.byteOrder = partitionCacheByteOrder;
+    header.algorithm = (uint32_t) key.algorithm;
+    header.graphHash[0] = key.graphHash[0];
+    header.graphHash[1] = key.graphHash[1];
+    header.numMembers = cliques.numMembers();
+    header.numCliques = cliques.numCliques();
+    std::vector<uint32_t> sizes;
+    std::vector<uint32_t> members;
+    sizes.reserve(cliques.numCliques());
+    members.reserve(cliques.numMembers());
+    for (size_t c = 0; c < cliques.numCliques(); ++c) {
+        sizes.push_back((uint32_t) cliques.cliqueSize(c));
+        members.insert(members.end(), cliques.cliqueBegin(c), cliques.cliqueEnd(c));
+    }
+    payloadHash(sizes, members, header.payloadHash);
+
+    // written beside the entry and renamed into place, so a reader never
+    // sees half of one
+    std::string pattern = directory + "/.partition-XXXXXX";
+    std::vector<char> tempName(pattern.begin(), pattern.end());
+    tempName.push_back('\0');
+    int fd = mkstemp(tempName.data());
+    if (fd < 0) {
+        printf("partitionCacheClass: unable to make a file in %s\n", directory.c_str());
+        return false;
+    }
+    fchmod(fd, 0644);    // mkstemp makes it 0600; others sharing the directory read it
+    FILE* f = fdopen(fd, "wb");
+    bool ok = (f != nullptr) &&
+              (fwrite(&header, sizeof(header), 1, f) == 1) &&
+              (fwrite(sizes.data(), sizeof(uint32_t), sizes.size(), f) == sizes.size()) &&
+              (fwrite(members.data(), sizeof(uint32_t), members.size(), f) == members.size());
+    if (f != nullptr) {
+        ok = (fclose(f) == 0) && ok;
+    } else {
+        close(fd);
+    }
+    std::string name = entryName(key);
+    ok = ok && (rename(tempName.data(), name.c_str()) == 0);
+    if (!ok) {
+        printf("partitionCacheClass: unable to write %s\n", name.c_str());
+        unlink(tempName.data());
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    used(name, sizeof(header) + (sizes.size() + members.size()) * sizeof(uint32_t));
+    evict();
+    return true;
+}
+
+void partitionCacheClass::evict() {
+    while ((totalBytes > maxBytes) && !leastRecent.empty()) {
+        const std::string& name = leastRecent.front();
+        // another process may have deleted it first, which frees the space all the same
+        if (unlink(name.c_str()) == 0) {
+            profileCount(counterCacheEvictions);
+        }
+        auto ptr = index.find(name);
+        totalBytes -= ptr->second.bytes;
+        index.erase(ptr);
+        leastRecent.pop_front();
+    }
+}
@@ -0,0 +1,258 @@
+//
+//  partitioncache.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__partitioncache__
+#define __CliquePartitioning__partitioncache__
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include "cliquepartition.h"
+#include "partition.h"
+#include "profile.h"
+
+//
+// Streaming 128 bit hash, two lanes of 64 bit words each mixed with
+// the finalizer of MurmurHash3. Fast rather than cryptographic: it
+// tells graphs apart, it does not stand up to someone making
+// collisions on purpose.
+//
+class contentHashClass {
+    uint64_t lane[2] = { 0x243f6a8885a308d3ull, 0x13198a2e03707344ull };
+    uint64_t count = 0;
+    static uint64_t mix(uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+        return x;
+    }
+public:
+    void add(uint64_t word) {
+        ++count;
+        lane[0] = mix(lane[0] ^ word) + count;
+        lane[1] = mix(lane[1] + word * 0x9e3779b97f4a7c15ull) ^ lane[0];
+    }
+    void add(const std::string& s) {
+        add((uint64_t) s.size());
+        for (size_t i = 0; i < s.size(); i += 8) {
+            uint64_t word = 0;
+            memcpy(&word, s.data() + i, std::min((size_t) 8, s.size() - i));
+            add(word);
+        }
+    }
+    void add(const void* bytes, size_t n) {
+        const uint8_t* p = (const uint8_t*) bytes;
+        add((uint64_t) n);
+        for (size_t i = 0; i < n; i += 8) {
+            uint64_t word = 0;
+            memcpy(&word, p + i, std::min((size_t) 8, n - i));
+            add(word);
+        }
+    }
+    // the hash of what was added, in two words
+    void result(uint64_t hash[2]) const {
+        hash[0] = mix(lane[0] ^ count);
+        hash[1] = mix(lane[1] ^ hash[0]);
+    }
+};
+
+//
+// A cache entry is this header, then uint32_t cliqueSizes[numCliques]
+// and uint32_t members[numMembers], each clique's members in order.
+// Members are numbered 0..numMembers-1 in key order, like
+// cliquePartitionClass. Numbers are in the byte order of the machine
+// that wrote the entry; an entry from another is a miss.
+//
+struct partitionCacheHeader {
+    char magic[8];              // "CLQCACHE"
+    uint32_t version;           // partitionCacheVersion
+    uint32_t byteOrder;         // partitionCacheByteOrder as written
+    uint32_t algorithm;         // cliqueAlgorithmT
+    uint32_t reserved;
+    uint64_t graphHash[2];
+    uint64_t numMembers;
+    uint64_t numCliques;
+    uint64_t payloadHash[2];    // contentHashClass of the sizes then the members
+};
+
+const char partitionCacheMagic[8] = { 'C', 'L', 'Q', 'C', 'A', 'C', 'H', 'E' };
+const uint32_t partitionCacheVersion = 1;
+const uint32_t partitionCacheByteOrder = 0x01020304;
+
+//
+// Cache of clique partitions on disk, keyed by the content of the graph
+// and the algorithm, so a graph partitioned before is not partitioned
+// again. A graph is hashed as the algorithms see it: the verticies in
+// key order with their names, and the edges of each in edge list order
+// with their weights, the other end by its place in key order. Those
+// are all the cliques depend on, so two graphs with the same hash get
+// the same cliques whichever store they are in and however they were
+// read. partitionByComponents gives the same cliques as the algorithm
+// run whole, and shares its entries.
+//
+// Each entry is a file of its own in the cache directory, named by the
+// key, laid out as partitionCacheHeader describes. The names come from
+// the graph, not the file. Loading checks the header against the key
+// and the graph, the size of the file, the hash, that the cliques are a
+// partition of the members, and that each is a clique of the graph; an
+// entry that fails is deleted and counted as a miss.
+//
+// The size of each entry and the order they were last used in are kept
+// in memory, read from the directory once by open, with the entries
+// modified longest ago first. A hit or a store makes an entry the most
+// recently used, and when a store takes the total over maxBytes the
+// least recently used entries are deleted, with no look at the
+// directory. A hit also sets the modified time of the entry, so the next
+// process to open the directory starts from the same order.
+//
+// Entries are written to a temporary file and renamed into place, so
+// threads and processes can share a directory; what they race on is
+// only which copy of an entry wins, and the copies are the same. Each
+// process counts the entries it found at open and those it has stored
+// or loaded since, so with several writing at once the directory can
+// run over maxBytes by what the others added until they evict.
+//
+class partitionCacheClass {
+public:
+    struct keyT {
+        uint64_t graphHash[2];
+        cliqueAlgorithmT algorithm;
+    };
+
+private:
+    struct indexEntryT {
+        uint64_t bytes;
+        std::list<std::string>::iterator used;  // place in leastRecent
+    };
+    std::string directory;
+    uint64_t maxBytes = 0;
+    std::mutex lock;    // over the index, which the threads of a batch share
+    // the entries by file name, and the names least recently used first
+    std::unordered_map<std::string, indexEntryT> index;
+    std::list<std::string> leastRecent;
+    uint64_t totalBytes = 0;
+
+    std::string entryName(const keyT& key) const;
+    // adds the cliques of the entry to cliques, which holds the names
+    bool loadEntry(const keyT& key, cliquePartitionClass& cliques);
+    // makes the entry the most recently used, adding it if it is new; call with lock held
+    void used(const std::string& name, uint64_t bytes);
+    // deletes the entry and drops it from the index, saying why
+    void discard(const keyT& key, const char* problem);
+    // deletes the least recently used entries until they total maxBytes or less; call with lock held
+    void evict();
+
+public:
+    static const uint64_t defaultMaxBytes = (uint64_t) 1 << 30;
+
+    // creates directory if need be; false if it cannot be used
+    bool open(const char* cacheDirectory, uint64_t cacheBytes = defaultMaxBytes);
+    bool isOpen() const { return !directory.empty(); }
+
+    template <typename graphT>
+    static keyT graphKey(const graphT& g, cliqueAlgorithmT algorithm);
+    // true if the partition of g for key was in the cache, in cliques
+    template <typename graphT>
+    bool load(const keyT& key, const graphT& g, cliquePartitionClass& cliques);
+    // writes the entry for key; false if it could not
+    bool store(const keyT& key, const cliquePartitionClass& cliques);
+};
+
+template <typename graphT>
+partitionCacheClass::keyT partitionCacheClass::graphKey(const graphT& g, cliqueAlgorithmT algorithm) {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    profileTimerClass timer("partitionCache hash");
+    std::vector<vertexKeyT> keys;
+    std::unordered_map<vertexKeyT, uint32_t> position;
+    contentHashClass hash;
+    g.forEachVertex([&](const vertexKeyT& x, int degree) {
+        position[x] = (uint32_t) keys.size();
+        keys.push_back(x);
+        hash.add(g.vertexName(x));
+        hash.add((uint64_t) degree);
+    });
+    for (const auto &x : keys) {
+        g.forEachWeightedNeighbor(x, [&](const vertexKeyT& y, int w) {
+            hash.add(((uint64_t) position.find(y)->second << 32) | (uint32_t) w);
+        });
+    }
+    keyT key;
+    hash.result(key.graphHash);
+    key.algorithm = algorithm;
+    return key;
+}
+
+template <typename graphT>
+bool partitionCacheClass::load(const keyT& key, const graphT& g, cliquePartitionClass& cliques) {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    cliques.clear();
+    std::vector<vertexKeyT> keys;
+    std::unordered_map<vertexKeyT, uint32_t> position;
+    g.forEachVertex([&](const vertexKeyT& x, int) {
+        position[x] = (uint32_t) keys.size();
+        keys.push_back(x);
+        cliques.addName(g.vertexName(x));
+    });
+    bool hit = loadEntry(key, cliques);
+    if (hit) {
+        // each member has an edge to every other member of its clique
+        std::vector<size_t> cliqueOf(keys.size(), 0);
+        for (size_t c = 0; c < cliques.numCliques(); ++c) {
+            for (auto m = cliques.cliqueBegin(c); m != cliques.cliqueEnd(c); ++m) {
+                cliqueOf[*m] = c;
+            }
+        }
+        for (uint32_t m = 0; hit && (m < keys.size()); ++m) {
+            size_t inClique = 0;
+            g.forEachNeighbor(keys[m], [&](const vertexKeyT& y) {
+                uint32_t n = position.find(y)->second;
+                if ((n != m) && (cliqueOf[n] == cliqueOf[m])) {
+                    ++inClique;
+                }
+            });
+            hit = (inClique + 1 >= cliques.cliqueSize(cliqueOf[m]));
+        }
+        if (!hit) {
+            discard(key, "a clique is not a clique of the graph");
+        }
+    }
+    if (!hit) {
+        cliques.clear();
+        profileCount(counterCacheMisses);
+        return false;
+    }
+    profileCount(counterCacheHits);
+    return true;
+}
+
+//
+// cliques of g by algorithm, from cache if it has them; otherwise
+// run(cliques) makes them and they are stored. cache may be nullptr.
+// Returns true on a hit
+//
+template <typename graphT, typename runT>
+bool cachedPartition(partitionCacheClass* cache, cliqueAlgorithmT algorithm, const graphT& g,
+                     cliquePartitionClass& cliques, runT run) {
+    if ((cache == nullptr) || !cache->isOpen()) {
+        run(cliques);
+        return false;
+    }
+    partitionCacheClass::keyT key = partitionCacheClass::graphKey(g, algorithm);
+    if (cache->load(key, g, cliques)) {
+        return true;
+    }
+    run(cliques);
+    cache->store(key, cliques);
+    return false;
+}
+
+#endif /* defined(__CliquePartitioning__partitioncache__) */
@@ -0,0 +1,154 @@
+//
+//  portfolio.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__portfolio__
+#define __CliquePartitioning__portfolio__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "cliquepartition.h"
+#include "threadpool.h"
+#include "partition.h"
+#include "logging.h"
+#include "profile.h"
+
+//
+// Clique partitioning by a portfolio of runs raced on one graph: Tseng,
+// Bhasker and seeded variants of them, see cliqueRunControlT. The runs
+// go on a thread pool, each on one thread with its own copy of the
+// graph, which they all only read. The partition with the fewest
+// cliques wins, ties going to the run listed first.
+//
+// Runs are cancelled cooperatively: each polls its control before every
+// merge. A run that finishes with as few cliques as lowerBound, see
+// lowerbound.h, cancels the others, since none can do better. Once
+// budgetSeconds have passed and a run has finished, the runs still
+// going are cancelled and the best finished one wins, so the wait is
+// about the budget or the first run to finish after it, not the sum of
+// the runs. Until a run finishes, none is cancelled by the budget, so
+// there is always a partition to give.
+//
+// With no budget and no bound every run finishes and the winner is the
+// same for any number of threads. With them, which runs finish depends
+// on timing, and so may the winner, though never one with more cliques
+// than a run that was given the time to finish.
+//
+
+struct portfolioEntryT {
+    cliqueAlgorithmT algorithm;
+    uint64_t tieSeed;           // 0 for the algorithm as it is
+};
+
+struct portfolioOptionsT {
+    unsigned int numThreads = 0; // runs at once, 0 for one per core
+    double budgetSeconds = 0;    // 0 for no budget
+    size_t lowerBound = 0;       // a run this good ends the race; 0 for none
+};
+
+struct portfolioResultT {
+    portfolioEntryT entry;
+    bool finished = false;       // false if cancelled
+    size_t numCliques = 0;
+    double seconds = 0;
+};
+
+//
+// Tseng and Bhasker, weighted or not, then numVariants seeded variants
+// of each, a Bhasker one ahead of each Tseng one since it is cheaper
+//
+inline void portfolioEntries(bool weighted, unsigned int numVariants, std::vector<portfolioEntryT>& entries) {
+    cliqueAlgorithmT tseng = weighted ? cliqueAlgorithmWeightedTseng : cliqueAlgorithmTseng;
+    cliqueAlgorithmT bhasker = weighted ? cliqueAlgorithmWeightedBhasker : cliqueAlgorithmBhasker;
+    entries.clear();
+    entries.push_back(portfolioEntryT{ tseng, 0 });
+    entries.push_back(portfolioEntryT{ bhasker, 0 });
+    for (uint64_t seed = 1; seed <= numVariants; ++seed) {
+        entries.push_back(portfolioEntryT{ bhasker, seed });
+        entries.push_back(portfolioEntryT{ tseng, seed });
+    }
+}
+
+//
+// races entries on g and puts the best partition in cliques. Returns the
+// index of the winning entry, or -1 if there were none. How each run
+// did goes to results, if given, in the order of entries
+//
+template <typename graphT>
+int portfolioPartition(const graphT& g,
+                       const std::vector<portfolioEntryT>& entries,
+                       const portfolioOptionsT& options,
+                       cliquePartitionClass& cliques,
+                       std::vector<portfolioResultT>* results = nullptr
+                       )
+{
+    typedef std::chrono::steady_clock clockT;
+    profileTimerClass timer("portfolioPartition");
+    const clockT::time_point start = clockT::now();
+    const clockT::time_point deadline = start +
+        std::chrono::duration_cast<clockT::duration>(std::chrono::duration<double>(options.budgetSeconds));
+    std::atomic<bool> stop(false);
+    std::atomic<bool> anyFinished(false);
+    std::vector<cliquePartitionClass> partitions(entries.size());
+    std::vector<portfolioResultT> runs(entries.size());
+
+    threadPoolClass pool(options.numThreads);
+    pool.parallelFor(entries.size(), [&](size_t i) {
+        cliqueRunControlT control;
+        control.tieSeed = entries[i].tieSeed;
+        control.cancelled = [&]() {
+            return stop.load(std::memory_order_relaxed) ||
+                   ((options.budgetSeconds > 0) && anyFinished.load(std::memory_order_relaxed) &&
+                    (clockT::now() >= deadline));
+        };
+        portfolioResultT& run = runs[i];
+        run.entry = entries[i];
+        clockT::time_point runStart = clockT::now();
+        // a run not started before the race ends is not started at all
+        run.finished = !control.cancelled() &&
+                       runCliqueAlgorithm(entries[i].algorithm, g, partitions[i], 1, &control);
+        run.seconds = std::chrono::duration<double>(clockT::now() - runStart).count();
+        if (!run.finished) {
+            profileCount(counterRunsCancelled);
+            return;
+        }
+        run.numCliques = partitions[i].numCliques();
+        anyFinished = true;
+        if ((options.lowerBound > 0) && (run.numCliques <= options.lowerBound)) {
+            stop = true;
+        }
+    });
+
+    int best = -1;
+    for (size_t i = 0; i < runs.size(); ++i) {
+        if (runs[i].finished && ((best < 0) || (runs[i].numCliques < runs[best].numCliques))) {
+            best = (int) i;
+        }
+    }
+    if (logging(logInfo)) {
+        for (size_t i = 0; i < runs.size(); ++i) {
+            printf("portfolioPartition(): %s seed %llu %s in %.4fs", cliqueAlgorithmName(runs[i].entry.algorithm),
+                   (unsigned long long) runs[i].entry.tieSeed, runs[i].finished ? "finished" : "cancelled",
+                   runs[i].seconds);
+            if (runs[i].finished) {
+                printf(" with %zu cliques%s", runs[i].numCliques, ((int) i == best) ? ", the best" : "");
+            }
+            printf("\n");
+        }
+    }
+    if (best >= 0) {
+        cliques = std::move(partitions[best]);
+    } else {
+        cliques.clear();
+    }
+    if (results != nullptr) {
+        results->swap(runs);
+    }
+    return best;
+}
+
+#endif /* defined(__CliquePartitioning__portfolio__) */
@@ -0,0 +1,213 @@
+//
+//  profile.cpp
+//  CliquePartitioning
+//
+
+#include "profile.h"
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* const counterNames[numProfileCounters] = {
+    "commonNeighborCalls",
+    "intersectionWork",
+    "edgesScanned",
+    "merges",
+    "edgeInserts",
+    "edgeDeletes",
+    "edgeAllocations",
+    "pageReads",
+    "cacheHits",
+    "cacheMisses",
+    "cacheEvictions",
+    "runsCancelled",
+    "refineMoves"
+};
+
+struct profileEventT {
+    const char* name;
+    int loop;
+    int thread;
+    double startMicros;
+    double durationMicros;
+    uint64_t counts[numProfileCounters];
+};
+
+struct profileTotalT {
+    uint64_t count = 0;
+    double seconds = 0;
+};
+
+//
+// the profile of the program. Counters are added to from any thread
+// without a lock; events come at most once a loop, and take lock
+//
+struct profileT {
+    std::atomic<uint64_t> counters[numProfileCounters];
+    std::mutex lock;
+    bool clockStarted = false;
+    std::chrono::steady_clock::time_point epoch;
+    std::vector<profileEventT> events;
+    std::map<std::string, profileTotalT> totals;
+    std::atomic<int> nextThread;
+
+    profileT() : nextThread(0) {
+        for (auto &c : counters) {
+            c.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+profileT& theProfile() {
+    static profileT profile;
+    return profile;
+}
+
+// small numbers for the threads, in the order they first end an event
+int threadNumber() {
+    static thread_local int number = -1;
+    if (number < 0) {
+        number = theProfile().nextThread.fetch_add(1, std::memory_order_relaxed);
+    }
+    return number;
+}
+
+double microsSince(std::chrono::steady_clock::time_point epoch, std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double, std::micro>(t - epoch).count();
+}
+
+// names are string literals from the code, but are escaped anyway
+void writeJsonString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s != '\0'; ++s) {
+        if ((*s == '"') || (*s == '\\')) {
+            fputc('\\', f);
+        }
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+} // namespace
+
+void setProfiling(bool profiling) {
+    profileT& p = theProfile();
+    {
+        std::lock_guard<std::mutex> guard(p.lock);
+        if (profiling && !p.clockStarted) {
+            p.epoch = std::chrono::steady_clock::now();
+            p.clockStarted = true;
+        }
+    }
+    runtimeProfiling() = profiling;
+}
+
+void profileAdd(profileCounterT counter, uint64_t n) {
+    theProfile().counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+uint64_t profileCounter(profileCounterT counter) {
+    return theProfile().counters[counter].load(std::memory_order_relaxed);
+}
+
+profileTimerClass::profileTimerClass(const char* timerName, int loopNumber) :
+    name(timerName), loop(loopNumber), active(profiling()) {
+    if (active) {
+        for (int c = 0; c < numProfileCounters; ++c) {
+            startCounts[c] = profileCounter((profileCounterT) c);
+        }
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+profileTimerClass::~profileTimerClass() {
+    if (!active) {
+        return;
+    }
+    auto end = std::chrono::steady_clock::now();
+    profileEventT e;
+    e.name = name;
+    e.loop = loop;
+    e.thread = threadNumber();
+    for (int c = 0; c < numProfileCounters; ++c) {
+        e.counts[c] = profileCounter((profileCounterT) c) - startCounts[c];
+    }
+    profileT& p = theProfile();
+    std::lock_guard<std::mutex> guard(p.lock);
+    e.startMicros = microsSince(p.epoch, start);
+    e.durationMicros = microsSince(start, end);
+    p.events.push_back(e);
+    profileTotalT& total = p.totals[name];
+    ++total.count;
+    total.seconds += e.durationMicros / 1e6;
+}
+
+void profileReset() {
+    profileT& p = theProfile();
+    std::lock_guard<std::mutex> guard(p.lock);
+    for (auto &c : p.counters) {
+        c.store(0, std::memory_order_relaxed);
+    }
+    p.events.clear();
+    p.totals.clear();
+}
+
+bool profileWriteCounters(FILE* f) {
+    fputc('{', f);
+    for (int c = 0; c < numProfileCounters; ++c) {
+        fprintf(f, "%s\"%s\":%llu", (c == 0) ? "" : ",", counterNames[c],
+                (unsigned long long) profileCounter((profileCounterT) c));
+    }
+    fputc('}', f);
+    return ferror(f) == 0;
+}
+
+bool profileWriteJson(FILE* f) {
+    profileT& p = theProfile();
+    std::lock_guard<std::mutex> guard(p.lock);
+    fprintf(f, "{\"counters\":");
+    profileWriteCounters(f);
+    fprintf(f, ",\"timers\":{");
+    bool first = true;
+    for (const auto &t : p.totals) {
+        fprintf(f, first ? "\n  " : ",\n  ");
+        writeJsonString(f, t.first.c_str());
+        fprintf(f, ":{\"count\":%llu,\"seconds\":%.6f}", (unsigned long long) t.second.count, t.second.seconds);
+        first = false;
+    }
+    fprintf(f, "}}\n");
+    return ferror(f) == 0;
+}
+
+bool profileWriteChromeTrace(FILE* f) {
+    profileT& p = theProfile();
+    std::lock_guard<std::mutex> guard(p.lock);
+    fprintf(f, "{\"traceEvents\":[");
+    bool first = true;
+    for (const auto &e : p.events) {
+        fprintf(f, first ? "\n" : ",\n");
+        fprintf(f, "{\"name\":");
+        writeJsonString(f, e.name);
+        fprintf(f, ",\"cat\":\"clique\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%i,\"args\":{",
+                e.startMicros, e.durationMicros, e.thread);
+        const char* separator = "";
+        if (e.loop >= 0) {
+            fprintf(f, "\"loop\":%i", e.loop);
+            separator = ",";
+        }
+        for (int c = 0; c < numProfileCounters; ++c) {
+            if (e.counts[c] != 0) {
+                fprintf(f, "%s\"%s\":%llu", separator, counterNames[c], (unsigned long long) e.counts[c]);
+                separator = ",";
+            }
+        }
+        fprintf(f, "}}");
+        first = false;
+    }
+    fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    return ferror(f) == 0;
+}
@@ -0,0 +1,108 @@
+//
+//  profile.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__profile__
+#define __CliquePartitioning__profile__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <chrono>
+
+//
+// Counters and timers for finding where a run spends its time. Like
+// logging.h, profiling is compiled in unless CLIQUE_PROFILING is 0, and
+// is off until setProfiling(true) is called. While it is off a counter
+// costs a test of one flag and a timer a test and nothing else.
+//
+// Counters are kept for the whole program, by every thread:
+//
+//   profileCount(counterMerges);
+//
+// A profileTimerClass times its scope. Each becomes an event of the
+// trace, with the counts made while it ran, and adds to the totals of
+// its name. The algorithms time the copy they work on, its teardown,
+// and each loop:
+//
+//   profileTimerClass timer("TsengAlgorithm loop", loops);
+//
+// When algorithms run on several threads at once, as in
+// partitionByComponents, the counts of an event include the work of
+// the other threads over the same time.
+//
+// profileWriteJson gives the counters and the timer totals,
+// profileWriteChromeTrace every event in the Trace Event Format read by
+// chrome://tracing and Perfetto.
+//
+
+#ifndef CLIQUE_PROFILING
+#define CLIQUE_PROFILING 1
+#endif
+
+enum profileCounterT {
+    counterCommonNeighborCalls,     // commonNeighbor, commonNeighborCount and weighted counts
+    counterIntersectionWork,        // edge list entries read by them
+    counterEdgesScanned,            // edges looked at choosing the pairs to merge
+    counterMerges,                  // mergeVerticies
+    counterEdgeInserts,             // insertEdgeUtility
+    counterEdgeDeletes,             // deleteEdgeUtility
+    counterEdgeAllocations,         // edge storage grown or moved by them
+    counterPageReads,               // pages of edge lists read from disk by diskGraphClass
+    counterCacheHits,               // partitions loaded from partitionCacheClass
+    counterCacheMisses,             // partitions it did not have
+    counterCacheEvictions,          // entries it deleted to stay under its size
+    counterRunsCancelled,           // portfolioPartition runs cancelled before they finished
+    counterRefineMoves,             // verticies moved between cliques by refinePartition
+    numProfileCounters
+};
+
+inline bool& runtimeProfiling() {
+    static bool profiling = false;
+    return profiling;
+}
+
+// also starts the clock of the trace the first time profiling is turned on
+void setProfiling(bool profiling);
+
+// true if counts and times are being taken
+inline bool profiling() {
+    return (CLIQUE_PROFILING != 0) && runtimeProfiling();
+}
+
+void profileAdd(profileCounterT counter, uint64_t n);
+
+inline void profileCount(profileCounterT counter, uint64_t n = 1) {
+    if (profiling()) {
+        profileAdd(counter, n);
+    }
+}
+
+class profileTimerClass {
+    const char* name;
+    int loop;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+    uint64_t startCounts[numProfileCounters];
+
+public:
+    // name must outlive the program's profile, as a string literal does;
+    // loop is given as an argument of the event unless negative
+    explicit profileTimerClass(const char* timerName, int loopNumber = -1);
+    ~profileTimerClass();
+    profileTimerClass(const profileTimerClass&) = delete;
+    profileTimerClass& operator=(const profileTimerClass&) = delete;
+};
+
+// the counters and the events so far
+uint64_t profileCounter(profileCounterT counter);
+// drops the counts and the events, keeping the clock of the trace
+void profileReset();
+// {"counterName":n,...}
+bool profileWriteCounters(FILE* f);
+// {"counters":{...},"timers":{"name":{"count":n,"seconds":s},...}}
+bool profileWriteJson(FILE* f);
+// {"traceEvents":[{"name":...,"ph":"X","ts":...,"dur":...,"args":{...}},...]}
+bool profileWriteChromeTrace(FILE* f);
+
+#endif /* defined(__CliquePartitioning__profile__) */
@@ -0,0 +1,119 @@
+//
+//  recordpool.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__recordpool__
+#define __CliquePartitioning__recordpool__
+
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+//
+// allocator that leaves records default initialized, so sizing a block
+// that is about to be written over does not zero it first
+//
+template <typename T>
+struct uninitializedAllocator : std::allocator<T> {
+    template <typename U> struct rebind { typedef uninitializedAllocator<U> other; };
+    uninitializedAllocator() {}
+    template <typename U> uninitializedAllocator(const uninitializedAllocator<U>&) {}
+    template <typename U> void construct(U* p) { ::new ((void*) p) U; }
+    template <typename U, typename... argsT> void construct(U* p, argsT&&... args) {
+        ::new ((void*) p) U(std::forward<argsT>(args)...);
+    }
+};
+
+//
+// Pool of fixed size records kept in one block and linked by index
+// instead of by pointer. Released records go on a free list threaded
+// through their next field and are handed out again before the block
+// grows.
+//
+// Because links are indices, copying a pool is one copy of the block,
+// and clear() gives back the whole block at once. recordT must be
+// trivially copyable and have a next field of type indexT.
+//
+// For bulk work split across threads, resizeBlock() and copyShape()
+// size the block without touching the records, and the callers fill
+// disjoint ranges of it through copyRecords() or operator[].
+//
+template <typename recordT>
+class recordPoolClass {
+public:
+    typedef uint32_t indexT;
+    static const indexT noRecord = 0xffffffffu;
+
+private:
+    typedef std::vector<recordT, uninitializedAllocator<recordT> > blockT;
+    blockT records;
+    indexT freeList = noRecord;
+    size_t numFree = 0;
+
+public:
+    // returns a zeroed record
+    indexT allocate() {
+        if (freeList != noRecord) {
+            indexT i = freeList;
+            freeList = records[i].next;
+            --numFree;
+            records[i] = recordT();
+            return i;
+        }
+        records.push_back(recordT());
+        return (indexT) (records.size() - 1);
+    }
+    void release(indexT i) {
+        records[i].next = freeList;
+        freeList = i;
+        ++numFree;
+    }
+    // releases every record and the block
+    void clear() {
+        blockT().swap(records);
+        freeList = noRecord;
+        numFree = 0;
+    }
+    void reserve(size_t n) { records.reserve(n); }
+    // makes the block n records, all in use and left for the caller to write
+    void resizeBlock(size_t n) {
+        clear();
+        records.resize(n);
+    }
+    // sizes the block and free list like src, leaving the records to copyRecords
+    void copyShape(const recordPoolClass& src) {
+        records.clear();
+        records.resize(src.records.size());
+        freeList = src.freeList;
+        numFree = src.numFree;
+    }
+    // copies records [begin, end) of src, which copyShape was given
+    void copyRecords(const recordPoolClass& src, size_t begin, size_t end) {
+        std::copy(src.records.begin() + begin, src.records.begin() + end, records.begin() + begin);
+    }
+    // records in the block, released ones included
+    size_t blockSize() const { return records.size(); }
+    // records in use
+    size_t size() const { return records.size() - numFree; }
+    // true if allocate() takes a released record instead of growing the block
+    bool hasFree() const { return freeList != noRecord; }
+
+    recordT& operator[](indexT i) { return records[i]; }
+    const recordT& operator[](indexT i) const { return records[i]; }
+
+    friend void swap(recordPoolClass& first, recordPoolClass& second) {
+        using std::swap;
+        swap(first.records, second.records);
+        swap(first.freeList, second.freeList);
+        swap(first.numFree, second.numFree);
+    }
+};
+
+template <typename recordT>
+const typename recordPoolClass<recordT>::indexT recordPoolClass<recordT>::noRecord;
+
+#endif /* defined(__CliquePartitioning__recordpool__) */
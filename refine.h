@@ -0,0 +1,297 @@
+//
+//  refine.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__refine__
+#define __CliquePartitioning__refine__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <unordered_map>
+#include "lowerbound.h"
+#include "threadpool.h"
+#include "partition.h"
+#include "logging.h"
+#include "profile.h"
+
+//
+// Local search after the merge heuristics, which never take a merge
+// back. It starts from a clique partition of the graph and looks for
+// one with fewer cliques by moving verticies between cliques, never
+// making a set that is not a clique of the graph.
+//
+// The move that gains is emptying a clique: each of its members goes to
+// another clique all of whose members are its neighbors, the largest
+// such, and if one member has nowhere to go the moves are taken back.
+// When every member goes to the same clique this is merging the two.
+// The cliques are tried smallest first. A pass that empties none is
+// followed by a few moves of single verticies to another clique they
+// fit in, which keep the count but change what can be emptied next.
+//
+// Which cliques a vertex fits in is found by counting its neighbors in
+// each clique: a clique of k members with k of them neighbors takes it.
+// That is O(degree) for all the cliques at once, with the clique of
+// each vertex in an array; a bitset of members per clique would be
+// O(k) for each clique tried, and n bits for each clique.
+//
+// Each restart runs the search with a seed of its own on its own copy
+// of the partition, and the restarts run on a thread pool. The
+// partition with the fewest cliques wins, ties going to the lower
+// restart, so with no budget the result depends on the seed and the
+// number of restarts but not on the number of threads. A budget stops
+// each restart at the end of a pass once it has run out, and then the
+// result depends on timing too.
+//
+
+struct refineOptionsT {
+    unsigned int numThreads = 0;    // 0 for one per core
+    unsigned int numRestarts = 8;
+    uint64_t seed = 1;
+    unsigned int maxPasses = 64;    // for each restart
+    unsigned int maxIdlePasses = 8; // passes in a row that empty no clique
+    double budgetSeconds = 0;       // 0 for no budget
+};
+
+//
+// a clique partition being refined, over the verticies numbered
+// 0..n-1 of a boundGraphT
+//
+class refineStateClass {
+    const boundGraphT& b;
+    std::vector<uint32_t> cliqueOf;                 // by vertex
+    std::vector<uint32_t> position;                 // of each vertex in its clique's members
+    std::vector<std::vector<uint32_t> > members;    // by clique; emptied cliques stay, empty
+    size_t liveCliques = 0;
+    // neighbors of the vertex being placed in each clique, zeroed after
+    std::vector<uint32_t> neighborsIn;
+    std::vector<uint32_t> touched;
+
+    void move(uint32_t v, uint32_t to) {
+        std::vector<uint32_t>& from = members[cliqueOf[v]];
+        position[from.back()] = position[v];
+        from[position[v]] = from.back();
+        from.pop_back();
+        if (from.empty()) {
+            --liveCliques;
+        }
+        if (members[to].empty()) {
+            ++liveCliques;
+        }
+        cliqueOf[v] = to;
+        position[v] = (uint32_t) members[to].size();
+        members[to].push_back(v);
+        profileCount(counterRefineMoves);
+    }
+
+public:
+    explicit refineStateClass(const boundGraphT& graph) : b(graph) {}
+
+    void load(const cliquePartitionClass& cliques) {
+        cliqueOf.assign(b.numVerticies(), 0);
+        position.assign(b.numVerticies(), 0);
+        members.assign(cliques.numCliques(), std::vector<uint32_t>());
+        for (size_t c = 0; c < cliques.numCliques(); ++c) {
+            members[c].assign(cliques.cliqueBegin(c), cliques.cliqueEnd(c));
+            for (uint32_t i = 0; i < members[c].size(); ++i) {
+                cliqueOf[members[c][i]] = (uint32_t) c;
+                position[members[c][i]] = i;
+            }
+        }
+        liveCliques = cliques.numCliques();
+        neighborsIn.assign(members.size(), 0);
+    }
+
+    size_t numCliques() const { return liveCliques; }
+
+    // the cliques other than v's that v fits in, in fits
+    void cliquesFitting(uint32_t v, std::vector<uint32_t>& fits) {
+        fits.clear();
+        touched.clear();
+        uint32_t own = cliqueOf[v];
+        for (size_t i = b.start[v]; i < b.start[v + 1]; ++i) {
+            uint32_t c = cliqueOf[b.adjacency[i]];
+            if ((c != own) && (neighborsIn[c]++ == 0)) {
+                touched.push_back(c);
+            }
+        }
+        for (auto c : touched) {
+            if (neighborsIn[c] == members[c].size()) {
+                fits.push_back(c);
+            }
+            neighborsIn[c] = 0;
+        }
+    }
+
+    // moves the members of c to other cliques; false, and nothing moved, if one will not go
+    bool empty(uint32_t c, std::mt19937_64& rng) {
+        std::vector<std::pair<uint32_t, uint32_t> > moved;  // vertex, clique it came from
+        std::vector<uint32_t> fits;
+        while (!members[c].empty()) {
+            uint32_t v = members[c].back();
+            cliquesFitting(v, fits);
+            if (fits.empty()) {
+                for (auto it = moved.rbegin(); it != moved.rend(); ++it) {
+                    move(it->first, it->second);
+                }
+                return false;
+            }
+            // the largest, so the small ones are left to be emptied; ties at random
+            std::shuffle(fits.begin(), fits.end(), rng);
+            uint32_t to = *std::max_element(fits.begin(), fits.end(), [&](uint32_t x, uint32_t y) {
+                return members[x].size() < members[y].size();
+            });
+            moved.push_back(std::make_pair(v, c));
+            move(v, to);
+        }
+        return true;
+    }
+
+    // one pass trying to empty each clique, smallest first; returns how many were
+    size_t emptyPass(std::mt19937_64& rng) {
+        std::vector<uint32_t> order;
+        for (uint32_t c = 0; c < members.size(); ++c) {
+            if (!members[c].empty()) {
+                order.push_back(c);
+            }
+        }
+        std::shuffle(order.begin(), order.end(), rng);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) {
+            return members[x].size() < members[y].size();
+        });
+        size_t emptied = 0;
+        for (auto c : order) {
+            if (!members[c].empty() && empty(c, rng)) {
+                ++emptied;
+            }
+        }
+        return emptied;
+    }
+
+    // numMoves moves of single verticies to another clique they fit in
+    void perturb(size_t numMoves, std::mt19937_64& rng) {
+        std::vector<uint32_t> fits;
+        for (size_t i = 0; (i < numMoves) && (b.numVerticies() > 0); ++i) {
+            uint32_t v = (uint32_t) (rng() % b.numVerticies());
+            if (members[cliqueOf[v]].size() < 2) {
+                continue; // moving it would only empty its clique, which the passes try
+            }
+            cliquesFitting(v, fits);
+            if (!fits.empty()) {
+                move(v, fits[rng() % fits.size()]);
+            }
+        }
+    }
+
+    // the cliques, over the names already in cliques
+    void save(cliquePartitionClass& cliques) const {
+        for (const auto &m : members) {
+            if (m.empty()) {
+                continue;
+            }
+            for (auto v : m) {
+                cliques.addMember(v);
+            }
+            cliques.endClique();
+        }
+        cliques.sortCliques();
+    }
+};
+
+//
+// refines start, a clique partition of g such as the algorithms give,
+// into refined, which has no more cliques. Returns the number of
+// cliques it has fewer
+//
+template <typename graphT>
+size_t refinePartition(const graphT& g,
+                       const cliquePartitionClass& start,
+                       const refineOptionsT& options,
+                       cliquePartitionClass& refined
+                       )
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    typedef std::chrono::steady_clock clockT;
+    profileTimerClass timer("refinePartition");
+    const clockT::time_point deadline = clockT::now() +
+        std::chrono::duration_cast<clockT::duration>(std::chrono::duration<double>(options.budgetSeconds));
+    boundGraphT b;
+    boundGraph(g, b);
+    const unsigned int numRestarts = std::max(options.numRestarts, 1u);
+    std::vector<cliquePartitionClass> results(numRestarts);
+    std::vector<size_t> counts(numRestarts, 0);
+
+    threadPoolClass pool(options.numThreads);
+    pool.parallelFor(numRestarts, [&](size_t r) {
+        std::mt19937_64 rng(options.seed * 0x9e3779b97f4a7c15ull + r);
+        refineStateClass state(b);
+        state.load(start);
+        unsigned int idle = 0;
+        for (unsigned int pass = 0; (pass < options.maxPasses) && (idle < options.maxIdlePasses); ++pass) {
+            if (state.emptyPass(rng) > 0) {
+                idle = 0;
+            } else {
+                ++idle;
+                state.perturb(1 + b.numVerticies() / 64, rng);
+            }
+            if ((options.budgetSeconds > 0) && (clockT::now() >= deadline)) {
+                break;
+            }
+        }
+        // no move adds a clique, so the last state is the best
+        for (size_t m = 0; m < start.numMembers(); ++m) {
+            results[r].addName(start.memberName((cliquePartitionClass::memberT) m));
+        }
+        state.save(results[r]);
+        counts[r] = state.numCliques();
+    });
+
+    size_t best = 0;
+    for (size_t r = 1; r < numRestarts; ++r) {
+        if (counts[r] < counts[best]) {
+            best = r;
+        }
+    }
+    if (logging(logInfo)) {
+        printf("refinePartition(): %zu cliques to %zu, by restart %zu of %u\n", start.numCliques(), counts[best], best, numRestarts);
+    }
+    refined = std::move(results[best]);
+
+    if (validating()) {
+        // every member of a clique has an edge to each other member of it
+        std::vector<vertexKeyT> keys;
+        std::unordered_map<vertexKeyT, uint32_t> memberOfKey;
+        g.forEachVertex([&](const vertexKeyT& x, int) {
+            memberOfKey[x] = (uint32_t) keys.size();
+            keys.push_back(x);
+        });
+        std::vector<size_t> cliqueOf(keys.size(), 0);
+        std::vector<size_t> inPartition(keys.size(), 0);
+        for (size_t c = 0; c < refined.numCliques(); ++c) {
+            for (auto m = refined.cliqueBegin(c); m != refined.cliqueEnd(c); ++m) {
+                cliqueOf[*m] = c;
+                ++inPartition[*m];
+            }
+        }
+        for (uint32_t m = 0; m < keys.size(); ++m) {
+            size_t inClique = 0;
+            g.forEachNeighbor(keys[m], [&](const vertexKeyT& y) {
+                uint32_t n = memberOfKey.find(y)->second;
+                if ((n != m) && (cliqueOf[n] == cliqueOf[m])) {
+                    ++inClique;
+                }
+            });
+            size_t size = refined.cliqueSize(cliqueOf[m]);
+            if ((inPartition[m] != 1) || (inClique < size - 1)) {
+                printf("refinePartition(): %s is not in one clique of its neighbors\n", g.vertexName(keys[m]).c_str());
+            }
+        }
+    }
+    return start.numCliques() - refined.numCliques();
+}
+
+#endif /* defined(__CliquePartitioning__refine__) */
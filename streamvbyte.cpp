@@ -0,0 +1,104 @@
+//
+//  streamvbyte.cpp
+//  CliquePartitioning
+//
+
+#include "streamvbyte.h"
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace {
+
+// bytes taken by value x
+inline int valueLength(uint32_t x) {
+    return (x < (1u << 8)) ? 1 : (x < (1u << 16)) ? 2 : (x < (1u << 24)) ? 3 : 4;
+}
+
+inline uint32_t decodeValue(const uint8_t*& data, int length) {
+    uint32_t x = 0;
+    for (int b = 0; b < length; ++b) {
+        x |= (uint32_t) data[b] << (8 * b);
+    }
+    data += length;
+    return x;
+}
+
+#if defined(__SSSE3__)
+//
+// for each control byte, the shuffle that spreads its data bytes into
+// four 32 bit values, and the number of data bytes
+//
+struct decodeTablesT {
+    uint8_t shuffle[256][16];
+    uint8_t length[256];
+    decodeTablesT() {
+        for (int c = 0; c < 256; ++c) {
+            int at = 0;
+            for (int v = 0; v < 4; ++v) {
+                int valueBytes = ((c >> (2 * v)) & 3) + 1;
+                for (int b = 0; b < 4; ++b) {
+                    shuffle[c][4 * v + b] = (b < valueBytes) ? (uint8_t) (at + b) : 0xff;
+                }
+                at += valueBytes;
+            }
+            length[c] = (uint8_t) at;
+        }
+    }
+};
+
+const decodeTablesT& decodeTables() {
+    static const decodeTablesT tables;
+    return tables;
+}
+#endif
+
+} // namespace
+
+void streamVByteEncodeSorted(const uint32_t* in, size_t n, std::vector<uint8_t>& bytes) {
+    size_t controlAt = bytes.size();
+    bytes.resize(controlAt + (n + 3) / 4, 0);
+    uint32_t last = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t delta = in[i] - last;
+        last = in[i];
+        int length = valueLength(delta);
+        bytes[controlAt + i / 4] |= (uint8_t) ((length - 1) << (2 * (i % 4)));
+        for (int b = 0; b < length; ++b) {
+            bytes.push_back((uint8_t) (delta >> (8 * b)));
+        }
+    }
+}
+
+size_t streamVByteDecodeSorted(const uint8_t* bytes, size_t n, uint32_t* out) {
+    const uint8_t* control = bytes;
+    const uint8_t* data = bytes + (n + 3) / 4;
+    size_t i = 0;
+    uint32_t last = 0;
+#if defined(__SSSE3__)
+    const decodeTablesT& tables = decodeTables();
+    __m128i prev = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        uint8_t c = control[i / 4];
+        __m128i v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*) data),
+                                     _mm_loadu_si128((const __m128i*) tables.shuffle[c]));
+        data += tables.length[c];
+        // prefix sum of the differences, then add the last value before
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, prev);
+        _mm_storeu_si128((__m128i*) (out + i), v);
+        prev = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    if (i > 0) {
+        last = out[i - 1];
+    }
+#endif
+    // the tail, or everything without vector support
+    for (; i < n; ++i) {
+        last += decodeValue(data, ((control[i / 4] >> (2 * (i % 4))) & 3) + 1);
+        out[i] = last;
+    }
+    return (size_t) (data - bytes);
+}
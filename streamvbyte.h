@@ -0,0 +1,43 @@
+//
+//  streamvbyte.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__streamvbyte__
+#define __CliquePartitioning__streamvbyte__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//
+// Stream VByte coding of sorted lists of vertex IDs, used by
+// csrGraphClass to keep the sorted rows of its base compressed.
+//
+// Each value is the difference from the one before it, the first from 0,
+// and takes 1 to 4 bytes. The lengths of four values are packed 2 bits
+// each into a control byte, and the control bytes of a list come before
+// its data bytes:
+//
+//   control[(n + 3) / 4]   length - 1 of values 4k..4k+3, low bits first
+//   data[]                 the values, little endian, as short as they fit
+//
+// Keeping the lengths apart from the data lets a decoder take a control
+// byte, and with one shuffle spread the next 16 data bytes into four 32
+// bit values, then add up the differences with two shifts and adds. This
+// is done when the compiler targets SSSE3, and a byte at a time
+// otherwise.
+//
+// A decoder may read up to streamVBytePadding bytes past the end of a
+// list, so the buffer holding the lists must have them after the last.
+//
+
+const size_t streamVBytePadding = 16;
+
+// appends the n sorted values of in to bytes
+void streamVByteEncodeSorted(const uint32_t* in, size_t n, std::vector<uint8_t>& bytes);
+
+// decodes the n values of the list at bytes into out; returns the bytes read
+size_t streamVByteDecodeSorted(const uint8_t* bytes, size_t n, uint32_t* out);
+
+#endif /* defined(__CliquePartitioning__streamvbyte__) */
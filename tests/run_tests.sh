@@ -0,0 +1,187 @@
+#!/bin/bash
+#
+#  run_tests.sh
+#  CliquePartitioning
+#
+#  Regression tests of the CliquePartitioning program:
+#    tests/run_tests.sh [build directory]
+#  builds it from the sources with ${CXX:-c++} and compares what it
+#  prints on fixed graphs with the listings in tests/expected, printing
+#  ok or FAIL for each case and exiting 1 if any failed.
+#
+#  The expected Tseng and Bhasker cliques are those the original
+#  program gives on the same graphs, for both stores, with -components
+#  on any number of threads, and with each graph made a binary file by
+#  -convert. Among the graphs
+#  is one that lists edges twice, once each way round, which readGraph
+#  must drop. The partitions -repair gives after each file of changes
+#  are those it gave when the cases were written, each checked then to
+#  be a clique partition of the graph as changed. With -cache the
+#  cliques must be the same whether they come from the cache or not,
+#  and an entry cut short must be thrown away and made again.
+#  -portfolio 0 must pick the better of the original Tseng and Bhasker,
+#  and neither -portfolio 0 nor -portfolio 2 may depend on the number
+#  of threads. -outofcore must give the original Bhasker cliques. A
+#  -batch with a file cut short in it must fail that job alone.
+#
+
+here=$(cd "$(dirname "$0")" && pwd)
+top=$(dirname "$here")
+build=${1:-$(mktemp -d)}
+mkdir -p "$build"
+program="$build/CliquePartitioning"
+failures=0
+
+echo "building $program"
+${CXX:-c++} -std=gnu++11 -O2 -pthread -I"$top" "$top"/*.cpp "$top"/CliquePartitioning/main.cpp -o "$program" || exit 1
+
+# the listings of the output whose titles match $1, with " (CSR)" taken out of the titles
+listings() {
+    awk -v want="$1" '$0 ~ want {p = 1; sub(/ \(CSR\)/, ""); print; next} p && /^  [0-9]+\. / {print; next} {p = 0}'
+}
+
+# counter name profile: the value of a counter in a -profile file
+counter() {
+    grep -o "\"$1\":[0-9]*" "$2" | cut -d: -f2
+}
+
+# check name expected actual: compares the files and reports the case
+check() {
+    if cmp -s "$2" "$3"; then
+        echo "ok   $1"
+    else
+        echo "FAIL $1"
+        diff "$2" "$3" | head -20
+        failures=$((failures + 1))
+    fi
+}
+
+graphs="$top/CliquePartitioning/Fig4_Bhasker.txt $top/CliquePartitioning/testData01.txt
+        $top/CliquePartitioning/testData02.txt $top/CliquePartitioning/testData03.txt
+        $here/graphs/duplicate_edges.txt $here/graphs/random40.txt"
+
+# Tseng and Bhasker on the string keyed store and on the CSR store
+for graph in $graphs; do
+    name=$(basename "$graph" .txt)
+    "$program" -log error "$graph" > "$build/$name.log" 2>&1
+    listings '^(Tseng|Bhasker) Algorithm cliques are:$' < "$build/$name.log" > "$build/$name.out"
+    check "$name" "$here/expected/$name.out" "$build/$name.out"
+    listings '^(Tseng|Bhasker) Algorithm cliques \(CSR\) are:$' < "$build/$name.log" > "$build/$name.csr.out"
+    check "$name (CSR)" "$here/expected/$name.out" "$build/$name.csr.out"
+done
+
+# the same from a binary graph file made by -convert, which is mapped
+for graph in "$here/graphs/random40.txt" "$here/graphs/duplicate_edges.txt"; do
+    name=$(basename "$graph" .txt)
+    "$program" -log error -convert "$graph" "$build/$name.bin" > "$build/$name.convert.log" 2>&1
+    "$program" -log error "$build/$name.bin" > "$build/$name.bin.log" 2>&1
+    listings '^(Tseng|Bhasker) Algorithm cliques are:$' < "$build/$name.bin.log" > "$build/$name.bin.out"
+    check "$name.bin" "$here/expected/$name.out" "$build/$name.bin.out"
+    listings '^(Tseng|Bhasker) Algorithm cliques \(CSR\) are:$' < "$build/$name.bin.log" > "$build/$name.bin.csr.out"
+    check "$name.bin (CSR)" "$here/expected/$name.out" "$build/$name.bin.csr.out"
+done
+
+# the same one connected component at a time, on one thread and on several
+for threads in 1 4; do
+    "$program" -log error -components -threads $threads "$here/graphs/random40.txt" > "$build/components.$threads.log" 2>&1
+    listings '^(Tseng|Bhasker) Algorithm cliques are:$' < "$build/components.$threads.log" > "$build/components.$threads.out"
+    check "random40 -components -threads $threads" "$here/expected/random40.out" "$build/components.$threads.out"
+done
+
+# Bhasker, then the partition repaired after each file of changes
+"$program" -log error -repair "$here/graphs/random40.txt" \
+    "$here/graphs/random40_changes1.txt" "$here/graphs/random40_changes2.txt" > "$build/repair.log" 2>&1
+listings '^Bhasker Algorithm cliques( \(repaired\))? are:$' < "$build/repair.log" > "$build/repair.out"
+check "random40 -repair" "$here/expected/random40.repair.out" "$build/repair.out"
+
+# edges inserted that the graph has already, which must not count twice
+# towards linking a,b with c, as a and c have no edge
+"$program" -log error -repair "$here/graphs/path3.txt" "$here/graphs/path3_changes.txt" > "$build/path3.repair.log" 2>&1
+listings '^Bhasker Algorithm cliques( \(repaired\))? are:$' < "$build/path3.repair.log" > "$build/path3.repair.out"
+check "path3 -repair" "$here/expected/path3.repair.out" "$build/path3.repair.out"
+
+# the cliques of random40 with -cache, made and stored, then loaded, then
+# made again after every entry is cut short; the CSR store hits the
+# entries the string keyed store made, as its graph is the same
+cache="$build/cache"
+rm -rf "$cache"
+for run in made loaded truncated; do
+    if [ $run = truncated ]; then
+        for entry in "$cache"/*.clq; do
+            truncate -s -4 "$entry"
+        done
+    fi
+    "$program" -log error -cache "$cache" -profile "$build/cache.$run.json" "$here/graphs/random40.txt" \
+        > "$build/cache.$run.log" 2>&1
+    listings '^(Tseng|Bhasker) Algorithm cliques are:$' < "$build/cache.$run.log" > "$build/cache.$run.out"
+    check "random40 -cache, $run" "$here/expected/random40.out" "$build/cache.$run.out"
+    listings '^(Tseng|Bhasker) Algorithm cliques \(CSR\) are:$' < "$build/cache.$run.log" > "$build/cache.$run.csr.out"
+    check "random40 -cache, $run (CSR)" "$here/expected/random40.out" "$build/cache.$run.csr.out"
+    if [ $run = loaded ]; then
+        expected="4 0"
+    else
+        expected="2 2"
+    fi
+    hits="$(counter cacheHits "$build/cache.$run.json") $(counter cacheMisses "$build/cache.$run.json")"
+    if [ "$hits" = "$expected" ]; then
+        echo "ok   random40 -cache, $run, hits and misses $hits"
+    else
+        echo "FAIL random40 -cache, $run, hits and misses $hits, not $expected"
+        failures=$((failures + 1))
+    fi
+done
+
+# Tseng and Bhasker raced, Bhasker winning on random40 as it has fewer
+# cliques, then with two seeded variants of each, where Bhasker seed 1
+# has fewer still; the same for any number of threads, as there is no budget
+listings '^Bhasker Algorithm cliques are:$' < "$here/expected/random40.out" |
+    sed 's/^Bhasker Algorithm cliques are:$/Portfolio cliques, from Bhasker seed 0, are:/' > "$build/portfolio0.expected"
+for threads in 1 4; do
+    for variants in 0 2; do
+        "$program" -log error -threads $threads -portfolio $variants "$here/graphs/random40.txt" \
+            > "$build/portfolio$variants.$threads.log" 2>&1
+        listings '^Portfolio cliques, from .* are:$' < "$build/portfolio$variants.$threads.log" \
+            > "$build/portfolio$variants.$threads.out"
+    done
+    check "random40 -portfolio 0 -threads $threads" "$build/portfolio0.expected" "$build/portfolio0.$threads.out"
+    check "random40 -portfolio 2 -threads $threads" "$here/expected/random40.portfolio.out" "$build/portfolio2.$threads.out"
+done
+
+# Bhasker on the disk store, built from the text
+for graph in "$here/graphs/random40.txt" "$here/graphs/duplicate_edges.txt"; do
+    name=$(basename "$graph" .txt)
+    listings '^Bhasker Algorithm cliques are:$' < "$here/expected/$name.out" |
+        sed 's/^Bhasker Algorithm cliques are:$/Bhasker Algorithm cliques (out of core) are:/' > "$build/$name.outofcore.expected"
+    "$program" -log error -outofcore "$graph" "$build/$name.disk" > "$build/$name.outofcore.log" 2>&1
+    listings '^Bhasker Algorithm cliques \(out of core\) are:$' < "$build/$name.outofcore.log" > "$build/$name.outofcore.out"
+    check "$name -outofcore" "$build/$name.outofcore.expected" "$build/$name.outofcore.out"
+done
+
+# a batch of two graphs and one cut short, read by readGraph and by readGraphParallel
+rm -rf "$build/batch"
+mkdir -p "$build/batch/graphs"
+cp "$here/graphs/random40.txt" "$here/graphs/duplicate_edges.txt" "$build/batch/graphs"
+head -c 500 "$here/graphs/random40.txt" > "$build/batch/graphs/truncated.txt"
+for parse in 0 2; do
+    out="$build/batch/out$parse"
+    rm -rf "$out"
+    mkdir -p "$out"
+    "$program" -log error -parse $parse -batch "$build/batch/graphs" "$out" > "$build/batch/batch$parse.log" 2>&1
+    status=$?
+    summary=$(grep -o '[0-9]* jobs, [0-9]* failed' "$build/batch/batch$parse.log")
+    if [ $status -ne 0 ] && [ "$summary" = "3 jobs, 1 failed" ] && [ ! -e "$out/truncated.txt.cliques" ]; then
+        echo "ok   -batch -parse $parse, truncated.txt failed"
+    else
+        echo "FAIL -batch -parse $parse, exit $status, $summary"
+        failures=$((failures + 1))
+    fi
+    for name in random40 duplicate_edges; do
+        check "-batch -parse $parse, $name" "$here/expected/$name.out" "$out/$name.txt.cliques"
+    done
+done
+
+if [ $failures -ne 0 ]; then
+    echo "$failures failed"
+    exit 1
+fi
+echo "all passed"
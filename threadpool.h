@@ -0,0 +1,138 @@
+//
+//  threadpool.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__threadpool__
+#define __CliquePartitioning__threadpool__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Fixed set of worker threads for loops whose iterations are
+// independent. parallelFor(n, f) calls f(0) .. f(n-1), each once, on
+// the workers and on the calling thread, and returns when all the calls
+// are done. Chunks are handed out one at a time from a shared counter,
+// so a thread that draws cheap chunks takes more of them; cutting the
+// work into several chunks per thread keeps the threads busy to the end.
+//
+// Which thread runs a chunk is not fixed, so for a repeatable result
+// each chunk writes only its own output and the caller combines the
+// outputs in chunk order.
+//
+class threadPoolClass {
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;   // workers wait here for a job
+    std::condition_variable done;   // parallelFor waits here for the workers
+    const std::function<void(size_t)>* job = nullptr;
+    size_t numChunks = 0;
+    std::atomic<size_t> nextChunk;
+    uint64_t generation = 0;        // counts jobs, so a worker takes each once
+    size_t finishedWorkers = 0;
+    bool stopping = false;
+
+    void runChunks() {
+        for (size_t c = nextChunk.fetch_add(1); c < numChunks; c = nextChunk.fetch_add(1)) {
+            (*job)(c);
+        }
+    }
+    void workerLoop() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&]() { return stopping || (generation != seen); });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            guard.unlock();
+            runChunks();
+            guard.lock();
+            // the job stays put until every worker is through with it
+            if (++finishedWorkers == workers.size()) {
+                done.notify_one();
+            }
+        }
+    }
+
+public:
+    //
+    // numThreads counts the calling thread, so 1 makes no workers and
+    // parallelFor runs everything in place. 0 is one thread per core
+    //
+    explicit threadPoolClass(unsigned int numThreads = 0) : nextChunk(0) {
+        if (numThreads == 0) {
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned int i = 1; i < numThreads; ++i) {
+            workers.push_back(std::thread(&threadPoolClass::workerLoop, this));
+        }
+    }
+    ~threadPoolClass() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &t : workers) {
+            t.join();
+        }
+    }
+    threadPoolClass(const threadPoolClass&) = delete;
+    threadPoolClass& operator= (const threadPoolClass&) = delete;
+
+    // threads that run chunks, the caller included
+    unsigned int size() const { return (unsigned int) workers.size() + 1; }
+
+    void parallelFor(size_t n, const std::function<void(size_t)>& f) {
+        if (workers.empty() || (n <= 1)) {
+            for (size_t c = 0; c < n; ++c) {
+                f(c);
+            }
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            job = &f;
+            numChunks = n;
+            nextChunk = 0;
+            finishedWorkers = 0;
+            ++generation;
+        }
+        wake.notify_all();
+        runChunks();
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&]() { return finishedWorkers == workers.size(); });
+        job = nullptr;
+    }
+};
+
+//
+// cuts items 0..n-1 into at most numChunks runs of about equal weight,
+// where prefix[i] is the weight of the items before i (prefix has n+1
+// entries). chunkStart gets the first item of each run and then n
+//
+inline void splitByWeight(const std::vector<uint64_t>& prefix, size_t numChunks, std::vector<size_t>& chunkStart) {
+    size_t n = prefix.size() - 1;
+    uint64_t total = prefix.back();
+    chunkStart.assign(1, 0);
+    for (size_t c = 1; c < numChunks; ++c) {
+        uint64_t cut = total * c / numChunks;
+        size_t i = std::lower_bound(prefix.begin(), prefix.end(), cut) - prefix.begin();
+        if ((i > chunkStart.back()) && (i < n)) {
+            chunkStart.push_back(i);
+        }
+    }
+    chunkStart.push_back(n);
+}
+
+#endif /* defined(__CliquePartitioning__threadpool__) */
@@ -0,0 +1,402 @@
+//
+//  tsengscore.h
+//  CliquePartitioning
+//
+
+#ifndef __CliquePartitioning__tsengscore__
+#define __CliquePartitioning__tsengscore__
+
+#include <stdint.h>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <utility>
+#include "threadpool.h"
+#include "profile.h"
+
+//
+// the verticies of g in key order, and before each the number of edges
+// of the verticies ahead of it, for cutting scans of every edge into
+// chunks of about equal work
+//
+template <typename graphT>
+void verticiesWithEdgeOffsets(graphT& g,
+                              std::vector<typename graphT::vertexKeyT>& order,
+                              std::vector<uint64_t>& edgeOffset)
+{
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    order.clear();
+    edgeOffset.assign(1, 0);
+    g.forEachVertex([&](const vertexKeyT& x, int xDegree) {
+        order.push_back(x);
+        edgeOffset.push_back(edgeOffset.back() + xDegree);
+    });
+}
+
+// chunks per thread for scans of every edge; more balance the hubs better
+const size_t scanChunksPerThread = 8;
+
+//
+// seeded hash of a vertex, for the tie breaks of the seeded variants of
+// the algorithms, see cliqueRunControlT
+//
+template <typename vertexKeyT>
+uint64_t tieHash(uint64_t seed, const vertexKeyT& x) {
+    uint64_t h = seed ^ ((uint64_t) std::hash<vertexKeyT>()(x) * 0x9e3779b97f4a7c15ull);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+//
+// The weighted count of common neighbors of x and y: the sum over each
+// common neighbor c of w(x,c) + w(y,c). The edges of x are hashed once
+// by setVertex, then each weight(y) walks the edges of y, so scoring
+// every edge of x costs the edges of its neighbors, as a merge of the
+// two edge lists does for commonNeighborCount. Only reads g, so each
+// thread of a scan can have its own
+//
+template <typename graphT>
+class commonWeightClass {
+    typedef typename graphT::vertexKeyT vertexKeyT;
+    const graphT& g;
+    std::unordered_map<vertexKeyT, int> xWeight;
+
+public:
+    explicit commonWeightClass(const graphT& graph) : g(graph) {};
+    void setVertex(const vertexKeyT& x) {
+        xWeight.clear();
+        g.forEachWeightedNeighbor(x, [&](const vertexKeyT& c, int w) {
+            xWeight[c] = w;
+        });
+    }
+    int64_t weight(const vertexKeyT& y) const {
+        int64_t sum = 0;
+        profileCount(counterCommonNeighborCalls);
+        profileCount(counterIntersectionWork, g.degree(y));
+        g.forEachWeightedNeighbor(y, [&](const vertexKeyT& c, int w) {
+            auto ctr = xWeight.find(c);
+            if (ctr != xWeight.end()) {
+                sum += (int64_t) ctr->second + w;
+            }
+        });
+        return sum;
+    }
+};
+
+//
+// Incremental common neighbor scores for TsengAlgorithm.
+//
+// Every edge {a,b} of the working graph is scored once with the number
+// of common neighbors of a and b and the sum of their degrees. Scores
+// sit in buckets by common neighbor count, so the best pair is the
+// first entry of the highest bucket; empty buckets are dropped.
+//
+// Weighted, the count is the weighted one of commonWeightClass. The
+// store gives a super node edge the sum of the weights of the two edges
+// it replaces, so the weights that come and go with a merge are known
+// from the edges of si and sj, and the rescoring below stays the same.
+//
+// When si and sj merge into n, only edges near them change:
+//   - an edge {x,y} with x and y both neighbors of si or sj loses si
+//     and sj as common neighbors and gains n when both are neighbors of n
+//   - every edge of a neighbor of si or sj changes its degree sum
+// so a merge costs the edges in the 2-hop neighborhood of si and sj
+// instead of a rescan of the whole graph.
+//
+// Order within a bucket reproduces the rescan in TsengAlgorithm: larger
+// sum of degrees first, then the edge found first when scanning the
+// verticies in key order and each edge list in order. Edge list order is
+// tracked with stamps that grow as edges are appended. With a tieSeed
+// other than 0, edges of the same sum of degrees go by a seeded hash of
+// their ends first, and the rescan no longer agrees.
+//
+// Scoring every edge at the start is most of the work on a dense graph.
+// Given a thread pool, the common neighbor counts are taken in parallel
+// over chunks of verticies, each chunk writing the counts of its own
+// edges, and the scores are then filed in scan order on one thread, so
+// the buckets come out the same for any number of threads. Scoring
+// reads gPrime from several threads, through degree, forEachNeighbor,
+// forEachWeightedNeighbor and commonNeighborCount, which must not change
+// the store.
+//
+template <typename graphT>
+class tsengScoreClass {
+public:
+    typedef typename graphT::vertexKeyT vertexKeyT;
+
+private:
+    typedef std::pair<vertexKeyT, vertexKeyT> edgeKeyT;
+    struct edgeKeyHash {
+        size_t operator()(const edgeKeyT& e) const {
+            size_t h = std::hash<vertexKeyT>()(e.first);
+            return h ^ (std::hash<vertexKeyT>()(e.second) + 0x9e3779b9 + (h << 6) + (h >> 2));
+        }
+    };
+    //
+    // score of edge {a,b}; a is first of the pair in key order and
+    // stamp is the position of b in the edge list of a
+    //
+    struct scoreRecord {
+        vertexKeyT a;
+        vertexKeyT b;
+        int64_t commons;
+        int sumOfDegrees;
+        uint64_t stamp;
+        uint64_t tie;       // tieHash of the ends, 0 unless seeded
+    };
+    struct scoreLess {
+        graphT* g;
+        bool operator()(const scoreRecord& lhs, const scoreRecord& rhs) const {
+            if (lhs.sumOfDegrees != rhs.sumOfDegrees) {
+                return lhs.sumOfDegrees > rhs.sumOfDegrees;
+            }
+            if (lhs.tie != rhs.tie) {
+                return lhs.tie < rhs.tie;
+            }
+            if (!(lhs.a == rhs.a)) {
+                return g->keyLess(lhs.a, rhs.a);
+            }
+            return lhs.stamp < rhs.stamp;
+        }
+    };
+    typedef std::set<scoreRecord, scoreLess> bucketT;
+
+    // flags for the neighborhood of a merge
+    static const unsigned int nearSi = (1 << 0);
+    static const unsigned int nearSj = (1 << 1);
+    static const unsigned int nearNew = (1 << 2);
+    // a vertex near the merge and the weights of its edges to si and sj
+    struct nearT {
+        unsigned int flags = 0;
+        int siWeight = 0;
+        int sjWeight = 0;
+    };
+
+    graphT& g;
+    bool weighted;
+    uint64_t tieSeed;
+    std::unordered_map<edgeKeyT, scoreRecord, edgeKeyHash> scores;
+    // buckets[c] holds edges with c common neighbors, highest first
+    std::map<int64_t, bucketT, std::greater<int64_t> > buckets;
+    uint64_t nextStamp = 0;
+
+    static edgeKeyT edgeKey(const vertexKeyT& x, const vertexKeyT& y) {
+        return (x < y) ? edgeKeyT(x, y) : edgeKeyT(y, x);
+    }
+    bool keyLess(const vertexKeyT& x, const vertexKeyT& y) {
+        return g.keyLess(x, y);
+    }
+    // what common neighbor c adds to the score of an edge {x,y}
+    int64_t commonScore(int64_t xcWeight, int64_t ycWeight) const {
+        return weighted ? (xcWeight + ycWeight) : 1;
+    }
+    void bucketInsert(const scoreRecord& s) {
+        auto btr = buckets.find(s.commons);
+        if (btr == buckets.end()) {
+            btr = buckets.insert(std::make_pair(s.commons, bucketT(scoreLess{&g}))).first;
+        }
+        btr->second.insert(s);
+    }
+    void bucketErase(const scoreRecord& s) {
+        auto btr = buckets.find(s.commons);
+        btr->second.erase(s);
+        if (btr->second.empty()) {
+            buckets.erase(btr);
+        }
+    }
+    // scores edge x->y, appended with stamp, unless it was scored from y
+    void insertScore(const vertexKeyT& x, const vertexKeyT& y, int64_t commons, uint64_t stamp) {
+        if (!keyLess(x, y)) {
+            return;
+        }
+        scoreRecord s;
+        s.a = x;
+        s.b = y;
+        s.commons = commons;
+        s.sumOfDegrees = g.degree(x) + g.degree(y);
+        s.stamp = stamp;
+        s.tie = (tieSeed == 0) ? 0 : (tieHash(tieSeed, x) ^ tieHash(~tieSeed, y));
+        scores[edgeKey(x, y)] = s;
+        bucketInsert(s);
+    }
+    void removeScore(const vertexKeyT& x, const vertexKeyT& y) {
+        auto str = scores.find(edgeKey(x, y));
+        if (str == scores.end()) {
+            return;
+        }
+        bucketErase(str->second);
+        scores.erase(str);
+    }
+    // moves edge {x,y} to its new bucket and position
+    void updateScore(const vertexKeyT& x, const vertexKeyT& y, int64_t deltaCommons) {
+        auto str = scores.find(edgeKey(x, y));
+        if (str == scores.end()) {
+            return;
+        }
+        scoreRecord& s = str->second;
+        int newSumOfDegrees = g.degree(x) + g.degree(y);
+        if ((deltaCommons == 0) && (newSumOfDegrees == s.sumOfDegrees)) {
+            return;
+        }
+        bucketErase(s);
+        s.commons += deltaCommons;
+        s.sumOfDegrees = newSumOfDegrees;
+        bucketInsert(s);
+    }
+
+public:
+    //
+    // scores every edge of gPrime, on the threads of pool if given, by
+    // weighted common neighbors if weighted, ties broken by seed if not
+    // 0; gPrime must then only change through mergeVerticies
+    //
+    explicit tsengScoreClass(graphT& gPrime, threadPoolClass* pool = nullptr, bool weightedScores = false,
+                             uint64_t seed = 0) :
+        g(gPrime), weighted(weightedScores), tieSeed(seed) {
+        profileTimerClass timer("TsengAlgorithm scoring");
+        std::vector<vertexKeyT> order;
+        std::vector<uint64_t> edgeOffset;
+        verticiesWithEdgeOffsets(g, order, edgeOffset);
+        profileCount(counterEdgesScanned, edgeOffset.back());
+        std::vector<size_t> chunkStart;
+        splitByWeight(edgeOffset, (pool == nullptr) ? 1 : pool->size() * scanChunksPerThread, chunkStart);
+
+        // commons[k] for the k-th edge in scan order
+        std::vector<int64_t> commons(edgeOffset.back(), 0);
+        std::function<void(size_t)> countChunk = [&](size_t c) {
+            commonWeightClass<graphT> commonWeight(g);
+            for (size_t i = chunkStart[c]; i < chunkStart[c + 1]; ++i) {
+                const vertexKeyT& x = order[i];
+                uint64_t k = edgeOffset[i];
+                if (weighted) {
+                    commonWeight.setVertex(x);
+                }
+                g.forEachNeighbor(x, [&](const vertexKeyT& y) {
+                    if (keyLess(x, y)) {
+                        commons[k] = weighted ? commonWeight.weight(y) : g.commonNeighborCount(x, y);
+                    }
+                    ++k;
+                });
+            }
+        };
+        if (pool == nullptr) {
+            countChunk(0);
+        } else {
+            pool->parallelFor(chunkStart.size() - 1, countChunk);
+        }
+
+        for (size_t i = 0; i < order.size(); ++i) {
+            const vertexKeyT& x = order[i];
+            g.forEachNeighbor(x, [&](const vertexKeyT& y) {
+                uint64_t stamp = nextStamp++;
+                insertScore(x, y, commons[stamp], stamp);
+            });
+        }
+    }
+
+    //
+    // finds the two verticies with the most common neighbors. In case
+    // of tie, takes the verticies with maximum sum of degrees.
+    // returns false if there are no edges left
+    //
+    bool bestPair(vertexKeyT& si, vertexKeyT& sj, int64_t& mostCommons) {
+        if (buckets.empty()) {
+            return false;
+        }
+        const scoreRecord& s = *buckets.begin()->second.begin();
+        si = s.a;
+        sj = s.b;
+        mostCommons = s.commons;
+        return true;
+    }
+
+    //
+    // merges si and sj in the graph and rescores the edges around them
+    //
+    vertexKeyT mergeVerticies(vertexKeyT si, vertexKeyT sj) {
+        std::unordered_map<vertexKeyT, nearT> near;
+        g.forEachWeightedNeighbor(si, [&](const vertexKeyT& y, int w) {
+            near[y].flags |= nearSi;
+            near[y].siWeight = w;
+        });
+        g.forEachWeightedNeighbor(sj, [&](const vertexKeyT& y, int w) {
+            near[y].flags |= nearSj;
+            near[y].sjWeight = w;
+        });
+        near.erase(si);
+        near.erase(sj);
+        // the edges of si and sj go away with them
+        g.forEachNeighbor(si, [&](const vertexKeyT& y) {
+            removeScore(si, y);
+        });
+        g.forEachNeighbor(sj, [&](const vertexKeyT& y) {
+            removeScore(sj, y);
+        });
+
+        vertexKeyT n = g.mergeVerticies(si, sj);
+
+        // mergeVerticies appended n->c then c->n for each common neighbor
+        // c, weighted w(si,c) + w(sj,c)
+        std::vector<std::pair<vertexKeyT, uint64_t> > newEdges;
+        g.forEachNeighbor(n, [&](const vertexKeyT& c) {
+            near[c].flags |= nearNew;
+            newEdges.push_back(std::make_pair(c, nextStamp));
+            nextStamp += 2;
+        });
+        // rescore the edges of the neighborhood
+        uint64_t scanned = 0;
+        for (const auto &ntr : near) {
+            const vertexKeyT& x = ntr.first;
+            const nearT& xNear = ntr.second;
+            scanned += g.degree(x);
+            g.forEachNeighbor(x, [&](const vertexKeyT& y) {
+                if (y == n) {
+                    return;
+                }
+                int64_t deltaCommons = 0;
+                auto ytr = near.find(y);
+                if (ytr != near.end()) {
+                    if (!(x < y)) {
+                        return; // done from y
+                    }
+                    const nearT& yNear = ytr->second;
+                    unsigned int both = xNear.flags & yNear.flags;
+                    if (both & nearNew) {
+                        deltaCommons += commonScore((int64_t) xNear.siWeight + xNear.sjWeight, (int64_t) yNear.siWeight + yNear.sjWeight);
+                    }
+                    if (both & nearSi) {
+                        deltaCommons -= commonScore(xNear.siWeight, yNear.siWeight);
+                    }
+                    if (both & nearSj) {
+                        deltaCommons -= commonScore(xNear.sjWeight, yNear.sjWeight);
+                    }
+                }
+                updateScore(x, y, deltaCommons);
+            });
+        }
+        // score the edges of the super node
+        for (const auto &etr : newEdges) {
+            const vertexKeyT& c = etr.first;
+            int64_t commons = 0;
+            scanned += g.degree(c);
+            g.forEachWeightedNeighbor(c, [&](const vertexKeyT& y, int w) {
+                auto ytr = near.find(y);
+                if ((ytr != near.end()) && (ytr->second.flags & nearNew)) {
+                    commons += commonScore(w, (int64_t) ytr->second.siWeight + ytr->second.sjWeight);
+                }
+            });
+            insertScore(n, c, commons, etr.second);
+            insertScore(c, n, commons, etr.second + 1);
+        }
+        profileCount(counterEdgesScanned, scanned);
+        return n;
+    }
+};
+
+#endif /* defined(__CliquePartitioning__tsengscore__) */